@@ -0,0 +1,1220 @@
+/**
+ * @file benchmark.cpp
+ * @brief Host-native benchmark of ArduinoSMBus against a simulated battery.
+ * @version 1.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ * Build and run with `pio run -e native -t exec`. Bus time is simulated, so the
+ * reads/sec figures reflect the latency model rather than the speed of the host.
+ * The correctness checks live in test/ and run with `pio test -e native`.
+ */
+
+#ifndef PIO_UNIT_TESTING
+
+#include <stdio.h>
+#include <string.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include <Arduino.h>
+#include <Wire.h>
+#include "ArduinoSMBus.h"
+#include "BatteryBus.h"
+#include "BatteryPoller.h"
+#include "ChangeDetector.h"
+#include "RateGroupScheduler.h"
+#include "SMBusGauge.h"
+#include "SMBusHostListener.h"
+#include "SimBattery.h"
+#include "SnapshotStream.h"
+#include "TelemetryLog.h"
+
+#define BATTERY_ADDRESS 0x0B
+
+static void printRate(const char* label, uint32_t reads, uint64_t ns) {
+  double seconds = ns / 1e9;
+  printf("  %-44s %8.1f reads/s  (%7.1f us/read)\n", label, reads / seconds, ns / 1e3 / reads);
+}
+
+/**
+ * @brief Measure word read throughput for a few bus configurations.
+ */
+static void benchWordReads(ArduinoSMBus& battery, SimBattery& sim) {
+  static const uint32_t clocks[] = {100000, 400000};
+  static const uint32_t turnarounds[] = {0, 1000};
+  const uint32_t reads = 200;
+
+  printf("Word reads (voltage()):\n");
+  for (uint32_t clock : clocks) {
+    for (uint32_t turnaround : turnarounds) {
+      SimBus::instance().setClock(clock);
+      sim.setTurnaroundMicros(turnaround);
+      battery.setTurnaround(0);
+      battery.setAdaptiveTurnaround(true);
+      for (uint32_t i = 0; i < reads; i++) {
+        battery.voltage(); // Let the turnaround settle
+      }
+
+      uint64_t start = simNanos();
+      for (uint32_t i = 0; i < reads; i++) {
+        battery.voltage();
+      }
+      uint64_t elapsed = simNanos() - start;
+
+      char label[64];
+      snprintf(label, sizeof(label), "%3u kHz, %4u us turnaround", clock / 1000, turnaround);
+      printRate(label, reads, elapsed);
+    }
+  }
+  SimBus::instance().setClock(100000);
+  sim.setTurnaroundMicros(0);
+}
+
+/**
+ * @brief Compare the old fixed 10 ms turnaround against adaptive turnaround
+ * for a gauge that needs about 1.2 ms to prepare its data and NACKs instead
+ * of clock stretching.
+ */
+static void benchTurnaround(ArduinoSMBus& battery, SimBattery& sim) {
+  const uint32_t reads = 500;
+  sim.setTurnaroundMicros(1200);
+  sim.setClockStretching(false);
+
+  printf("Turnaround, gauge needs 1200 us:\n");
+
+  battery.setTurnaround(SMBUS_TURNAROUND_MAX_US);
+  uint64_t start = simNanos();
+  for (uint32_t i = 0; i < reads; i++) {
+    battery.voltage();
+  }
+  printRate("fixed 10000 us", reads, simNanos() - start);
+
+  battery.setTurnaround(0);
+  battery.setAdaptiveTurnaround(true);
+  start = simNanos();
+  for (uint32_t i = 0; i < reads; i++) {
+    battery.voltage();
+  }
+  printRate("adaptive from 0 us", reads, simNanos() - start);
+  printf("  learned turnaround: %u us\n", battery.turnaround());
+
+  battery.setTurnaround(0);
+  battery.setAdaptiveTurnaround(true);
+  sim.setTurnaroundMicros(0);
+  sim.setClockStretching(true);
+}
+
+/**
+ * @brief Repeat the turnaround and fault cases with Wire behaving as on arduino-esp32, where
+ * a write ended without a STOP is only sent by the requestFrom() that follows it.
+ */
+static void benchDeferredWrites(ArduinoSMBus& battery, SimBattery& sim) {
+  const uint32_t reads = 200;
+  printf("Word reads with arduino-esp32 repeated STARTs:\n");
+  Wire.setDeferredWrites(true);
+  battery.setDeferredRepeatedStart(true);
+  battery.setTurnaround(0);
+  battery.setAdaptiveTurnaround(true);
+
+  sim.setTurnaroundMicros(1000);
+  uint64_t start = simNanos();
+  for (uint32_t i = 0; i < reads; i++) {
+    battery.voltage();
+  }
+  printRate("clock stretched, 1000 us", reads, simNanos() - start);
+
+  sim.setClockStretching(false);
+  sim.setTurnaroundMicros(1200);
+  start = simNanos();
+  for (uint32_t i = 0; i < reads; i++) {
+    battery.voltage();
+  }
+  printRate("NACKs until ready, 1200 us", reads, simNanos() - start);
+  printf("  learned turnaround: %u us\n", battery.turnaround());
+  sim.setClockStretching(true);
+  sim.setTurnaroundMicros(0);
+
+  // Absent packs are only seen as an empty read; the read must not wait out a turnaround
+  battery.setTurnaround(0);
+  battery.setAdaptiveTurnaround(true);
+  sim.detach();
+  start = simNanos();
+  battery.readWord(VOLTAGE);
+  uint64_t elapsed = simNanos() - start;
+  sim.attach();
+  printf("  absent battery, %u retries: read fails after %.0f us\n", SMBUS_DEFAULT_RETRIES, elapsed / 1e3);
+  Wire.setDeferredWrites(false);
+  battery.setDeferredRepeatedStart(false);
+}
+
+/**
+ * @brief Word read as a command write with STOP followed by separate read transactions,
+ * the way readRegister() used to do it. Split transactions cannot be clock stretched, so
+ * instead of the old fixed delay the read is retried until the gauge answers.
+ */
+static bool splitReadWord(uint8_t reg, uint16_t& value) {
+  Wire.beginTransmission(BATTERY_ADDRESS);
+  Wire.write(reg);
+  if (Wire.endTransmission() != 0) {
+    return false;
+  }
+  for (uint8_t attempt = 0; attempt < 100; attempt++) {
+    if (Wire.requestFrom(BATTERY_ADDRESS, 2) >= 2) {
+      uint8_t low = Wire.read();
+      uint8_t high = Wire.read();
+      value = low | (high << 8);
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * @brief Compare split STOP/START word reads against repeated-start combined transactions.
+ */
+static void benchRepeatedStart(ArduinoSMBus& battery, SimBattery& sim) {
+  static const uint32_t turnarounds[] = {0, 500};
+  const uint32_t reads = 1000;
+
+  printf("Word reads, split vs repeated START (100 kHz):\n");
+  for (uint32_t turnaround : turnarounds) {
+    sim.setTurnaroundMicros(turnaround);
+
+    uint64_t start = simNanos();
+    for (uint32_t i = 0; i < reads; i++) {
+      uint16_t value = 0;
+      splitReadWord(VOLTAGE, value);
+    }
+    char label[64];
+    snprintf(label, sizeof(label), "split, %3u us turnaround", turnaround);
+    printRate(label, reads, simNanos() - start);
+
+    battery.setTurnaround(0);
+    battery.setAdaptiveTurnaround(true);
+    start = simNanos();
+    for (uint32_t i = 0; i < reads; i++) {
+      battery.voltage();
+    }
+    snprintf(label, sizeof(label), "repeated START, %3u us turnaround", turnaround);
+    printRate(label, reads, simNanos() - start);
+  }
+  sim.setTurnaroundMicros(0);
+}
+
+/**
+ * @brief Compare a snapshot read against the same registers read one getter at a time.
+ */
+static void benchSnapshot(ArduinoSMBus& battery, SimBattery& sim) {
+  const uint32_t passes = 100;
+  BatterySnapshot snapshot;
+
+  printf("Snapshot of all dynamic registers (300 us gauge turnaround):\n");
+  sim.setTurnaroundMicros(300);
+
+  uint64_t start = simNanos();
+  for (uint32_t i = 0; i < passes; i++) {
+    battery.batteryStatus();
+    battery.voltage();
+    battery.current();
+    battery.averageCurrent();
+    battery.temperature();
+    battery.relativeStateOfCharge();
+    battery.absoluteStateOfCharge();
+    battery.remainingCapacity();
+    battery.fullCapacity();
+    battery.runTimeToEmpty();
+    battery.avgTimeToEmpty();
+    battery.avgTimeToFull();
+    battery.chargingCurrent();
+    battery.chargingVoltage();
+    battery.maxError();
+  }
+  printRate("individual getters, 15 registers", passes * 15, simNanos() - start);
+
+  start = simNanos();
+  for (uint32_t i = 0; i < passes; i++) {
+    battery.readSnapshot(snapshot);
+  }
+  printRate("readSnapshot(), 15 registers", passes * 15, simNanos() - start);
+  printf("  one snapshot takes %u us\n", (unsigned)snapshot.duration);
+  sim.setTurnaroundMicros(0);
+}
+
+/**
+ * @brief Poll identity and design registers with and without the cache.
+ */
+static void benchCache(ArduinoSMBus& battery) {
+  const uint32_t passes = 100;
+
+  printf("Static registers, 7 per pass:\n");
+  for (int cached = 0; cached < 2; cached++) {
+    battery.enableCache(cached);
+    battery.resetCacheStats();
+    SimBus::instance().resetStats();
+    uint64_t start = simNanos();
+    for (uint32_t i = 0; i < passes; i++) {
+      battery.designCapacity();
+      battery.designVoltage();
+      battery.serialNumber();
+      battery.manufactureYear();
+      battery.manufacturerName();
+      battery.deviceName();
+      battery.deviceChemistry();
+    }
+    uint64_t elapsed = simNanos() - start;
+    printf("  %-44s %8.1f us/pass, %u bus transactions, %u hits, %u misses\n",
+           cached ? "cache enabled" : "cache disabled", elapsed / 1e3 / passes,
+           SimBus::instance().stats().transactions, battery.cacheHits(), battery.cacheMisses());
+  }
+  battery.invalidateCache();
+  battery.enableCache(false);
+}
+
+struct AsyncResult {
+  uint32_t completed;
+  uint32_t failed;
+  uint16_t lastValue;
+};
+
+static void onAsyncRead(uint8_t reg, uint16_t value, bool ok, void* context) {
+  (void)reg;
+  AsyncResult* result = static_cast<AsyncResult*>(context);
+  result->completed++;
+  result->failed += ok ? 0 : 1;
+  result->lastValue = value;
+}
+
+/**
+ * @brief Drive non-blocking reads from a simulated loop() that does 100 us of other work
+ * per iteration, and report how long a single poll() call holds the loop.
+ */
+static void benchAsync(ArduinoSMBus& battery, SimBattery& sim) {
+  const uint32_t reads = 200;
+  AsyncResult result = {0, 0, 0};
+
+  printf("Non-blocking reads, gauge needs 2000 us, loop does 100 us of work:\n");
+  sim.setTurnaroundMicros(2000);
+
+  uint64_t longestPoll = 0;
+  uint32_t polls = 0;
+  uint32_t queued = 0;
+  uint64_t start = simNanos();
+  while (result.completed < reads) {
+    if (queued < reads && battery.beginRead(VOLTAGE, onAsyncRead, &result)) {
+      queued++;
+    }
+    uint64_t before = simNanos();
+    battery.poll();
+    uint64_t spent = simNanos() - before;
+    longestPoll = spent > longestPoll ? spent : longestPoll;
+    polls++;
+    delayMicroseconds(100);
+  }
+  uint64_t elapsed = simNanos() - start;
+  printRate("beginRead()/poll()", reads, elapsed);
+  printf("  %u poll() calls, longest %.1f us, learned split turnaround %u us\n", polls, longestPoll / 1e3,
+         battery.splitTurnaround());
+  sim.setTurnaroundMicros(0);
+}
+
+/**
+ * @brief Keep a low priority name read queued while status reads arrive every 100 ms, once
+ * with every read at the same priority and once with the status reads urgent.
+ */
+static void benchPriorities(ArduinoSMBus& battery, SimBattery& sim) {
+  const uint32_t turnaround = 10000;
+  const uint32_t statusReads = 30;
+  printf("Status reads behind name reads, gauge needs %u us:\n", turnaround);
+  sim.setTurnaroundMicros(turnaround);
+  battery.setTurnaround(turnaround);
+
+  for (int urgent = 0; urgent < 2; urgent++) {
+    SMBusPriority namePriority = urgent ? SMBUS_PRIORITY_LOW : SMBUS_PRIORITY_NORMAL;
+    SMBusPriority statusPriority = urgent ? SMBUS_PRIORITY_URGENT : SMBUS_PRIORITY_NORMAL;
+    AsyncResult names = {0, 0, 0};
+    AsyncResult status = {0, 0, 0};
+    uint32_t namesQueued = 0;
+    uint32_t statusQueued = 0;
+    char name[21];
+    battery.resetLatency();
+
+    unsigned long next = micros();
+    while (status.completed < statusReads) {
+      if (names.completed == namesQueued &&
+          battery.beginReadBlock(DEVICE_NAME, reinterpret_cast<uint8_t*>(name), sizeof(name) - 1, onAsyncRead,
+                                 &names, namePriority)) {
+        namesQueued++;
+      }
+      if (statusQueued < statusReads && (long)(micros() - next) >= 0 &&
+          battery.beginRead(BATTERY_STATUS, onAsyncRead, &status, statusPriority)) {
+        statusQueued++;
+        next += 100000;
+      }
+      battery.poll();
+      delayMicroseconds(100);
+    }
+    while (battery.poll()) {
+      delayMicroseconds(100);
+    }
+
+    printf("  %-22s worst status latency %6.1f ms, %u name reads, %u preemptions\n",
+           urgent ? "urgent status reads:" : "one priority:", battery.worstLatency(statusPriority) / 1e3,
+           names.completed, battery.preemptions());
+  }
+
+  sim.setTurnaroundMicros(0);
+  battery.setTurnaround(0);
+  battery.setAdaptiveTurnaround(true);
+}
+
+/**
+ * @brief Hammer a SnapshotPublisher with one writer and several readers, and time both sides.
+ */
+static void stressPublisher() {
+  const uint32_t publications = 2000000;
+  const int readers = 3;
+  SnapshotPublisher<BatterySnapshot> publisher;
+  std::atomic<bool> done(false);
+  std::atomic<uint64_t> reads(0);
+  std::atomic<uint64_t> readNanos(0);
+
+  printf("Seqlock publication, 1 writer, %d readers:\n", readers);
+
+  std::vector<std::thread> threads;
+  for (int r = 0; r < readers; r++) {
+    threads.emplace_back([&]() {
+      uint64_t count = 0;
+      auto start = std::chrono::steady_clock::now();
+      BatterySnapshot snapshot;
+      while (!done.load(std::memory_order_relaxed)) {
+        publisher.read(snapshot);
+        count++;
+      }
+      auto elapsed = std::chrono::steady_clock::now() - start;
+      reads += count;
+      readNanos += std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+    });
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  BatterySnapshot snapshot;
+  memset(&snapshot, 0, sizeof(snapshot));
+  for (uint32_t n = 1; n <= publications; n++) {
+    snapshot.voltage = n & 0xffff;
+    snapshot.timestamp = n;
+    publisher.publish(snapshot);
+  }
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  done = true;
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  double writeNs = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count() / (double)publications;
+  printf("  %u publications, %.1f ns each; %llu reads, %.1f ns each\n", publications, writeNs,
+         (unsigned long long)reads.load(), readNanos.load() / (double)(reads.load() ? reads.load() : 1));
+}
+
+/**
+ * @brief Time how long a read takes to fail or recover with an absent battery and a stuck bus.
+ */
+static void benchFaults(ArduinoSMBus& battery, SimBattery& sim) {
+  SimBus& bus = SimBus::instance();
+
+  printf("Fault handling:\n");
+  battery.setTurnaround(0);
+  battery.setAdaptiveTurnaround(true);
+  sim.detach();
+  uint64_t start = simNanos();
+  battery.readWord(CURRENT);
+  uint64_t elapsed = simNanos() - start;
+  printf("  absent battery, %u retries: read fails after %.0f us\n", SMBUS_DEFAULT_RETRIES, elapsed / 1e3);
+  sim.attach();
+
+  // A target holding SDA low is released by clocking SCL
+  bus.injectFault(SIM_FAULT_STUCK_SDA, 5);
+  start = simNanos();
+  battery.readWord(VOLTAGE);
+  elapsed = simNanos() - start;
+  printf("  SDA stuck low, with recovery: 1 timeout, read completes after %.1f ms\n", elapsed / 1e6);
+
+  battery.setBusPins(-1, -1);
+  bus.injectFault(SIM_FAULT_STUCK_SDA, 5);
+  start = simNanos();
+  for (int i = 0; i < 10; i++) {
+    battery.readWord(VOLTAGE);
+  }
+  elapsed = simNanos() - start;
+  printf("  SDA stuck low, no recovery: 10 reads fail after %.1f ms\n", elapsed / 1e6);
+  battery.setBusPins(SDA, SCL);
+  battery.recoverBus();
+
+  bus.clearFaults();
+  battery.setAdaptiveTurnaround(true);
+}
+
+/**
+ * @brief Reference PEC, one bit at a time.
+ */
+static uint8_t pecBitwise(uint8_t crc, uint8_t data) {
+  crc ^= data;
+  for (int bit = 0; bit < 8; bit++) {
+    crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+  }
+  return crc;
+}
+
+/**
+ * @brief Host time per byte of a PEC implementation.
+ */
+static double pecNanosPerByte(uint8_t (*update)(uint8_t, uint8_t)) {
+  const uint32_t bytes = 20000000;
+  volatile uint8_t sink;
+  uint8_t crc = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < bytes; i++) {
+    crc = update(crc, (uint8_t)i);
+  }
+  sink = crc;
+  (void)sink;
+  return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / bytes;
+}
+
+/**
+ * @brief Time both PEC tables against a bitwise CRC-8, then word reads with and without PEC.
+ */
+static void benchPEC(ArduinoSMBus& battery, SimBattery& sim) {
+  SimBus& bus = SimBus::instance();
+
+  printf("PEC (CRC-8) per byte, host CPU:\n");
+  double table = pecNanosPerByte(smbusPecByteTable);
+  double nibble = pecNanosPerByte(smbusPecByteNibble);
+  double wire = 9e9 / bus.clock();
+  printf("  256-byte table %.2f ns, 16-byte table %.2f ns, bit-by-bit %.2f ns; one byte on a 100 kHz bus is %.0f ns\n",
+         table, nibble, pecNanosPerByte(pecBitwise), wire);
+
+  printf("Word reads with PEC:\n");
+  const uint32_t reads = 1000;
+  battery.setTurnaround(0);
+  for (int pec = 0; pec <= 1; pec++) {
+    sim.setPEC(pec);
+    battery.enablePEC(pec);
+    uint64_t start = simNanos();
+    for (uint32_t i = 0; i < reads; i++) {
+      battery.voltage();
+    }
+    printRate(pec ? "PEC enabled" : "PEC disabled", reads, simNanos() - start);
+  }
+  battery.enablePEC(false);
+  sim.setPEC(false);
+  battery.setAdaptiveTurnaround(true);
+}
+
+/**
+ * @brief Time a batch of register writes verified in one read-back pass.
+ */
+static void benchWrites(ArduinoSMBus& battery, SimBattery& sim) {
+  uint16_t mode = sim.word(BATTERY_MODE);
+  uint16_t capacityAlarm = sim.word(REMAINING_CAPACITY_ALARM);
+  uint16_t timeAlarm = sim.word(REMAINING_TIME_ALARM);
+  battery.setTurnaround(0);
+
+  printf("Register writes:\n");
+  BatteryMode newMode(mode & ~BATTERY_MODE_ALARM_MODE);
+  SMBusWordWrite batch[] = {
+    {REMAINING_CAPACITY_ALARM, 330, 0xffff, SMBUS_OK},
+    {REMAINING_TIME_ALARM, 15, 0xffff, SMBUS_OK},
+    {BATTERY_MODE, newMode.raw, BATTERY_MODE_WRITABLE, SMBUS_OK},
+  };
+  uint64_t start = simNanos();
+  battery.writeRegisters(batch, 3);
+  uint64_t elapsed = simNanos() - start;
+  printf("  3 writes verified in one read-back pass: %.0f us\n", elapsed / 1e3);
+
+  sim.setWord(BATTERY_MODE, mode);
+  sim.setWord(REMAINING_CAPACITY_ALARM, capacityAlarm);
+  sim.setWord(REMAINING_TIME_ALARM, timeAlarm);
+}
+
+struct AlarmLog {
+  uint32_t alarms;
+  uint8_t battery;
+  BatteryStatus status;
+  uint64_t nanos;
+};
+
+static void onAlarm(uint8_t battery, BatteryStatus status, void* context) {
+  AlarmLog* log = static_cast<AlarmLog*>(context);
+  log->alarms++;
+  log->battery = battery;
+  log->status = status;
+  log->nanos = simNanos();
+}
+
+/**
+ * @brief Receive an AlarmWarning broadcast from the simulated pack on Wire1, and compare the
+ * alarm latency with polling BatteryStatus.
+ */
+static void benchAlarms(ArduinoSMBus& battery, SimBattery& sim) {
+  uint16_t mode = sim.word(BATTERY_MODE);
+  uint16_t status = sim.word(BATTERY_STATUS);
+  AlarmLog log = AlarmLog();
+
+  SMBusHostListener listener(Wire1);
+  listener.onAlarm(onAlarm, &log);
+  listener.begin();
+
+  printf("Alarm broadcasts:\n");
+  sim.setWord(BATTERY_MODE, mode & ~(BATTERY_MODE_ALARM_MODE | BATTERY_MODE_CHARGER_MODE));
+  uint64_t start = simNanos();
+  sim.raiseAlarm(BATTERY_STATUS_OVER_TEMP_ALARM);
+  listener.poll();
+  double eventUs = (log.nanos - start) / 1e3;
+
+  // Polling BatteryStatus detects an alarm half a period late on average
+  const uint32_t reads = 100;
+  battery.setTurnaround(0);
+  start = simNanos();
+  for (uint32_t i = 0; i < reads; i++) {
+    battery.batteryStatus();
+  }
+  double readUs = (simNanos() - start) / 1e3 / reads;
+  printf("  AlarmWarning reaches the callback %.0f us after the alarm is set, using no polling\n", eventUs);
+  for (uint32_t hz = 1; hz <= 100; hz *= 10) {
+    printf("  polling BatteryStatus at %3u Hz: alarm seen %6.1f ms late on average, %5.2f%% of the bus\n", (unsigned)hz,
+           500.0 / hz, readUs * hz / 1e4);
+  }
+  listener.end();
+
+  sim.setWord(BATTERY_MODE, mode);
+  sim.setWord(BATTERY_STATUS, status);
+}
+
+/**
+ * @brief Read cell voltages and TI status blocks through SMBusGauge, and compare the bus
+ * time of one block read with a word read per cell.
+ */
+static void benchGauge(ArduinoSMBus& battery, SimBattery& sim) {
+  battery.setTurnaround(0);
+  SMBusGauge gauge(battery, GAUGE_TI_BQ40Z50);
+
+  printf("Cell voltages:\n");
+  uint16_t voltages[GAUGE_MAX_CELLS];
+  const uint32_t reads = 100;
+  uint64_t start = simNanos();
+  for (uint32_t i = 0; i < reads; i++) {
+    for (uint8_t cell = 0; cell < GAUGE_MAX_CELLS; cell++) {
+      voltages[cell] = battery.readWord(TI_CELL_VOLTAGE_1 - cell).value;
+    }
+  }
+  uint64_t wordNanos = simNanos() - start;
+
+  start = simNanos();
+  for (uint32_t i = 0; i < reads; i++) {
+    gauge.readCellVoltages(voltages);
+  }
+  uint64_t voltageNanos = simNanos() - start;
+
+  GaugeCellStatus cells;
+  start = simNanos();
+  for (uint32_t i = 0; i < reads; i++) {
+    gauge.readCellStatus(cells);
+  }
+  uint64_t blockNanos = simNanos() - start;
+
+  // A sealed gauge NACKs the aliases, and ManufacturerBlockAccess takes over
+  sim.setSealed(true);
+  start = simNanos();
+  for (uint32_t i = 0; i < reads; i++) {
+    gauge.readCellStatus(cells);
+  }
+  uint64_t macNanos = simNanos() - start;
+  sim.setSealed(false);
+  battery.setTurnaround(0);
+
+  printRate("4 cells, one word read each", reads, wordNanos);
+  printRate("4 cells, first 8 bytes of DAStatus1", reads, voltageNanos);
+  printRate("whole 32-byte DAStatus1 block", reads, blockNanos);
+  printRate("whole block when sealed, through MAC", reads, macNanos);
+}
+
+/**
+ * @brief Back up and restore the simulated gauge's data flash through SMBusGauge, and compare
+ * pipelined paging with addressing every page and sleeping 10 ms before reading it.
+ */
+static void benchDataFlash(ArduinoSMBus& battery) {
+  SimBus& bus = SimBus::instance();
+  SMBusGauge gauge(battery, GAUGE_TI_BQ40Z50);
+  battery.setTurnaround(0);
+  static uint8_t backup[SIM_DATA_FLASH_SIZE];
+  static uint8_t config[SIM_DATA_FLASH_SIZE];
+  const uint16_t pages = SIM_DATA_FLASH_SIZE / GAUGE_DF_PAGE;
+
+  printf("Data flash, %u pages of %u bytes:\n", (unsigned)pages, (unsigned)GAUGE_DF_PAGE);
+  uint64_t start = simNanos();
+  gauge.readDataFlash(SIM_DATA_FLASH, backup, sizeof(backup));
+  uint64_t pipelined = simNanos() - start;
+
+  // What a blocking readBlock() per page with a 10 ms sleep costs
+  uint8_t page[2 + GAUGE_DF_PAGE];
+  start = simNanos();
+  for (uint16_t i = 0; i < pages; i++) {
+    gauge.macCommand(SIM_DATA_FLASH + i * GAUGE_DF_PAGE);
+    delay(10);
+    battery.readBlock(MANUFACTURER_BLOCK_ACCESS, page, sizeof(page));
+  }
+  uint64_t blocking = simNanos() - start;
+  printf("  full backup, pipelined: %7.1f ms\n", pipelined / 1e6);
+  printf("  full backup, address + delay(10) + read per page: %7.1f ms\n", blocking / 1e6);
+
+  // Change a few bytes in two pages; only those pages are written
+  memcpy(config, backup, sizeof(config));
+  config[0x105] ^= 0x01;
+  config[0x107] ^= 0x80;
+  config[0x1f00] ^= 0xff;
+  config[0x1f1f] ^= 0xff;
+  bus.resetStats();
+  start = simNanos();
+  gauge.writeDataFlash(SIM_DATA_FLASH, config, sizeof(config));
+  uint64_t diffWrite = simNanos() - start;
+  printf("  restore with 2 changed pages, read and compared in one pass: %7.1f ms, %lu transactions\n",
+         diffWrite / 1e6, (unsigned long)bus.stats().transactions);
+  gauge.writeDataFlash(SIM_DATA_FLASH, backup, sizeof(backup), config);
+}
+
+/**
+ * @brief Report the size of a three hour TelemetryLog, then time appends while several
+ * threads iterate it.
+ */
+static void benchTelemetryLog() {
+  printf("Telemetry log:\n");
+  static TelemetryLog<3 * 3600> hours;
+  printf("  3 hours at 1 Hz: %lu bytes\n", (unsigned long)sizeof(hours));
+
+  const uint32_t appends = 2000000;
+  const int readers = 3;
+  std::atomic<bool> done(false);
+  std::atomic<uint64_t> records(0);
+  std::atomic<uint64_t> skipped(0);
+  std::vector<std::thread> threads;
+  for (int r = 0; r < readers; r++) {
+    threads.emplace_back([&]() {
+      uint64_t seen = 0;
+      uint64_t lost = 0;
+      while (!done.load(std::memory_order_relaxed)) {
+        auto it = hours.begin();
+        auto end = hours.end();
+        for (; it != end; ++it) {
+          seen++;
+        }
+        lost += it.skipped();
+      }
+      records += seen;
+      skipped += lost;
+    });
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  for (uint32_t n = 1; n <= appends; n++) {
+    hours.append(n * 1000, n & 0xffff, (int16_t)(n & 0xffff), 2982, 50, n & 0x03ff);
+  }
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  done = true;
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+  printf("  append with %d readers iterating: %7.1f ns/record\n", readers, (double)ns / appends);
+  printf("  records read: %llu, skipped when lapped: %llu\n", (unsigned long long)records.load(),
+         (unsigned long long)skipped.load());
+}
+
+/**
+ * @brief Print that appends to a vector, or only counts the bytes when given none.
+ */
+class BufferPrint : public Print {
+public:
+  BufferPrint(std::vector<uint8_t>* bytes = nullptr) : _bytes(bytes), count(0) {}
+  size_t write(uint8_t c) override {
+    if (_bytes != nullptr) {
+      _bytes->push_back(c);
+    }
+    count++;
+    return 1;
+  }
+  using Print::write;
+
+private:
+  std::vector<uint8_t>* _bytes;
+
+public:
+  size_t count;
+};
+
+/**
+ * @brief Fill snapshots with a slowly discharging pack polled once a second.
+ */
+static void makeDischarge(std::vector<BatterySnapshot>& snapshots, size_t count) {
+  uint32_t seed = 12345;
+  BatterySnapshot snapshot;
+  memset(&snapshot, 0, sizeof(snapshot));
+  snapshot.valid = SNAPSHOT_ALL;
+  snapshot.timestamp = 5000;
+  snapshot.battery_status = 0x00c0;
+  snapshot.voltage = 16400;
+  snapshot.temperature = 2982;
+  snapshot.relative_state_of_charge = 100;
+  snapshot.full_capacity = 5800;
+  snapshot.charging_voltage = 16800;
+  for (size_t i = 0; i < count; i++) {
+    seed = seed * 1103515245 + 12345;
+    int noise = (int)((seed >> 16) % 41) - 20;
+    snapshot.timestamp += 1000 + noise / 4;
+    snapshot.current = -1250 + noise;
+    snapshot.average_current = -1240 + noise / 8;
+    snapshot.voltage -= (i % 9 == 0);
+    snapshot.temperature += (i % 97 == 0) - (i % 131 == 0);
+    snapshot.remaining_capacity = 5800 - (uint16_t)(i / 3);
+    snapshot.relative_state_of_charge = snapshot.remaining_capacity * 100 / 5800;
+    snapshot.absolute_state_of_charge = snapshot.relative_state_of_charge;
+    snapshot.run_time_to_empty = snapshot.remaining_capacity * 60 / 1250;
+    snapshot.avg_time_to_empty = snapshot.remaining_capacity * 60 / 1240;
+    snapshot.avg_time_to_full = 65535;
+    snapshot.max_error = 1;
+    snapshot.valid = (i % 500 == 250) ? SNAPSHOT_ESSENTIAL : SNAPSHOT_ALL;
+    snapshots.push_back(snapshot);
+  }
+}
+
+/**
+ * @brief Compare the binary stream with a labelled text dump, and measure the encoder and
+ * the decoder.
+ */
+static void benchSnapshotStream() {
+  printf("Binary snapshot stream:\n");
+  const size_t count = 1000000;
+  std::vector<BatterySnapshot> snapshots;
+  snapshots.reserve(count);
+  makeDischarge(snapshots, count);
+
+  // Text as examples/main.cpp prints it, one labelled line per field
+  static const char* const labels[] = {
+    "Battery Status: ", "Voltage: ", "Current: ", "Average Current: ", "Temperature: ",
+    "Relative State Of Charge: ", "Absolute State Of Charge: ", "Remaining Capacity: ", "Full Capacity: ",
+    "Run Time To Empty: ", "Average Time To Empty: ", "Average Time To Full: ", "Charging Current: ",
+    "Charging Voltage: ", "Max Error: ",
+  };
+  BufferPrint text;
+  for (size_t i = 0; i < 1000; i++) {
+    const BatterySnapshot& snapshot = snapshots[i];
+    text.print("Timestamp: ");
+    text.println((unsigned long)snapshot.timestamp);
+    const uint16_t* values = &snapshot.battery_status;
+    for (int f = 0; f < SNAPSHOT_STREAM_FIELDS; f++) {
+      text.print(labels[f]);
+      text.println(f == 2 || f == 3 ? (int)(int16_t)values[f] : (int)values[f]);
+    }
+  }
+
+  std::vector<uint8_t> bytes;
+  bytes.reserve(count * 24);
+  BufferPrint out(&bytes);
+  SnapshotEncoder encoder(out);
+  size_t largest = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (const BatterySnapshot& snapshot : snapshots) {
+    size_t length = encoder.write(snapshot);
+    largest = length > largest ? length : largest;
+  }
+  uint64_t encodeNs = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+  printf("  all 15 fields: text %.1f bytes/record, binary %.1f bytes/record (largest %u)\n", text.count / 1000.0,
+         (double)bytes.size() / count, (unsigned)largest);
+
+  std::vector<uint8_t> essential;
+  BufferPrint essentialOut(&essential);
+  SnapshotEncoder essentialEncoder(essentialOut);
+  for (size_t i = 0; i < 1000; i++) {
+    BatterySnapshot snapshot = snapshots[i];
+    snapshot.valid = SNAPSHOT_ESSENTIAL;
+    essentialEncoder.write(snapshot);
+  }
+  printf("  SNAPSHOT_ESSENTIAL fields: binary %.1f bytes/record\n", essential.size() / 1000.0);
+
+  SnapshotDecoder decoder;
+  BatterySnapshot decoded;
+  const uint8_t* data = bytes.data();
+  const uint8_t* end = data + bytes.size();
+  start = std::chrono::steady_clock::now();
+  while (decoder.decode(data, end, decoded) == SNAPSHOT_STREAM_OK) {
+  }
+  uint64_t decodeNs = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+  printf("  encode %.1f M records/s, decode %.1f M records/s\n", count * 1e3 / encodeNs, count * 1e3 / decodeNs);
+}
+
+struct ChangeLog {
+  uint16_t calls[256];
+  uint16_t last[256];
+  uint16_t previous[256];
+};
+
+static void recordChange(uint8_t reg, uint16_t value, uint16_t previous, void* context) {
+  ChangeLog* log = static_cast<ChangeLog*>(context);
+  log->calls[reg]++;
+  log->last[reg] = value;
+  log->previous[reg] = previous;
+}
+
+/**
+ * @brief Poll a pack with a noisy current, a slowly sagging voltage and one load step for ten
+ * simulated minutes, and count how many samples reach the callbacks.
+ */
+static void benchChangeDetector(ArduinoSMBus& battery, SimBattery& sim) {
+  printf("Change detection, 600 polls of 5 registers:\n");
+  static ChangeLog log;
+  memset(&log, 0, sizeof(log));
+  ChangeDetector detector(battery);
+  detector.watch(VOLTAGE, 20, recordChange, &log);
+  detector.watch(CURRENT, 100, recordChange, &log);
+  detector.watch(TEMPERATURE, 5, recordChange, &log);
+  detector.watch(REL_STATE_OF_CHARGE, 0, recordChange, &log);
+  detector.watch(BATTERY_STATUS, 1000, recordChange, &log);
+
+  const uint8_t changed[] = {CURRENT, VOLTAGE, TEMPERATURE, REL_STATE_OF_CHARGE, BATTERY_STATUS};
+  uint16_t saved[sizeof(changed)];
+  for (size_t i = 0; i < sizeof(changed); i++) {
+    saved[i] = sim.word(changed[i]);
+  }
+
+  uint32_t seed = 99;
+  for (int i = 0; i < 600; i++) {
+    seed = seed * 1103515245 + 12345;
+    int noise = (int)((seed >> 16) % 61) - 30;
+    int16_t current = (i < 400 ? -1250 : -3000) + noise;
+    sim.setWord(CURRENT, (uint16_t)current);
+    sim.setWord(VOLTAGE, 15840 - i / 3 - (i >= 400 ? 150 : 0));
+    sim.setWord(TEMPERATURE, 2982 + (i % 2));
+    sim.setWord(REL_STATE_OF_CHARGE, 80 - i / 60);
+    sim.setWord(BATTERY_STATUS, i < 500 ? 0x00c0 : 0x08c0);
+    detector.poll();
+  }
+  printf("  %lu samples, %lu reported, %lu suppressed\n", (unsigned long)detector.samples(),
+         (unsigned long)detector.notifications(), (unsigned long)detector.suppressed());
+
+  for (size_t i = 0; i < sizeof(changed); i++) {
+    sim.setWord(changed[i], saved[i]);
+  }
+}
+
+/**
+ * @brief Run a pack through two simulated hours of rest, discharge, a load step with heating,
+ * an alarm and rest again, polling at the interval the rate controller picks, and compare
+ * the polls with a fixed fast rate.
+ */
+static void benchAdaptivePollRate(ArduinoSMBus& battery, SimBattery& sim) {
+  printf("Adaptive poll rate over 2 simulated hours:\n");
+  const uint8_t changed[] = {CURRENT, TEMPERATURE, BATTERY_STATUS};
+  uint16_t saved[sizeof(changed)];
+  for (size_t i = 0; i < sizeof(changed); i++) {
+    saved[i] = sim.word(changed[i]);
+  }
+
+  AdaptivePollRate rate;
+  BatteryPoller poller(battery, SNAPSHOT_ESSENTIAL);
+  poller.setRateController(&rate);
+  poller.start(POLL_RATE_MIN_MS);
+  poller.stop();
+  battery.setTurnaround(0);
+
+  // Phases: rest, 1.25 A discharge, 3 A with the pack heating, over-temperature alarm, rest
+  const uint32_t phaseEnd[] = {1800000, 3600000, 3900000, 4000000, 7200000};
+  const char* const phaseName[] = {"rest", "1.25 A", "3 A, heating", "alarm", "rest"};
+  uint32_t polls[5] = {0};
+  uint32_t longest[5] = {0};
+  uint32_t stepLatency = 0;
+  uint32_t start = millis();
+  uint32_t elapsed = 0;
+  uint32_t seed = 7;
+  while ((elapsed = millis() - start) < phaseEnd[4]) {
+    int phase = 0;
+    while (elapsed >= phaseEnd[phase]) {
+      phase++;
+    }
+    seed = seed * 1103515245 + 12345;
+    int noise = (int)((seed >> 16) % 21) - 10;
+    int16_t current = phase == 1 ? -1250 + noise : phase == 2 || phase == 3 ? -3000 + noise : noise / 4;
+    uint16_t temperature = 2982 + (phase == 2 ? (elapsed - phaseEnd[1]) / 6000 : phase == 3 ? 50 : 0);
+    sim.setWord(CURRENT, (uint16_t)current);
+    sim.setWord(TEMPERATURE, temperature);
+    sim.setWord(BATTERY_STATUS, phase == 3 ? 0x10c0 : 0x00c0);
+
+    poller.pollOnce();
+    if (phase == 2 && polls[2] == 0) {
+      stepLatency = elapsed - phaseEnd[1];
+    }
+    polls[phase]++;
+    longest[phase] = poller.period() > longest[phase] ? poller.period() : longest[phase];
+    delay(poller.period());
+  }
+
+  uint32_t total = 0;
+  for (int i = 0; i < 5; i++) {
+    printf("  %-14s %5lu polls, longest interval %5lu ms\n", phaseName[i], (unsigned long)polls[i], (unsigned long)longest[i]);
+    total += polls[i];
+  }
+  printf("  %lu polls against %lu at a fixed %u ms; load step seen after %lu ms\n", (unsigned long)total,
+         (unsigned long)(phaseEnd[4] / POLL_RATE_MIN_MS), POLL_RATE_MIN_MS, (unsigned long)stepLatency);
+
+  for (size_t i = 0; i < sizeof(changed); i++) {
+    sim.setWord(changed[i], saved[i]);
+  }
+}
+
+static void countRead(uint8_t reg, uint16_t value, bool ok, void* context) {
+  (void)value;
+  if (ok) {
+    static_cast<uint32_t*>(context)[reg]++;
+  }
+}
+
+/**
+ * @brief Build a 10 Hz / 1 Hz / 1 per minute schedule, run one major frame of it and report
+ * the frame times against the estimate, with a fixed and with an adapting turnaround.
+ */
+static void benchRateGroups(ArduinoSMBus& battery, SimBattery& sim) {
+  printf("Rate-group schedule:\n");
+  battery.setTurnaround(0);
+  static const RateGroupEntry table[] = {
+    {CYCLE_COUNT, 60000}, {STATE_OF_HEALTH, 60000},
+    {REL_STATE_OF_CHARGE, 1000}, {RUN_TIME_TO_EMPTY, 1000}, {AVG_TIME_TO_EMPTY, 1000}, {AVG_TIME_TO_FULL, 1000},
+    {BATTERY_STATUS, 100}, {VOLTAGE, 100}, {CURRENT, 100}, {TEMPERATURE, 100},
+  };
+  RateGroupScheduler scheduler(battery);
+  static uint32_t reads[256];
+  memset(reads, 0, sizeof(reads));
+  scheduler.onRead(countRead, reads);
+  scheduler.configure(table, sizeof(table) / sizeof(table[0]));
+  printf("  minor frame %lu ms, major frame %lu ms, read cost %lu us, busiest frame %lu us (%u%% of the bus)\n",
+         (unsigned long)scheduler.minorFrame(), (unsigned long)scheduler.majorFrame(), (unsigned long)scheduler.readCost(),
+         (unsigned long)scheduler.worstFrameMicros(), scheduler.utilisation());
+
+  int most = 0;
+  while (scheduler.frames() < 600) {
+    int n = scheduler.service();
+    if (n < 0) {
+      delayMicroseconds(200);
+    }
+    most = n > most ? n : most;
+  }
+  printf("  600 frames: at most %d reads a frame, longest frame %lu us, %lu overruns\n", most,
+         (unsigned long)scheduler.longestFrameMicros(), (unsigned long)scheduler.overruns());
+
+  // A gauge that NACKs until ready, learned from scratch, with the read combined or split
+  // around the turnaround
+  RateGroupScheduler adaptive(battery);
+  adaptive.onRead(countRead, reads);
+  adaptive.setTurnaroundBound(2000);
+  sim.setClockStretching(false);
+  sim.setTurnaroundMicros(1200);
+  for (uint8_t deferred = 0; deferred < 2; deferred++) {
+    Wire.setDeferredWrites(deferred);
+    battery.setDeferredRepeatedStart(deferred);
+    battery.setTurnaround(0);
+    battery.setAdaptiveTurnaround(true);
+    adaptive.configure(table, sizeof(table) / sizeof(table[0]));
+    uint32_t start = adaptive.frames();
+    while (adaptive.frames() - start < 600) {
+      if (adaptive.service() < 0) {
+        delayMicroseconds(200);
+      }
+    }
+    printf("  1200 us gauge, adaptive%s: busiest frame %lu us estimated, longest %lu us measured, %lu overruns\n",
+           deferred ? ", deferred" : "", (unsigned long)adaptive.worstFrameMicros(),
+           (unsigned long)adaptive.longestFrameMicros(), (unsigned long)adaptive.overruns());
+  }
+  Wire.setDeferredWrites(false);
+  battery.setDeferredRepeatedStart(false);
+  sim.setTurnaroundMicros(0);
+  sim.setClockStretching(true);
+  battery.setTurnaround(0);
+  battery.setAdaptiveTurnaround(true);
+}
+
+#define PACKS 16
+#define PACK_BASE_ADDRESS 0x20
+
+/**
+ * @brief Run a BatteryBus for a number of simulated milliseconds.
+ */
+static void runBus(BatteryBus& bus, uint32_t ms) {
+  unsigned long start = millis();
+  while (millis() - start < ms) {
+    if (bus.service() < 0) {
+      delayMicroseconds(100);
+    }
+  }
+}
+
+/**
+ * @brief Poll 16 packs on one bus, one of them absent and one slow, and report how the
+ * bus time is shared; then the same with weights and share caps.
+ */
+static void benchBatteryBus() {
+  SimBattery* sims[PACKS];
+  ArduinoSMBus* packs[PACKS];
+  BatteryBus bus;
+
+  for (int i = 0; i < PACKS; i++) {
+    sims[i] = new SimBattery(PACK_BASE_ADDRESS + i);
+    sims[i]->attach();
+    packs[i] = new ArduinoSMBus(PACK_BASE_ADDRESS + i);
+    bus.addPack(*packs[i]);
+  }
+
+  sims[3]->detach();                 // Pack 3 NACKs
+  sims[7]->setTurnaroundMicros(3000); // Pack 7 is slow and cannot clock stretch
+  sims[7]->setClockStretching(false);
+
+  printf("BatteryBus, %d packs, pack 3 absent, pack 7 needs 3 ms turnaround:\n", PACKS);
+  SimBus::instance().resetStats();
+  uint64_t start = simNanos();
+  runBus(bus, 5000);
+  uint64_t elapsed = simNanos() - start;
+
+  uint32_t total = 0;
+  uint32_t minimum = 0xffffffff;
+  uint32_t maximum = 0;
+  for (int i = 0; i < PACKS; i++) {
+    const BatteryBusPackStats& stats = bus.stats(i);
+    total += stats.polls - stats.failures;
+    if (i != 3 && i != 7) {
+      minimum = stats.polls < minimum ? stats.polls : minimum;
+      maximum = stats.polls > maximum ? stats.polls : maximum;
+    }
+  }
+  printRate("snapshots (5 registers each), all packs", total, elapsed);
+  printf("  healthy packs %u..%u polls, absent pack %u polls, slow pack %u polls using %.1f%% of bus time\n",
+         minimum, maximum, bus.stats(3).polls, bus.stats(7).polls,
+         100.0 * bus.stats(7).busMicros / (elapsed / 1000));
+
+  // Weights and caps
+  BatteryBus weighted;
+  for (int i = 0; i < 4; i++) {
+    sims[i]->attach();
+    sims[i]->setTurnaroundMicros(0);
+    weighted.addPack(*packs[i]);
+  }
+  weighted.setWeight(0, 4);
+  weighted.setMaxShare(1, 5);
+  start = simNanos();
+  runBus(weighted, 2000);
+  elapsed = simNanos() - start;
+  printf("  weights 4:1:1:1 with pack 1 capped at 5%%: polls %u, %u, %u, %u\n", weighted.stats(0).polls,
+         weighted.stats(1).polls, weighted.stats(2).polls, weighted.stats(3).polls);
+
+  for (int i = 0; i < PACKS; i++) {
+    delete packs[i];
+    delete sims[i];
+  }
+}
+
+/**
+ * @brief Sweep pack count and gauge turnaround, comparing one-pack-at-a-time snapshots with
+ * pipelined rounds that overlap the turnarounds of all packs.
+ */
+static void benchPipelined() {
+  static const uint8_t packCounts[] = {1, 2, 4, 8, 16};
+  static const uint32_t turnarounds[] = {0, 500, 2000, 5000};
+  const uint32_t rounds = 20;
+
+  printf("Aggregate word reads/s, sequential vs pipelined (5 registers per pack):\n");
+  printf("  %-6s", "packs");
+  for (uint32_t turnaround : turnarounds) {
+    printf("  %6u us: seq / pipe", turnaround);
+  }
+  printf("\n");
+
+  for (uint8_t packs : packCounts) {
+    printf("  %-6u", packs);
+    for (uint32_t turnaround : turnarounds) {
+      SimBattery* sims[PACKS];
+      ArduinoSMBus* batteries[PACKS];
+      BatteryBus bus;
+      for (uint8_t i = 0; i < packs; i++) {
+        sims[i] = new SimBattery(PACK_BASE_ADDRESS + i);
+        sims[i]->attach();
+        sims[i]->setTurnaroundMicros(turnaround);
+        sims[i]->setWord(VOLTAGE, 11000 + i);
+        batteries[i] = new ArduinoSMBus(PACK_BASE_ADDRESS + i);
+        bus.addPack(*batteries[i]);
+      }
+
+      // Let both turnarounds settle before measuring
+      for (uint32_t r = 0; r < 5; r++) {
+        for (uint8_t i = 0; i < packs; i++) {
+          bus.service();
+        }
+        bus.pollAll();
+      }
+
+      uint64_t start = simNanos();
+      for (uint32_t r = 0; r < rounds; r++) {
+        for (uint8_t i = 0; i < packs; i++) {
+          bus.service();
+        }
+      }
+      double sequential = rounds * packs * 5 * 1e9 / (simNanos() - start);
+
+      start = simNanos();
+      for (uint32_t r = 0; r < rounds; r++) {
+        bus.pollAll();
+      }
+      double pipelined = rounds * packs * 5 * 1e9 / (simNanos() - start);
+      printf("  %8.0f / %8.0f    ", sequential, pipelined);
+
+      for (uint8_t i = 0; i < packs; i++) {
+        delete batteries[i];
+        delete sims[i];
+      }
+    }
+    printf("\n");
+  }
+}
+
+int main() {
+  SimBattery sim(BATTERY_ADDRESS);
+  sim.attach();
+  SimBus::instance().setTransactionOverheadNanos(50000);
+
+  ArduinoSMBus battery(BATTERY_ADDRESS);
+
+  benchWordReads(battery, sim);
+  benchTurnaround(battery, sim);
+  benchDeferredWrites(battery, sim);
+  benchRepeatedStart(battery, sim);
+  benchSnapshot(battery, sim);
+  benchCache(battery);
+  benchAsync(battery, sim);
+  benchPriorities(battery, sim);
+  benchFaults(battery, sim);
+  benchPEC(battery, sim);
+  benchWrites(battery, sim);
+  benchAlarms(battery, sim);
+  benchGauge(battery, sim);
+  benchDataFlash(battery);
+  benchTelemetryLog();
+  benchSnapshotStream();
+  benchChangeDetector(battery, sim);
+  benchAdaptivePollRate(battery, sim);
+  benchRateGroups(battery, sim);
+  stressPublisher();
+  benchBatteryBus();
+  benchPipelined();
+  return 0;
+}
+
+#endif // PIO_UNIT_TESTING
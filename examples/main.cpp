@@ -11,9 +11,16 @@
 
 #include <Arduino.h>
 #include "ArduinoSMBus.h"
+#include "SnapshotStream.h"
 
 ArduinoSMBus battery(0x0B); // Replace with your battery's address
 
+// Define STREAM_SNAPSHOTS to follow the text dump with one binary record a second, about
+// 24 bytes instead of several hundred; decode them on the host with SnapshotDecoder.
+#ifdef STREAM_SNAPSHOTS
+SnapshotEncoder encoder(Serial);
+#endif
+
 void setup() {
   Serial.begin(115200);
 
@@ -60,6 +67,9 @@ void setup() {
   Serial.print("Average Current: ");
   Serial.println(battery.averageCurrent());
 
+  Serial.print("Power: ");
+  Serial.println(battery.power());
+
   Serial.print("Max Error: ");
   Serial.println(battery.maxError());
 
@@ -149,5 +159,12 @@ void setup() {
 }
 
 void loop() {
+#ifdef STREAM_SNAPSHOTS
+  BatterySnapshot snapshot;
+  battery.readSnapshot(snapshot);
+  encoder.write(snapshot);
+  delay(1000);
+#else
   delay(10);
+#endif
 }
\ No newline at end of file
@@ -0,0 +1,89 @@
+/**
+ * @file AdaptivePollRate.h
+ * @brief Picks the time to the next poll from what the battery is doing.
+ * @version 1.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef AdaptivePollRate_h
+#define AdaptivePollRate_h
+
+#include "ArduinoSMBus.h"
+
+#define POLL_RATE_MIN_MS 250                 // Default fastest poll interval
+#define POLL_RATE_MAX_MS 30000               // Default slowest poll interval
+#define POLL_RATE_REST_CURRENT 20            // Default mA at or below which the pack is at rest
+#define POLL_RATE_HIGH_CURRENT 2000          // Default mA at or above which it is polled fastest
+#define POLL_RATE_CURRENT_SLEW 500           // Default mA/s of current change polled fastest
+#define POLL_RATE_TEMPERATURE_RISE 10        // Default 0.1 K/min of temperature rise polled fastest
+#define POLL_RATE_TEMPERATURE_WINDOW_MS 10000 // Temperature rise is measured over at least this long
+
+/**
+ * @enum PollReason
+ * @brief What decided the current poll interval.
+ */
+enum PollReason : uint8_t {
+  POLL_NO_DATA,             /**< No usable sample yet, or the last one failed; the interval is unchanged. */
+  POLL_ALARM,               /**< A critical BatteryStatus alarm is set. */
+  POLL_TEMPERATURE_RISING,  /**< Temperature is rising faster than the threshold. */
+  POLL_CURRENT_SLEW,        /**< Current is changing faster than the threshold. */
+  POLL_HIGH_CURRENT,        /**< Current is above the high threshold. */
+  POLL_DISCHARGING,         /**< Discharging; the interval shrinks as the current grows. */
+  POLL_CHARGING,            /**< Charging; the interval shrinks as the current grows. */
+  POLL_REST                 /**< No current; the interval doubles on every poll up to the maximum. */
+};
+
+/**
+ * @class AdaptivePollRate
+ * @brief Chooses the interval to the next poll from the latest snapshot.
+ *
+ * Alarms, a fast-rising temperature, a fast-changing current and a high current all poll at
+ * the minimum interval. Otherwise a pack with current flowing is polled at an interval
+ * inversely proportional to the current, so each poll sees about the same charge move:
+ * maximum interval times the rest current. A pack at rest backs off, doubling its interval
+ * each poll up to the maximum, so a pack that just went idle is still watched for a while.
+ * Speeding up always takes effect at once.
+ *
+ * update() needs the CURRENT field of the snapshot. It also uses BATTERY_STATUS and
+ * TEMPERATURE when they are present, so SNAPSHOT_ESSENTIAL is enough.
+ */
+class AdaptivePollRate {
+public:
+  AdaptivePollRate(uint32_t minIntervalMs = POLL_RATE_MIN_MS, uint32_t maxIntervalMs = POLL_RATE_MAX_MS);
+
+  void setLimits(uint32_t minIntervalMs, uint32_t maxIntervalMs);
+  void setRestCurrent(uint16_t milliamps);
+  void setHighCurrent(uint16_t milliamps);
+  void setCurrentSlew(uint16_t milliampsPerSecond);
+  void setTemperatureRise(uint16_t decikelvinPerMinute);
+
+  uint32_t update(const BatterySnapshot& snapshot);
+  void reset();
+
+  uint32_t interval() const;
+  PollReason reason() const;
+  int32_t temperatureRise() const;
+
+private:
+  uint32_t _minMs;
+  uint32_t _maxMs;
+  uint16_t _restCurrent;
+  uint16_t _highCurrent;
+  uint16_t _currentSlew;
+  uint16_t _temperatureRise;
+
+  uint32_t _intervalMs;
+  PollReason _reason;
+  bool _haveCurrent;
+  int16_t _current;
+  uint32_t _currentTime;
+  bool _haveTemperature;
+  uint16_t _temperature;
+  uint32_t _temperatureTime;
+  int32_t _rise;
+};
+
+#endif
@@ -15,6 +15,9 @@
 #include <Arduino.h>
 #include <Wire.h>
 
+#include "SMBusPEC.h"
+#include "SMBusUnits.h"
+
  //Usable Commands
 #define MANUFACTURER_ACCESS 0x00
 #define REMAINING_CAPACITY_ALARM 0x01
@@ -43,40 +46,434 @@
 #define MANUFACTURER_NAME 0x20
 #define DEVICE_NAME 0x21
 #define DEVICE_CHEMISTRY 0x22
+#define MANUFACTURER_DATA 0x23
 #define STATE_OF_HEALTH 0x4f
 
+#define SMBUS_BLOCK_MAX 32                // Longest block an SMBus Block Read may return
+
+// Bytes one Wire.requestFrom() can return: 32 on AVR, 128 on ESP32
+#ifndef SMBUS_WIRE_BUFFER_LENGTH
+#if defined(I2C_BUFFER_LENGTH)
+#define SMBUS_WIRE_BUFFER_LENGTH I2C_BUFFER_LENGTH
+#elif defined(BUFFER_LENGTH)
+#define SMBUS_WIRE_BUFFER_LENGTH BUFFER_LENGTH
+#else
+#define SMBUS_WIRE_BUFFER_LENGTH 255
+#endif
+#endif
+
+// Command-to-read turnaround adaptation
+#define SMBUS_TURNAROUND_MAX_US 10000     // Upper bound, the delay(10) previously used for every read
+#define SMBUS_TURNAROUND_STEP_US 50       // First increment when a zero turnaround fails
+#define SMBUS_TURNAROUND_PROBE_READS 64   // Good reads before trying a shorter turnaround
+
+// Cores whose endTransmission(false) only queues the command for the next requestFrom()
+#ifndef SMBUS_DEFERRED_REPEATED_START
+#if defined(ARDUINO_ARCH_ESP32)
+#define SMBUS_DEFERRED_REPEATED_START 1
+#else
+#define SMBUS_DEFERRED_REPEATED_START 0
+#endif
+#endif
+
+// Retries after a failed transaction
+#ifndef SMBUS_DEFAULT_RETRIES
+#define SMBUS_DEFAULT_RETRIES 2           // Extra attempts per read before giving up
+#endif
+#define SMBUS_RETRY_BACKOFF_US 200        // Wait before the first retry, doubled for each further retry
+#define SMBUS_RECOVERY_CLOCKS 9           // SCL pulses that release any target stuck mid-byte
+
+/**
+ * @enum SMBusStatus
+ * @brief Outcome of a bus transaction.
+ */
+enum SMBusStatus : uint8_t {
+  SMBUS_OK,           /**< The transaction completed. */
+  SMBUS_NACK_ADDRESS, /**< No device acknowledged the address, or the battery was not ready to answer. */
+  SMBUS_NACK_DATA,    /**< The battery acknowledged its address but rejected the command byte. */
+  SMBUS_TIMEOUT,      /**< The bus did not complete the transaction, e.g. SDA held low by a target. */
+  SMBUS_SHORT_READ,   /**< Fewer valid bytes arrived than the read needed. */
+  SMBUS_PEC_ERROR,    /**< The packet error code did not match the data. */
+  SMBUS_BUS_ERROR,    /**< Any other controller error, such as a lost arbitration. */
+  SMBUS_VERIFY_ERROR  /**< A write was acknowledged but the register read back a different value. */
+};
+
+/**
+ * @struct SMBusResult
+ * @brief Status and value of a read, so a failed read cannot be mistaken for a reading of 0.
+ */
+struct SMBusResult {
+  SMBusStatus status; /**< SMBUS_OK if value is valid. */
+  uint16_t value;     /**< Word read, or number of bytes stored for block reads. 0 on failure. */
+
+  bool ok() const { return status == SMBUS_OK; }
+};
+
+// BatteryMode (0x03) bits
+#define BATTERY_MODE_INTERNAL_CHARGE_CONTROLLER 0x0001
+#define BATTERY_MODE_PRIMARY_BATTERY_SUPPORT 0x0002
+#define BATTERY_MODE_CONDITION_FLAG 0x0080
+#define BATTERY_MODE_CHARGE_CONTROLLER_ENABLED 0x0100
+#define BATTERY_MODE_PRIMARY_BATTERY 0x0200
+#define BATTERY_MODE_ALARM_MODE 0x2000
+#define BATTERY_MODE_CHARGER_MODE 0x4000
+#define BATTERY_MODE_CAPACITY_MODE 0x8000
+#define BATTERY_MODE_WRITABLE 0xe300          // Bits the host may change: CHGC_EN, PB, AM, CHGM, CAPM
+
+// BatteryStatus (0x16) bits
+#define BATTERY_STATUS_OVER_CHARGED_ALARM 0x8000
+#define BATTERY_STATUS_TERM_CHARGE_ALARM 0x4000
+#define BATTERY_STATUS_OVER_TEMP_ALARM 0x1000
+#define BATTERY_STATUS_TERM_DISCHARGE_ALARM 0x0800
+#define BATTERY_STATUS_REM_CAPACITY_ALARM 0x0200
+#define BATTERY_STATUS_REM_TIME_ALARM 0x0100
+#define BATTERY_STATUS_INITIALIZED 0x0080
+#define BATTERY_STATUS_DISCHARGING 0x0040
+#define BATTERY_STATUS_FULLY_CHARGED 0x0020
+#define BATTERY_STATUS_FULLY_DISCHARGED 0x0010
+#define BATTERY_STATUS_ERROR_CODE 0x000f
+#define BATTERY_STATUS_ALARMS 0xdb00            // Every alarm bit
+#define BATTERY_STATUS_CRITICAL_ALARMS 0xd800   // The alarms statusOK() checks
+
  /**
  * @struct BatteryMode
- * @brief A struct to hold various battery mode flags.
+ * @brief The BatteryMode register, one word in size.
+ *
+ * Flags can be read and written as fields, as in earlier versions of the library, through
+ * constexpr accessors, or all at once through raw and the BATTERY_MODE_* masks.
  */
 struct BatteryMode {
-  bool internal_charge_controller;  /**< True if the internal charge controller is supported, false otherwise. */
-  bool primary_battery_support;     /**< True if the primary battery support is supported, false otherwise. */
-  bool condition_flag;              /**< False if condition is ok, true if battery conditioning cycle is needed. */
-  bool charge_controller_enabled;   /**< True if the charge controller is enabled, false otherwise. */
-  bool primary_battery;             /**< True if the primary battery is enabled, false otherwise. */
-  bool alarm_mode;                  /**< True to enable alarmWarning broadcasts to host, false to disable. */
-  bool charger_mode;                /**< True to enable chargingCurrent and chargingVoltage broadcasts to host, false to disable. */
-  bool capacity_mode;               /**< True to report in mA or mAh, false to report in 10mW or 10mWh units. */
+  union {
+    uint16_t raw;                                 /**< The register word. */
+    struct {
+      uint16_t internal_charge_controller : 1;    /**< True if the internal charge controller is supported, false otherwise. */
+      uint16_t primary_battery_support : 1;       /**< True if the primary battery support is supported, false otherwise. */
+      uint16_t : 5;
+      uint16_t condition_flag : 1;                /**< False if condition is ok, true if battery conditioning cycle is needed. */
+      uint16_t charge_controller_enabled : 1;     /**< True if the charge controller is enabled, false otherwise. */
+      uint16_t primary_battery : 1;               /**< True if the primary battery is enabled, false otherwise. */
+      uint16_t : 3;
+      uint16_t alarm_mode : 1;                    /**< True to disable AlarmWarning broadcasts to host and charger, false to enable them. */
+      uint16_t charger_mode : 1;                  /**< True to disable ChargingCurrent and ChargingVoltage broadcasts to the charger, false to enable them. */
+      uint16_t capacity_mode : 1;                 /**< True to report in 10mW or 10mWh units, false to report in mA or mAh. */
+    };
+  };
+
+  constexpr BatteryMode(uint16_t word = 0) : raw(word) {}
+
+  constexpr bool internalChargeController() const { return raw & BATTERY_MODE_INTERNAL_CHARGE_CONTROLLER; }
+  constexpr bool primaryBatterySupport() const { return raw & BATTERY_MODE_PRIMARY_BATTERY_SUPPORT; }
+  constexpr bool conditionFlag() const { return raw & BATTERY_MODE_CONDITION_FLAG; }
+  constexpr bool chargeControllerEnabled() const { return raw & BATTERY_MODE_CHARGE_CONTROLLER_ENABLED; }
+  constexpr bool primaryBattery() const { return raw & BATTERY_MODE_PRIMARY_BATTERY; }
+  constexpr bool alarmMode() const { return raw & BATTERY_MODE_ALARM_MODE; }
+  constexpr bool chargerMode() const { return raw & BATTERY_MODE_CHARGER_MODE; }
+  constexpr bool capacityMode() const { return raw & BATTERY_MODE_CAPACITY_MODE; }
+  constexpr bool any(uint16_t mask) const { return raw & mask; }    /**< True if any flag in mask is set. */
+  constexpr bool all(uint16_t mask) const { return (raw & mask) == mask; } /**< True if every flag in mask is set. */
 };
 
 /**
  * @struct BatteryStatus
- * @brief A struct to hold various battery status flags.
+ * @brief The BatteryStatus register, one word in size.
  *
- * This struct holds various flags that represent the battery status.
+ * Flags can be read as fields, as in earlier versions of the library, through constexpr
+ * accessors, or all at once through raw and the BATTERY_STATUS_* masks, e.g.
+ * `status.any(BATTERY_STATUS_ALARMS)`.
  */
 struct BatteryStatus {
-  bool over_charged_alarm;      /**< True if the battery is overcharged, false otherwise. Corresponds to bit 15 of the BatteryStatus register. */
-  bool term_charge_alarm;       /**< True if the termination charge alarm is set, false otherwise. Corresponds to bit 14 of the BatteryStatus register. */
-  bool over_temp_alarm;         /**< True if the battery temperature is over the limit, false otherwise. Corresponds to bit 12 of the BatteryStatus register. */
-  bool term_discharge_alarm;    /**< True if the termination discharge alarm is set, false otherwise. Corresponds to bit 11 of the BatteryStatus register. */
-  bool rem_capacity_alarm;      /**< True if the remaining capacity alarm is set, false otherwise. Corresponds to bit 9 of the BatteryStatus register. */
-  bool rem_time_alarm;          /**< True if the remaining time alarm is set, false otherwise. Corresponds to bit 8 of the BatteryStatus register. */
-  bool initialized;             /**< True if the battery is initialized, false otherwise. Corresponds to bit 7 of the BatteryStatus register. */
-  bool discharging;             /**< True if the battery is discharging, false otherwise. Corresponds to bit 6 of the BatteryStatus register. */
-  bool fully_charged;           /**< True if the battery is fully charged, false otherwise. Corresponds to bit 5 of the BatteryStatus register. */
-  bool fully_discharged;        /**< True if the battery is fully discharged, false otherwise. Corresponds to bit 4 of the BatteryStatus register. */
+  union {
+    uint16_t raw;                       /**< The register word. */
+    struct {
+      uint16_t error_code : 4;          /**< Result of the last command, 0 if it succeeded. Bits 0-3 of the BatteryStatus register. */
+      uint16_t fully_discharged : 1;    /**< True if the battery is fully discharged, false otherwise. Corresponds to bit 4 of the BatteryStatus register. */
+      uint16_t fully_charged : 1;       /**< True if the battery is fully charged, false otherwise. Corresponds to bit 5 of the BatteryStatus register. */
+      uint16_t discharging : 1;         /**< True if the battery is discharging, false otherwise. Corresponds to bit 6 of the BatteryStatus register. */
+      uint16_t initialized : 1;         /**< True if the battery is initialized, false otherwise. Corresponds to bit 7 of the BatteryStatus register. */
+      uint16_t rem_time_alarm : 1;      /**< True if the remaining time alarm is set, false otherwise. Corresponds to bit 8 of the BatteryStatus register. */
+      uint16_t rem_capacity_alarm : 1;  /**< True if the remaining capacity alarm is set, false otherwise. Corresponds to bit 9 of the BatteryStatus register. */
+      uint16_t : 1;
+      uint16_t term_discharge_alarm : 1;/**< True if the termination discharge alarm is set, false otherwise. Corresponds to bit 11 of the BatteryStatus register. */
+      uint16_t over_temp_alarm : 1;     /**< True if the battery temperature is over the limit, false otherwise. Corresponds to bit 12 of the BatteryStatus register. */
+      uint16_t : 1;
+      uint16_t term_charge_alarm : 1;   /**< True if the termination charge alarm is set, false otherwise. Corresponds to bit 14 of the BatteryStatus register. */
+      uint16_t over_charged_alarm : 1;  /**< True if the battery is overcharged, false otherwise. Corresponds to bit 15 of the BatteryStatus register. */
+    };
+  };
+
+  constexpr BatteryStatus(uint16_t word = 0) : raw(word) {}
+
+  constexpr bool overChargedAlarm() const { return raw & BATTERY_STATUS_OVER_CHARGED_ALARM; }
+  constexpr bool termChargeAlarm() const { return raw & BATTERY_STATUS_TERM_CHARGE_ALARM; }
+  constexpr bool overTempAlarm() const { return raw & BATTERY_STATUS_OVER_TEMP_ALARM; }
+  constexpr bool termDischargeAlarm() const { return raw & BATTERY_STATUS_TERM_DISCHARGE_ALARM; }
+  constexpr bool remCapacityAlarm() const { return raw & BATTERY_STATUS_REM_CAPACITY_ALARM; }
+  constexpr bool remTimeAlarm() const { return raw & BATTERY_STATUS_REM_TIME_ALARM; }
+  constexpr bool isInitialized() const { return raw & BATTERY_STATUS_INITIALIZED; }
+  constexpr bool isDischarging() const { return raw & BATTERY_STATUS_DISCHARGING; }
+  constexpr bool isFullyCharged() const { return raw & BATTERY_STATUS_FULLY_CHARGED; }
+  constexpr bool isFullyDischarged() const { return raw & BATTERY_STATUS_FULLY_DISCHARGED; }
+  constexpr uint8_t errorCode() const { return raw & BATTERY_STATUS_ERROR_CODE; }
+  constexpr bool any(uint16_t mask) const { return raw & mask; }    /**< True if any flag in mask is set. */
+  constexpr bool all(uint16_t mask) const { return (raw & mask) == mask; } /**< True if every flag in mask is set. */
+  constexpr bool ok() const { return !(raw & BATTERY_STATUS_CRITICAL_ALARMS); } /**< True if no critical alarm is set, as statusOK(). */
+};
+
+static_assert(sizeof(BatteryMode) == 2, "BatteryMode must be one register word");
+static_assert(sizeof(BatteryStatus) == 2, "BatteryStatus must be one register word");
+
+// Register descriptors
+/**
+ * @enum SMBusWireType
+ * @brief How a register is transferred on the bus.
+ */
+enum SMBusWireType : uint8_t {
+  SMBUS_WIRE_WORD,        /**< Read Word, unsigned. */
+  SMBUS_WIRE_SIGNED_WORD, /**< Read Word, two's complement. */
+  SMBUS_WIRE_BLOCK        /**< Block Read of an ASCII string. */
+};
+
+/**
+ * @enum SMBusUnit
+ * @brief Base unit of a register value, before its power-of-ten scaling.
+ */
+enum SMBusUnit : uint8_t {
+  SMBUS_UNIT_NONE,        /**< Bit fields and strings. */
+  SMBUS_UNIT_KELVIN,
+  SMBUS_UNIT_VOLT,
+  SMBUS_UNIT_AMPERE,
+  SMBUS_UNIT_AMPERE_HOUR, /**< Or 10 mWh when BatteryMode capacity_mode is set. */
+  SMBUS_UNIT_PERCENT,
+  SMBUS_UNIT_MINUTE,
+  SMBUS_UNIT_COUNT,
+  SMBUS_UNIT_DATE         /**< Day + Month*32 + (Year-1980)*512. */
+};
+
+/**
+ * @enum SMBusVolatility
+ * @brief How often a register's value changes, used to pick its default cache policy.
+ */
+enum SMBusVolatility : uint8_t {
+  SMBUS_VOLATILE,         /**< Changes with every measurement or can be written; always read. */
+  SMBUS_SLOW,             /**< Changes over hours; cached for SMBUS_SLOW_TTL_MS. */
+  SMBUS_STATIC            /**< Fixed for the life of the pack; read once. */
+};
+
+#define SMBUS_SLOW_TTL_MS 60000   // Cache TTL of SMBUS_SLOW registers
+
+/**
+ * @enum SMBusAccess
+ * @brief Whether the host may write a register.
+ */
+enum SMBusAccess : uint8_t {
+  SMBUS_READ_ONLY,
+  SMBUS_READ_WRITE
+};
+
+/**
+ * @struct SMBusRegisterInfo
+ * @brief Descriptor of one Smart Battery register.
+ * A value in the register's unit is the raw word times 10^exponent.
+ */
+struct SMBusRegisterInfo {
+  uint8_t command;            /**< SMBus command code. */
+  SMBusWireType wireType;     /**< How the register is transferred. */
+  SMBusUnit unit;             /**< Base unit. */
+  int8_t exponent;            /**< Power-of-ten scaling of the raw value. */
+  SMBusVolatility volatility; /**< Default cache class. */
+  SMBusAccess access;         /**< Whether writeRegister() may write it. */
+};
+
+// Every register the library reads: X(command, C++ type, wire type, unit, exponent, volatility, access)
+#define SMBUS_REGISTERS(X) \
+  X(REMAINING_CAPACITY_ALARM, uint16_t, SMBUS_WIRE_WORD, SMBUS_UNIT_AMPERE_HOUR, -3, SMBUS_VOLATILE, SMBUS_READ_WRITE) \
+  X(REMAINING_TIME_ALARM, uint16_t, SMBUS_WIRE_WORD, SMBUS_UNIT_MINUTE, 0, SMBUS_VOLATILE, SMBUS_READ_WRITE) \
+  X(BATTERY_MODE, BatteryMode, SMBUS_WIRE_WORD, SMBUS_UNIT_NONE, 0, SMBUS_VOLATILE, SMBUS_READ_WRITE) \
+  X(TEMPERATURE, uint16_t, SMBUS_WIRE_WORD, SMBUS_UNIT_KELVIN, -1, SMBUS_VOLATILE, SMBUS_READ_ONLY) \
+  X(VOLTAGE, uint16_t, SMBUS_WIRE_WORD, SMBUS_UNIT_VOLT, -3, SMBUS_VOLATILE, SMBUS_READ_ONLY) \
+  X(CURRENT, int16_t, SMBUS_WIRE_SIGNED_WORD, SMBUS_UNIT_AMPERE, -3, SMBUS_VOLATILE, SMBUS_READ_ONLY) \
+  X(AVERAGE_CURRENT, int16_t, SMBUS_WIRE_SIGNED_WORD, SMBUS_UNIT_AMPERE, -3, SMBUS_VOLATILE, SMBUS_READ_ONLY) \
+  X(MAX_ERROR, uint16_t, SMBUS_WIRE_WORD, SMBUS_UNIT_PERCENT, 0, SMBUS_VOLATILE, SMBUS_READ_ONLY) \
+  X(REL_STATE_OF_CHARGE, uint16_t, SMBUS_WIRE_WORD, SMBUS_UNIT_PERCENT, 0, SMBUS_VOLATILE, SMBUS_READ_ONLY) \
+  X(ABS_STATE_OF_CHARGE, uint16_t, SMBUS_WIRE_WORD, SMBUS_UNIT_PERCENT, 0, SMBUS_VOLATILE, SMBUS_READ_ONLY) \
+  X(REM_CAPACITY, uint16_t, SMBUS_WIRE_WORD, SMBUS_UNIT_AMPERE_HOUR, -3, SMBUS_VOLATILE, SMBUS_READ_ONLY) \
+  X(FULL_CAPACITY, uint16_t, SMBUS_WIRE_WORD, SMBUS_UNIT_AMPERE_HOUR, -3, SMBUS_VOLATILE, SMBUS_READ_ONLY) \
+  X(RUN_TIME_TO_EMPTY, uint16_t, SMBUS_WIRE_WORD, SMBUS_UNIT_MINUTE, 0, SMBUS_VOLATILE, SMBUS_READ_ONLY) \
+  X(AVG_TIME_TO_EMPTY, uint16_t, SMBUS_WIRE_WORD, SMBUS_UNIT_MINUTE, 0, SMBUS_VOLATILE, SMBUS_READ_ONLY) \
+  X(AVG_TIME_TO_FULL, uint16_t, SMBUS_WIRE_WORD, SMBUS_UNIT_MINUTE, 0, SMBUS_VOLATILE, SMBUS_READ_ONLY) \
+  X(CHARGING_CURRENT, uint16_t, SMBUS_WIRE_WORD, SMBUS_UNIT_AMPERE, -3, SMBUS_VOLATILE, SMBUS_READ_ONLY) \
+  X(CHARGING_VOLTAGE, uint16_t, SMBUS_WIRE_WORD, SMBUS_UNIT_VOLT, -3, SMBUS_VOLATILE, SMBUS_READ_ONLY) \
+  X(BATTERY_STATUS, BatteryStatus, SMBUS_WIRE_WORD, SMBUS_UNIT_NONE, 0, SMBUS_VOLATILE, SMBUS_READ_ONLY) \
+  X(CYCLE_COUNT, uint16_t, SMBUS_WIRE_WORD, SMBUS_UNIT_COUNT, 0, SMBUS_SLOW, SMBUS_READ_ONLY) \
+  X(DESIGN_CAPACITY, uint16_t, SMBUS_WIRE_WORD, SMBUS_UNIT_AMPERE_HOUR, -3, SMBUS_STATIC, SMBUS_READ_ONLY) \
+  X(DESIGN_VOLTAGE, uint16_t, SMBUS_WIRE_WORD, SMBUS_UNIT_VOLT, -3, SMBUS_STATIC, SMBUS_READ_ONLY) \
+  X(MANUFACTURE_DATE, uint16_t, SMBUS_WIRE_WORD, SMBUS_UNIT_DATE, 0, SMBUS_STATIC, SMBUS_READ_ONLY) \
+  X(SERIAL_NUMBER, uint16_t, SMBUS_WIRE_WORD, SMBUS_UNIT_NONE, 0, SMBUS_STATIC, SMBUS_READ_ONLY) \
+  X(MANUFACTURER_NAME, const char*, SMBUS_WIRE_BLOCK, SMBUS_UNIT_NONE, 0, SMBUS_STATIC, SMBUS_READ_ONLY) \
+  X(DEVICE_NAME, const char*, SMBUS_WIRE_BLOCK, SMBUS_UNIT_NONE, 0, SMBUS_STATIC, SMBUS_READ_ONLY) \
+  X(DEVICE_CHEMISTRY, const char*, SMBUS_WIRE_BLOCK, SMBUS_UNIT_NONE, 0, SMBUS_STATIC, SMBUS_READ_ONLY) \
+  X(STATE_OF_HEALTH, uint16_t, SMBUS_WIRE_WORD, SMBUS_UNIT_PERCENT, 0, SMBUS_SLOW, SMBUS_READ_ONLY)
+
+#define SMBUS_REGISTER_INFO(command, type, wire, unit, exponent, volatility, access) \
+  {command, wire, unit, exponent, volatility, access},
+
+static constexpr SMBusRegisterInfo smbusRegisters[] = {SMBUS_REGISTERS(SMBUS_REGISTER_INFO)};
+
+#define SMBUS_REGISTER_COUNT (sizeof(smbusRegisters) / sizeof(smbusRegisters[0]))
+
+/**
+ * @brief Find a register's descriptor at compile time.
+ * @param command SMBus command code.
+ * @param i First index to search from.
+ * @return Index into smbusRegisters, or SMBUS_REGISTER_COUNT if the command is not described.
+ */
+constexpr uint8_t smbusRegisterIndex(uint8_t command, uint8_t i = 0) {
+  return i >= SMBUS_REGISTER_COUNT || smbusRegisters[i].command == command ? i : smbusRegisterIndex(command, i + 1);
+}
+
+/**
+ * @brief Count the registers of a volatility class at compile time.
+ * @param volatility
+ * @param i First index to count from.
+ * @return uint8_t
+ */
+constexpr uint8_t smbusRegisterCount(SMBusVolatility volatility, uint8_t i = 0) {
+  return i >= SMBUS_REGISTER_COUNT ? 0 :
+         (smbusRegisters[i].volatility == volatility) + smbusRegisterCount(volatility, i + 1);
+}
+
+/**
+ * @struct SMBusRegister
+ * @brief Compile-time descriptor of the register with command code Command.
+ * Only specialised for the registers in SMBUS_REGISTERS, so naming any other command is a
+ * compile error.
+ */
+template <uint8_t Command> struct SMBusRegister;
+
+#define SMBUS_REGISTER_TRAITS(command, valueType, wire, unit, exponent, volatility, access) \
+  template <> struct SMBusRegister<command> {                                        \
+    typedef valueType type;                                                          \
+    static constexpr uint8_t index = smbusRegisterIndex(command);                    \
+  };
+
+SMBUS_REGISTERS(SMBUS_REGISTER_TRAITS)
+
+/**
+ * @brief Get the register word of a value passed to ArduinoSMBus::write().
+ * @param value
+ * @return uint16_t
+ */
+constexpr uint16_t smbusWord(uint16_t value) {
+  return value;
+}
+
+constexpr uint16_t smbusWord(int16_t value) {
+  return (uint16_t)value;
+}
+
+constexpr uint16_t smbusWord(BatteryMode mode) {
+  return mode.raw;
+}
+
+/**
+ * @struct SMBusWordWrite
+ * @brief One entry of a batch for ArduinoSMBus::writeRegisters().
+ */
+struct SMBusWordWrite {
+  uint8_t reg;          /**< Command code of the register. */
+  uint16_t value;       /**< Word to write. */
+  uint16_t verifyMask;  /**< Bits that must read back as written, e.g. BATTERY_MODE_WRITABLE. */
+  SMBusStatus status;   /**< Set by writeRegisters(). */
+};
+
+// Register cache
+#ifndef SMBUS_CACHE_SIZE
+#define SMBUS_CACHE_SIZE 12   // Registers that can have a cache policy per ArduinoSMBus object
+#endif
+
+static_assert(smbusRegisterCount(SMBUS_SLOW) + smbusRegisterCount(SMBUS_STATIC) <= SMBUS_CACHE_SIZE,
+              "SMBUS_CACHE_SIZE must hold every register enableCache() caches by default");
+
+/**
+ * @enum SMBusCachePolicy
+ * @brief How a register's value is cached once the cache is enabled.
+ */
+enum SMBusCachePolicy : uint8_t {
+  SMBUS_CACHE_LIVE,       /**< Always read from the battery. */
+  SMBUS_CACHE_TTL,        /**< Reuse the last value until it is older than the register's TTL. */
+  SMBUS_CACHE_IMMUTABLE   /**< Read once, then reuse until invalidated. */
+};
+
+// Non-blocking reads
+#ifndef SMBUS_ASYNC_QUEUE_SIZE
+#define SMBUS_ASYNC_QUEUE_SIZE 4  // Non-blocking reads that can be pending per ArduinoSMBus object
+#endif
+
+/**
+ * @enum SMBusPriority
+ * @brief Priority of a non-blocking read. Higher priorities are served first.
+ */
+enum SMBusPriority : uint8_t {
+  SMBUS_PRIORITY_LOW,     /**< Reads that can wait, e.g. the name strings. */
+  SMBUS_PRIORITY_NORMAL,  /**< The default. */
+  SMBUS_PRIORITY_URGENT   /**< Alarm reads; preempt a lower priority read waiting for its turnaround. */
+};
+#define SMBUS_PRIORITY_COUNT 3
+
+/**
+ * @brief Completion callback for ArduinoSMBus::beginRead() and beginReadBlock().
+ * @param reg Command code that was read.
+ * @param value Register value for word reads, number of bytes stored for block reads.
+ * @param ok True if the read succeeded.
+ * @param context The pointer passed when the read was queued.
+ */
+typedef void (*SMBusReadCallback)(uint8_t reg, uint16_t value, bool ok, void* context);
+
+// Field selection bits for ArduinoSMBus::readSnapshot(), in the order the registers are read
+#define SNAPSHOT_BATTERY_STATUS (1 << 0)
+#define SNAPSHOT_VOLTAGE (1 << 1)
+#define SNAPSHOT_CURRENT (1 << 2)
+#define SNAPSHOT_AVERAGE_CURRENT (1 << 3)
+#define SNAPSHOT_TEMPERATURE (1 << 4)
+#define SNAPSHOT_REL_STATE_OF_CHARGE (1 << 5)
+#define SNAPSHOT_ABS_STATE_OF_CHARGE (1 << 6)
+#define SNAPSHOT_REM_CAPACITY (1 << 7)
+#define SNAPSHOT_FULL_CAPACITY (1 << 8)
+#define SNAPSHOT_RUN_TIME_TO_EMPTY (1 << 9)
+#define SNAPSHOT_AVG_TIME_TO_EMPTY (1 << 10)
+#define SNAPSHOT_AVG_TIME_TO_FULL (1 << 11)
+#define SNAPSHOT_CHARGING_CURRENT (1 << 12)
+#define SNAPSHOT_CHARGING_VOLTAGE (1 << 13)
+#define SNAPSHOT_MAX_ERROR (1 << 14)
+#define SNAPSHOT_ALL 0x7fff
+#define SNAPSHOT_ESSENTIAL (SNAPSHOT_BATTERY_STATUS | SNAPSHOT_VOLTAGE | SNAPSHOT_CURRENT | \
+                            SNAPSHOT_TEMPERATURE | SNAPSHOT_REL_STATE_OF_CHARGE)
+
+/**
+ * @struct BatterySnapshot
+ * @brief The battery's dynamic registers, read together in one pass by readSnapshot().
+ *
+ * Values are the raw register words, in the same units as the corresponding getters.
+ */
+struct BatterySnapshot {
+  uint32_t timestamp;                 /**< millis() when the snapshot was started. */
+  uint32_t duration;                  /**< Time taken to read the snapshot, in microseconds. */
+  uint16_t valid;                     /**< SNAPSHOT_* bits of the fields read successfully. */
+  uint16_t battery_status;            /**< Raw BatteryStatus register. */
+  uint16_t voltage;                   /**< Pack voltage, in mV. */
+  int16_t current;                    /**< Current, in mA, negative when discharging. */
+  int16_t average_current;            /**< One-minute rolling average current, in mA. */
+  uint16_t temperature;               /**< Temperature, in 0.1 K. */
+  uint16_t relative_state_of_charge;  /**< Remaining capacity as a percentage of full capacity. */
+  uint16_t absolute_state_of_charge;  /**< Remaining capacity as a percentage of design capacity. */
+  uint16_t remaining_capacity;        /**< Remaining capacity, in mAh or 10 mWh. */
+  uint16_t full_capacity;             /**< Full charge capacity, in mAh or 10 mWh. */
+  uint16_t run_time_to_empty;         /**< Minutes to empty at the present rate. */
+  uint16_t avg_time_to_empty;         /**< Minutes to empty at the average rate. */
+  uint16_t avg_time_to_full;          /**< Minutes to full at the average rate. */
+  uint16_t charging_current;          /**< Desired charging current, in mA. */
+  uint16_t charging_voltage;          /**< Desired charging voltage, in mV. */
+  uint16_t max_error;                 /**< Expected margin of error of the state of charge, in percent. */
 };
 
 class ArduinoSMBus {
@@ -87,43 +484,388 @@ public:
 
   ArduinoSMBus(uint8_t batteryAddress);
   void setBatteryAddress(uint8_t batteryAddress);
+  void setTurnaround(uint16_t microseconds);
+  void setAdaptiveTurnaround(bool enable);
+  uint16_t turnaround() const;
+  uint16_t splitTurnaround() const;
+  bool adaptiveTurnaround() const;
+  void setDeferredRepeatedStart(bool deferred);
+  bool deferredRepeatedStart() const;
+  void setRetries(uint8_t retries, uint16_t backoffUs = SMBUS_RETRY_BACKOFF_US);
+  void setBusPins(int sda, int scl);
+  bool recoverBus();
+  SMBusStatus lastStatus() const;
+  void enablePEC(bool enable = true);
+  bool pecEnabled() const;
+  uint32_t pecErrors() const;
+  void resetPecErrors();
+
+  SMBusResult readWord(uint8_t reg);
+  SMBusResult readBlock(uint8_t reg, uint8_t* data, uint8_t length);
+  static const SMBusRegisterInfo* registerInfo(uint8_t reg);
+
+  /**
+   * @brief Read a word register as the type its descriptor gives it.
+   * e.g. read<CURRENT>() returns an int16_t and read<BATTERY_STATUS>() a BatteryStatus.
+   * Goes through the cache and retries like the named getters, which are wrappers of this.
+   * @tparam Reg Command code of a register in SMBUS_REGISTERS.
+   * @return The value, or 0 if the read failed (see lastStatus()).
+   */
+  template <uint8_t Reg>
+  typename SMBusRegister<Reg>::type read() {
+    static_assert(smbusRegisters[SMBusRegister<Reg>::index].wireType != SMBUS_WIRE_BLOCK,
+                  "read<>() reads word registers; use the string getters for block registers");
+    return static_cast<typename SMBusRegister<Reg>::type>(readRegister(Reg));
+  }
+
+  SMBusStatus writeRegister(uint8_t reg, uint16_t value);
+  SMBusStatus writeBlock(uint8_t reg, const uint8_t* data, uint8_t length);
+  bool writeRegisters(SMBusWordWrite writes[], uint8_t count);
+
+  /**
+   * @brief Write a register from the type its descriptor gives it, without verifying it.
+   * e.g. write<BATTERY_MODE>(mode) takes a BatteryMode.
+   * @tparam Reg Command code of a SMBUS_READ_WRITE register in SMBUS_REGISTERS.
+   * @param value
+   * @return SMBusStatus
+   */
+  template <uint8_t Reg>
+  SMBusStatus write(typename SMBusRegister<Reg>::type value) {
+    static_assert(smbusRegisters[SMBusRegister<Reg>::index].access == SMBUS_READ_WRITE,
+                  "write<>() needs a register the host may write");
+    return writeRegister(Reg, smbusWord(value));
+  }
+
+  SMBusStatus setRemainingCapacityAlarm(uint16_t capacity);
+  SMBusStatus setRemainingTimeAlarm(uint16_t minutes);
+  SMBusStatus setBatteryMode(BatteryMode mode);
+  SMBusStatus setCapacityMode(bool tenMilliwattHours);
+  SMBusStatus setAlarmMode(bool disableBroadcasts);
+  SMBusStatus setChargerMode(bool disableBroadcasts);
+
+  /**
+   * @brief Get the battery's remaining capacity alarm.
+   * Returns the battery's remaining capacity alarm threshold value, in mAh.
+   * @return uint16_t
+   */
+  uint16_t remainingCapacityAlarm() { return read<REMAINING_CAPACITY_ALARM>(); }
+
+  /**
+   * @brief Get the battery's remaining time alarm.
+   * Returns the battery's remaining time alarm threshold value, in minutes.
+   * @return uint16_t
+   */
+  uint16_t remainingTimeAlarm() { return read<REMAINING_TIME_ALARM>(); }
+
+  /**
+   * @brief Get the battery's mode.
+   *
+   * This method reads the battery's mode register, which contains various settings and status bits.
+   * The returned BatteryMode holds the register word; its fields map to these bits:
+   * - internal_charge_controller: bit 0 of the mode register
+   * - primary_battery_support: bit 1 of the mode register
+   * - condition_flag: bit 7 of the mode register
+   * - charge_controller_enabled: bit 8 of the mode register
+   * - primary_battery: bit 9 of the mode register
+   * - alarm_mode: bit 13 of the mode register
+   * - charger_mode: bit 14 of the mode register
+   * - capacity_mode: bit 15 of the mode register
+   * @return BatteryMode
+   */
+  BatteryMode batteryMode() { return read<BATTERY_MODE>(); }
+
+  /**
+   * @brief Get the battery's temperature.
+   * Returns the battery temperature in Kelvin.
+   * @return uint16_t
+   */
+  uint16_t temperature() { return read<TEMPERATURE>(); }
+
+  int16_t temperatureC();
+  int16_t temperatureF();
+
+  /**
+   * @brief Get the battery's voltage.
+   * Returns the sum of all cell voltages, in mV.
+   * @return uint16_t
+   */
+  uint16_t voltage() { return read<VOLTAGE>(); }
+
+  /**
+   * @brief Get the battery's current.
+   * Returns the battery measured current (from the coulomb counter) in mA, negative when discharging.
+   * @return int16_t
+   */
+  int16_t current() { return read<CURRENT>(); }
+
+  /**
+   * @brief Get the battery's average current.
+   * Returns the average current in a 1-minute rolling average, in mA, negative when discharging.
+   * @return int16_t
+   */
+  int16_t averageCurrent() { return read<AVERAGE_CURRENT>(); }
+  int32_t power();
+  int32_t averagePower();
+
+  /**
+   * @brief Get the battery's state of charge error.
+   * Returns the battery's margin of error when estimating SOC, in percent
+   * @return uint16_t
+   */
+  uint16_t maxError() { return read<MAX_ERROR>(); }
+
+  /**
+   * @brief Get the battery's current relative charge.
+   * Returns the predicted remaining battery capacity as a percentage of fullChargeCapacity()
+   * @return uint16_t
+   */
+  uint16_t relativeStateOfCharge() { return read<REL_STATE_OF_CHARGE>(); }
+
+  /**
+   * @brief Get the battery's absolute charge.
+   * Returns the predicted remaining battery capacity as a percentage of designCapacity()
+   * @return uint16_t
+   */
+  uint16_t absoluteStateOfCharge() { return read<ABS_STATE_OF_CHARGE>(); }
+
+  /**
+   * @brief Get the battery's capacity.
+   * Returns the predicted battery capacity when fully charged, in mAh.
+   * For some batteries, this may be in 10s of mWh, if the BatteryMode() register (0x03) is set that way
+   * See protocol documentation for details.
+   * @return uint16_t
+   */
+  uint16_t remainingCapacity() { return read<REM_CAPACITY>(); }
+
+  /**
+   * @brief Get the battery's full capacity.
+   * Returns the predicted battery capacity when fully charged, in mAh.
+   * For some batteries, this may be in 10s of mWh, if the BatteryMode() register (0x03) is set that way
+   * See protocol documentation for details.
+   * @return uint16_t
+   */
+  uint16_t fullCapacity() { return read<FULL_CAPACITY>(); }
+  uint32_t remainingEnergy();
+  uint32_t fullEnergy();
+
+  /**
+   * @brief Get the battery's time to empty.
+   * Returns the predicted time to empty, in minutes, based on current instantaneous discharge rate.
+   * @return uint16_t
+   */
+  uint16_t runTimeToEmpty() { return read<RUN_TIME_TO_EMPTY>(); }
+
+  /**
+   * @brief Get the battery's average time to empty.
+   * Returns the predicted time to empty, in minutes, based on 1-minute rolling average discharge rate.
+   * @return uint16_t
+   */
+  uint16_t avgTimeToEmpty() { return read<AVG_TIME_TO_EMPTY>(); }
+
+  /**
+   * @brief Get the battery's time to full.
+   * Returns the predicted time to full charge, in minutes, based on 1-minute rolling average charge rate.
+   * @return uint16_t
+   */
+  uint16_t avgTimeToFull() { return read<AVG_TIME_TO_FULL>(); }
+
+  /**
+   * @brief Get the battery's status.
+   *
+   * This function reads the BatteryStatus register and returns a struct with its value.
+   * The BatteryStatus register indicates various alarm conditions and states of the battery.
+   * These include over charge, termination charge, over temperature, termination discharge,
+   * remaining capacity, remaining time, initialization, discharging, fully charged, and fully discharged states.
+   *
+   * @return BatteryStatus A struct containing the status of each bit in the BatteryStatus register.
+   */
+  BatteryStatus batteryStatus() { return read<BATTERY_STATUS>(); }
+
+  /**
+   * @brief Get the battery's design charging current.
+   * Returns the desired design charging current of the battery, in mA.
+   * @return uint16_t
+   */
+  uint16_t chargingCurrent() { return read<CHARGING_CURRENT>(); }
+
+  /**
+   * @brief Get the battery's design charging voltage.
+   * Returns the desired design charging voltage of the battery, in mV.
+   * @return uint16_t
+   */
+  uint16_t chargingVoltage() { return read<CHARGING_VOLTAGE>(); }
 
-  uint16_t remainingCapacityAlarm();
-  uint16_t remainingTimeAlarm();
-  BatteryMode batteryMode();
-  uint16_t temperature();
-  uint16_t temperatureC();
-  uint16_t temperatureF();
-  uint16_t voltage();
-  uint16_t current();
-  uint16_t averageCurrent();
-  uint16_t maxError();
-  uint16_t relativeStateOfCharge();
-  uint16_t absoluteStateOfCharge();
-  uint16_t remainingCapacity();
-  uint16_t fullCapacity();
-  uint16_t runTimeToEmpty();
-  uint16_t avgTimeToEmpty();
-  uint16_t avgTimeToFull();
-  BatteryStatus batteryStatus();
-  uint16_t chargingCurrent();
-  uint16_t chargingVoltage();
   bool statusOK();
-  uint16_t cycleCount();
-  uint16_t designCapacity();
-  uint16_t designVoltage();
-  uint16_t manufactureDate();
+
+  /**
+   * @brief  Get the battery's cycle count.
+   * Returns the number of discharge cycles the battery has experienced.
+   * A cycle is defined as an amount of discharge equal to the battery's design capacity.
+   * @return uint16_t
+   */
+  uint16_t cycleCount() { return read<CYCLE_COUNT>(); }
+
+  /**
+   * @brief Get the battery's design capacity.
+   * Returns the theoretical maximum capacity of the battery, in mAh.
+   * For some batteries, this may be in 10 mWh, if the BatteryMode() register (0x03) is set to CAPM 1.
+   * See TI protocol documentation for details.
+   * @return uint16_t
+   */
+  uint16_t designCapacity() { return read<DESIGN_CAPACITY>(); }
+
+  /**
+   * @brief Get the battery's design voltage.
+   * Returns the nominal voltage of the battery, in mV.
+   * @return uint16_t
+   */
+  uint16_t designVoltage() { return read<DESIGN_VOLTAGE>(); }
+
+  /**
+   * @brief  Get the battery's manufacture date.
+   * Returns the date the battery was manufactured, in the following format:
+   * Day + Month*32 + (Year–1980)*512
+   * @return uint16_t
+   */
+  uint16_t manufactureDate() { return read<MANUFACTURE_DATE>(); }
+
   int manufactureYear();
-  uint16_t serialNumber();
+
+  /**
+   * @brief Get the Serial Number from the battery.
+   *
+   * @return uint16_t
+   */
+  uint16_t serialNumber() { return read<SERIAL_NUMBER>(); }
+
   const char* manufacturerName();
   const char* deviceName();
   const char* deviceChemistry();
-  uint16_t stateOfHealth();
+  uint8_t manufacturerName(char* buffer, uint8_t length);
+  uint8_t deviceName(char* buffer, uint8_t length);
+  uint8_t deviceChemistry(char* buffer, uint8_t length);
+
+  /**
+   * @brief Get the State of Health from the battery.
+   * Returns the estimated health of the battery, as a percentage of design capacity
+   * This command is not supported by all batteries.
+   * @return uint16_t
+   */
+  uint16_t stateOfHealth() { return read<STATE_OF_HEALTH>(); }
+
+  bool readSnapshot(BatterySnapshot& snapshot, uint16_t fields = SNAPSHOT_ALL);
+  static uint8_t readSnapshots(ArduinoSMBus* const batteries[], BatterySnapshot snapshots[],
+                               const uint16_t fields[], uint8_t count);
+  static uint16_t snapshotField(uint8_t reg, const BatterySnapshot& snapshot, const uint16_t*& value);
+
+  SMBusStatus sendCommand(uint8_t reg);
+  SMBusResult receiveWord();
+
+  void enableCache(bool enable = true);
+  bool cacheEnabled() const;
+  bool setCachePolicy(uint8_t reg, SMBusCachePolicy policy, uint32_t ttl = 0);
+  SMBusCachePolicy cachePolicy(uint8_t reg) const;
+  void invalidateCache();
+  void invalidateCache(uint8_t reg);
+  uint32_t cacheHits() const;
+  uint32_t cacheMisses() const;
+  void resetCacheStats();
+
+  bool beginRead(uint8_t reg, SMBusReadCallback callback, void* context = nullptr,
+                 SMBusPriority priority = SMBUS_PRIORITY_NORMAL);
+  bool beginReadBlock(uint8_t reg, uint8_t* data, uint8_t length, SMBusReadCallback callback,
+                      void* context = nullptr, SMBusPriority priority = SMBUS_PRIORITY_NORMAL);
+  bool poll();
+  uint8_t pending() const;
+  uint32_t worstLatency(SMBusPriority priority = SMBUS_PRIORITY_URGENT) const;
+  uint32_t preemptions() const;
+  void resetLatency();
 
 private:
+  struct Turnaround {
+    uint16_t us;
+    uint16_t goodUs;
+    uint8_t streak;
+  };
+
+  struct AsyncRead {
+    uint8_t reg;
+    uint8_t length;
+    uint8_t* data;
+    SMBusReadCallback callback;
+    void* context;
+    SMBusPriority priority;
+    unsigned long queued;
+  };
+
+  enum AsyncState : uint8_t {
+    ASYNC_IDLE,
+    ASYNC_WAITING
+  };
+
+  struct CacheEntry {
+    uint8_t reg;
+    SMBusCachePolicy policy;
+    bool valid;
+    uint16_t value;
+    uint32_t ttl;
+    uint32_t timestamp;
+  };
+
   uint8_t _batteryAddress;
+  Turnaround _turnaround;
+  Turnaround _splitTurnaround;
+  bool _adaptiveTurnaround;
+  bool _deferredRepeatedStart;
+  uint8_t _retries;
+  uint16_t _retryBackoffUs;
+  int _sdaPin;
+  int _sclPin;
+  SMBusStatus _lastStatus;
+  bool _pecEnabled;
+  uint32_t _pecErrors;
+  bool _cacheEnabled;
+  uint8_t _cacheCount;
+  CacheEntry _cache[SMBUS_CACHE_SIZE];
+  uint32_t _cacheHits;
+  uint32_t _cacheMisses;
+  char _manufacturerName[21];
+  char _deviceName[21];
+  char _deviceChemistry[5];
+  AsyncRead _asyncQueue[SMBUS_ASYNC_QUEUE_SIZE];
+  uint8_t _asyncCount;
+  AsyncState _asyncState;
+  unsigned long _asyncStart;
+  uint32_t _asyncWorst[SMBUS_PRIORITY_COUNT];
+  uint32_t _asyncPreemptions;
+  uint8_t _command;
+  bool _commandPending;
+  unsigned long _commandStart;
   uint16_t readRegister(uint8_t reg);
-  void readBlock(uint8_t reg, uint8_t* data, uint8_t len);
+  SMBusStatus wordTransaction(uint8_t reg, uint16_t& value);
+  SMBusStatus blockTransaction(uint8_t reg, uint8_t* data, uint8_t length, uint8_t& count);
+  SMBusStatus writeCommand(uint8_t reg, bool stop);
+  uint8_t wordQuantity() const;
+  uint8_t blockQuantity(uint8_t length) const;
+  uint8_t pecStart(uint8_t reg, bool combined) const;
+  SMBusStatus checkPec(uint8_t crc, uint8_t pec);
+  SMBusStatus receiveWordData(uint8_t reg, bool combined, uint8_t received, uint16_t& value);
+  SMBusStatus receiveBlock(uint8_t reg, bool combined, uint8_t received, uint8_t* data, uint8_t length,
+                           uint8_t& count);
+  SMBusStatus writeTransaction(uint8_t reg, const uint8_t* data, uint8_t length, bool block);
+  void writeCompleted(uint8_t reg);
+  SMBusStatus writeVerified(uint8_t reg, uint16_t value, uint16_t verifyMask);
+  SMBusStatus setModeBits(uint16_t bits, bool set);
+  bool retryAfter(SMBusStatus status, uint8_t attempt);
+  static SMBusStatus writeStatus(uint8_t error);
+  void turnaroundSucceeded(Turnaround& turnaround);
+  bool turnaroundFailed(Turnaround& turnaround);
+  void completeAsync(bool ok, uint16_t value);
+  CacheEntry* cacheEntry(uint8_t reg);
+  bool cacheLookup(uint8_t reg, uint16_t& value);
+  void cacheStore(uint8_t reg, uint16_t value);
+  const char* readString(uint8_t reg, char* buffer, uint8_t length);
+  uint8_t readBlockString(uint8_t reg, char* buffer, uint8_t length);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,91 @@
+/**
+ * @file BatteryBus.h
+ * @brief Fair scheduling of many battery packs on one SMBus.
+ * @version 1.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef BatteryBus_h
+#define BatteryBus_h
+
+#include "ArduinoSMBus.h"
+
+#ifndef BATTERY_BUS_MAX_PACKS
+#define BATTERY_BUS_MAX_PACKS 16      // Packs that can be registered with one BatteryBus
+#endif
+#define BATTERY_BUS_WINDOW_MS 1000    // Window over which per-pack bus share caps are enforced
+#define BATTERY_BUS_BACKOFF_MIN_MS 50   // Backoff after the first failed poll of a pack
+#define BATTERY_BUS_BACKOFF_MAX_MS 5000 // Longest backoff for a pack that keeps failing
+
+/**
+ * @struct BatteryBusPackStats
+ * @brief Per-pack counters kept by BatteryBus.
+ */
+struct BatteryBusPackStats {
+  uint32_t polls;             /**< Snapshots attempted. */
+  uint32_t failures;          /**< Snapshots with at least one field that could not be read. */
+  uint32_t busMicros;         /**< Total time spent on the bus for this pack, in microseconds. */
+  uint8_t consecutiveFailures;/**< Failed snapshots since the last good one. */
+  bool backingOff;            /**< True while the pack is skipped after failures. */
+};
+
+/**
+ * @class BatteryBus
+ * @brief Polls up to BATTERY_BUS_MAX_PACKS batteries on a shared bus with weighted fair scheduling.
+ *
+ * Each call to service() polls one pack, chosen by start-time fair queuing on bus time:
+ * every pack accumulates the bus time it used divided by its weight, and the eligible pack
+ * with the least accumulated time goes next. With equal weights this is round robin
+ * weighted by cost, so a pack that needs a long turnaround gets fewer polls rather than more
+ * bus time. A pack can additionally be capped to a share of the bus per BATTERY_BUS_WINDOW_MS,
+ * and a pack whose poll fails is skipped for an exponentially growing backoff, so one slow
+ * or NACKing pack cannot starve the others.
+ */
+class BatteryBus {
+public:
+  BatteryBus();
+
+  int8_t addPack(ArduinoSMBus& battery, uint8_t weight = 1, uint16_t fields = SNAPSHOT_ESSENTIAL);
+  uint8_t packCount() const;
+  void setWeight(uint8_t pack, uint8_t weight);
+  void setMaxShare(uint8_t pack, uint8_t percent);
+  void setPeriod(uint8_t pack, uint32_t periodMs);
+  void setFields(uint8_t pack, uint16_t fields);
+
+  int8_t service();
+  uint8_t pollAll();
+
+  ArduinoSMBus& battery(uint8_t pack);
+  const BatterySnapshot& snapshot(uint8_t pack) const;
+  const BatteryBusPackStats& stats(uint8_t pack) const;
+
+private:
+  struct Pack {
+    ArduinoSMBus* battery;
+    BatterySnapshot snapshot;
+    BatteryBusPackStats stats;
+    uint16_t fields;
+    uint8_t weight;
+    uint8_t maxShare;
+    uint32_t periodMs;
+    uint32_t virtualTime;
+    uint32_t windowMicros;
+    unsigned long lastPoll;
+    unsigned long backoffStart;
+    uint32_t backoffMs;
+  };
+
+  void rollWindow(unsigned long now);
+  bool eligible(Pack& pack, unsigned long now);
+  void account(Pack& pack, unsigned long now, uint32_t cost, bool ok);
+  uint32_t minimumVirtualTime() const;
+
+  Pack _packs[BATTERY_BUS_MAX_PACKS];
+  uint8_t _count;
+  unsigned long _windowStart;
+};
+
+#endif
@@ -0,0 +1,73 @@
+/**
+ * @file BatteryPoller.h
+ * @brief Background task that owns the bus and publishes battery snapshots.
+ * @version 1.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef BatteryPoller_h
+#define BatteryPoller_h
+
+#include "ArduinoSMBus.h"
+#include "SnapshotPublisher.h"
+#include "AdaptivePollRate.h"
+
+#ifdef SMBUS_HAS_ATOMICS
+
+#ifdef ESP32
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#else
+#include <thread>
+#endif
+
+/**
+ * @class BatteryPoller
+ * @brief Polls a battery from a dedicated task and publishes each snapshot lock-free.
+ *
+ * While the poller is running it is the only user of the battery object and its bus;
+ * other tasks read the published snapshot with latest(), which never blocks and never
+ * touches I2C. On ESP32 the task is a FreeRTOS task, on native builds a std::thread.
+ */
+class BatteryPoller {
+public:
+  BatteryPoller(ArduinoSMBus& battery, uint16_t fields = SNAPSHOT_ALL);
+  ~BatteryPoller();
+
+  bool start(uint32_t periodMs, uint32_t stackSize = 4096, uint8_t priority = 1);
+  void stop();
+  bool running() const;
+  void setRateController(AdaptivePollRate* controller);
+  uint32_t period() const;
+  PollReason periodReason() const;
+
+  bool pollOnce();
+  bool latest(BatterySnapshot& snapshot) const;
+  uint32_t publications() const;
+  const SnapshotPublisher<BatterySnapshot>& publisher() const;
+
+private:
+  static void taskEntry(void* poller);
+  void run();
+
+  ArduinoSMBus& _battery;
+  uint16_t _fields;
+  std::atomic<uint32_t> _periodMs;
+  std::atomic<uint8_t> _periodReason;
+  AdaptivePollRate* _rate;
+  std::atomic<bool> _running;
+  std::atomic<bool> _stopped;
+  SnapshotPublisher<BatterySnapshot> _publisher;
+#ifdef ESP32
+  TaskHandle_t _task;
+#else
+  std::thread _thread;
+#endif
+};
+
+#endif
+
+#endif
@@ -0,0 +1,83 @@
+/**
+ * @file ChangeDetector.h
+ * @brief Deadband filtering of register values, with a callback when a value moves.
+ * @version 1.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef ChangeDetector_h
+#define ChangeDetector_h
+
+#include "ArduinoSMBus.h"
+
+#ifndef CHANGE_DETECTOR_MAX_WATCHES
+#define CHANGE_DETECTOR_MAX_WATCHES 8   // Registers one ChangeDetector can watch
+#endif
+
+/**
+ * @brief Called when a watched register moves by its deadband or more.
+ * @param reg Command code of the register.
+ * @param value New raw register value; cast to int16_t for CURRENT and AVERAGE_CURRENT.
+ * @param previous Value last reported, or value itself on the first report.
+ * @param context The pointer passed to watch().
+ */
+typedef void (*SMBusChangeCallback)(uint8_t reg, uint16_t value, uint16_t previous, void* context);
+
+/**
+ * @class ChangeDetector
+ * @brief Passes on register values only when they move by at least a deadband.
+ *
+ * Each watched register has a deadband in its raw units, e.g. 20 to report moves of 20 mV
+ * or more on VOLTAGE; 0 reports every change. A sample is compared with the last value
+ * reported, not the last value sampled, so a value jittering inside the deadband is never
+ * reported while a slow drift is reported each time it has moved a full deadband. Registers
+ * without a unit, such as BATTERY_STATUS, report any change of their bits. The first sample
+ * of each register is always reported.
+ *
+ * Samples come from the getters through poll(), from a BatterySnapshot through update(),
+ * or from anywhere else through sample(), so downstream code runs only as often as the
+ * battery actually changes.
+ */
+class ChangeDetector {
+public:
+  ChangeDetector(ArduinoSMBus& battery);
+
+  bool watch(uint8_t reg, uint16_t deadband, SMBusChangeCallback callback, void* context = nullptr);
+  bool unwatch(uint8_t reg);
+  bool setDeadband(uint8_t reg, uint16_t deadband);
+  void reset();
+
+  uint8_t poll();
+  uint8_t update(const BatterySnapshot& snapshot);
+  bool sample(uint8_t reg, uint16_t value);
+
+  uint32_t samples() const;
+  uint32_t notifications() const;
+  uint32_t suppressed() const;
+
+private:
+  struct Watch {
+    uint8_t reg;
+    bool isSigned;
+    bool bitField;
+    bool reported;
+    uint16_t deadband;
+    uint16_t value;
+    SMBusChangeCallback callback;
+    void* context;
+  };
+
+  Watch* find(uint8_t reg);
+  bool check(Watch& watch, uint16_t value);
+
+  ArduinoSMBus& _battery;
+  Watch _watches[CHANGE_DETECTOR_MAX_WATCHES];
+  uint8_t _count;
+  uint32_t _samples;
+  uint32_t _notifications;
+};
+
+#endif
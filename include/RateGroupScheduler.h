@@ -0,0 +1,123 @@
+/**
+ * @file RateGroupScheduler.h
+ * @brief Cyclic schedule of register reads at per-register rates.
+ * @version 1.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef RateGroupScheduler_h
+#define RateGroupScheduler_h
+
+#include "ArduinoSMBus.h"
+
+#ifndef RATE_GROUP_MAX_ENTRIES
+#define RATE_GROUP_MAX_ENTRIES 16          // Registers one schedule can read
+#endif
+#define RATE_GROUP_MAX_FRAMES 65535        // Minor frames in a major frame
+#define RATE_GROUP_BUS_HZ 100000           // Default SCL clock assumed for read costs
+#define RATE_GROUP_OVERHEAD_US 50          // Default driver time per transaction assumed for read costs
+#define RATE_GROUP_MAX_UTILISATION 80      // Default percent of a minor frame a schedule may fill
+#define RATE_GROUP_TURNAROUND_AUTO 0xffff   // Charge the battery's fixed turnaround, or the most it can adapt to
+
+/**
+ * @struct RateGroupEntry
+ * @brief One row of a rate table: a word register and how often to read it.
+ */
+struct RateGroupEntry {
+  uint8_t reg;          /**< Command code, e.g. VOLTAGE. */
+  uint32_t periodMs;    /**< Time between reads. */
+};
+
+/**
+ * @enum RateGroupStatus
+ * @brief Result of RateGroupScheduler::configure().
+ */
+enum RateGroupStatus : uint8_t {
+  RATE_GROUP_OK,
+  RATE_GROUP_TOO_MANY,        /**< More than RATE_GROUP_MAX_ENTRIES rows, or none. */
+  RATE_GROUP_BAD_REGISTER,    /**< A row names a register that is not a word register in SMBUS_REGISTERS. */
+  RATE_GROUP_NOT_HARMONIC,    /**< A period is zero or not a multiple of every shorter period. */
+  RATE_GROUP_OVERLOADED       /**< The busiest minor frame exceeds the utilisation limit. */
+};
+
+/**
+ * @class RateGroupScheduler
+ * @brief Reads each register of a rate table at its own rate, in a fixed cyclic schedule.
+ *
+ * configure() builds a rate-monotonic cyclic executive. The shortest period is the minor
+ * frame and the longest the major frame; every period must be a multiple of each shorter
+ * one, as with 100 ms, 1 s and 60 s, so the schedule repeats exactly. Each register is read
+ * once every period / minor frame frames, at a frame offset chosen to spread the slower
+ * registers over the frames the faster ones leave quietest. Within a frame, registers are
+ * read shortest period first.
+ *
+ * The cost of each read is estimated from the bus clock, the per-transaction overhead, PEC
+ * and a bound on the battery's turnaround, and the busiest frame of the whole major frame is
+ * checked against the utilisation limit before the schedule is accepted. While the battery
+ * adapts its turnaround, the bound is SMBUS_TURNAROUND_MAX_US unless setTurnaroundBound()
+ * gives a smaller one, and every frame is also charged one more read for a failed probe of
+ * a shorter turnaround. Other retries are not included, which is what the margin below
+ * 100 % is for.
+ *
+ * service() is called from loop() and runs a frame when it is due; values go to the
+ * callback, which has the same signature as the beginRead() one.
+ */
+class RateGroupScheduler {
+public:
+  RateGroupScheduler(ArduinoSMBus& battery);
+
+  void setBusClock(uint32_t hz);
+  void setTransactionOverhead(uint16_t us);
+  void setMaxUtilisation(uint8_t percent);
+  void setTurnaroundBound(uint16_t us);
+  void onRead(SMBusReadCallback callback, void* context = nullptr);
+
+  RateGroupStatus configure(const RateGroupEntry* table, uint8_t count);
+  uint32_t minorFrame() const;
+  uint32_t majorFrame() const;
+  uint32_t worstFrameMicros() const;
+  uint8_t utilisation() const;
+  uint32_t readCost() const;
+
+  int8_t service();
+  uint16_t frame() const;
+  uint32_t frames() const;
+  uint32_t overruns() const;
+  uint32_t longestFrameMicros() const;
+
+private:
+  struct Slot {
+    uint8_t reg;
+    uint16_t every;     // Minor frames between reads
+    uint16_t offset;    // Minor frame of the first read
+    uint16_t costUs;
+  };
+
+  static uint32_t frameLoad(const Slot* slots, uint8_t count, uint16_t frame);
+
+  ArduinoSMBus& _battery;
+  uint32_t _busHz;
+  uint16_t _overheadUs;
+  uint8_t _maxUtilisation;
+  uint16_t _turnaroundBound;
+  SMBusReadCallback _callback;
+  void* _context;
+
+  Slot _slots[RATE_GROUP_MAX_ENTRIES];
+  uint8_t _count;
+  uint32_t _minorMs;
+  uint16_t _frameCount;
+  uint32_t _worstUs;
+
+  bool _started;
+  uint16_t _frame;
+  unsigned long _frameStart;
+  uint32_t _frames;
+  uint32_t _overruns;
+  uint32_t _longestUs;
+};
+
+#endif
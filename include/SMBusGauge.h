@@ -0,0 +1,151 @@
+/**
+ * @file SMBusGauge.h
+ * @brief Vendor extensions for gauges that expose more than the Smart Battery Data Specification.
+ * @version 1.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef SMBusGauge_h
+#define SMBusGauge_h
+
+#include "ArduinoSMBus.h"
+
+#define MANUFACTURER_BLOCK_ACCESS 0x44   // TI: Write Block a MAC subcommand, Read Block it back with its result
+
+// TI ManufacturerAccess (MAC) subcommands, see docs/datasheets/TI_sluuaq3a.pdf chapter 13
+#define TI_MAC_SAFETY_ALERT 0x0050
+#define TI_MAC_SAFETY_STATUS 0x0051
+#define TI_MAC_PF_ALERT 0x0052
+#define TI_MAC_PF_STATUS 0x0053
+#define TI_MAC_OPERATION_STATUS 0x0054
+#define TI_MAC_CHARGING_STATUS 0x0055
+#define TI_MAC_GAUGING_STATUS 0x0056
+#define TI_MAC_MANUFACTURING_STATUS 0x0057
+#define TI_MAC_DA_STATUS_1 0x0071        // Cell voltages, currents and powers
+#define TI_MAC_DA_STATUS_2 0x0072        // Temperature sensors
+#define TI_OPERATION_STATUS_SEC 0x0300   // OperationStatus SEC1 and SEC0, both set when sealed
+#define TI_CELL_VOLTAGE_1 0x3f           // CellVoltage1(); CellVoltage2() to CellVoltage4() follow at 0x3e to 0x3c
+
+#define GAUGE_MAX_CELLS 4                // Cells in one GaugeCellStatus block
+#define GAUGE_DF_PAGE 32                 // Data flash bytes returned by each ManufacturerBlockAccess() read
+#ifndef GAUGE_DF_WRITE_MAX
+#define GAUGE_DF_WRITE_MAX 27            // Data flash bytes per write: command, length, address, data and PEC fill a 32-byte Wire buffer
+#endif
+
+/**
+ * @struct GaugeCellStatus
+ * @brief Cell voltages, currents and powers sampled together, laid out as TI's DAStatus1 block.
+ * Every field is 16 bits, so the struct has no padding and is the 32 bytes of one SMBus block.
+ */
+struct GaugeCellStatus {
+  uint16_t cell_voltage[GAUGE_MAX_CELLS]; /**< mV, cell 1 first. 0 for cells the pack does not have. */
+  uint16_t bat_voltage;                   /**< Voltage at the BAT pin, in mV. */
+  uint16_t pack_voltage;                  /**< Voltage at the PACK pin, in mV. */
+  int16_t cell_current[GAUGE_MAX_CELLS];  /**< Current measured with each cell voltage, in mA. */
+  int16_t cell_power[GAUGE_MAX_CELLS];    /**< Cell voltage times cell current, in cW. */
+  int16_t power;                          /**< Voltage() times Current(), in cW. */
+  int16_t average_power;                  /**< cW */
+
+  uint16_t imbalance(uint8_t cells = GAUGE_MAX_CELLS) const;
+};
+
+static_assert(sizeof(GaugeCellStatus) == 32, "GaugeCellStatus must match the 32-byte DAStatus1 block");
+
+/**
+ * @struct GaugeTemperatures
+ * @brief Temperature sensors, laid out as TI's DAStatus2 block. All in 0.1 K.
+ */
+struct GaugeTemperatures {
+  uint16_t internal;   /**< Gauge die temperature. */
+  uint16_t ts[4];      /**< External thermistors TS1 to TS4. */
+  uint16_t cell;       /**< Temperature used for the cells. */
+  uint16_t fet;        /**< Temperature used for the FETs. */
+};
+
+static_assert(sizeof(GaugeTemperatures) == 14, "GaugeTemperatures must match the 14-byte DAStatus2 block");
+
+/**
+ * @struct GaugeFamily
+ * @brief How a gauge family exposes its cells and status blocks.
+ * Describe another family with one of these to use SMBusGauge with it. A zero command or
+ * subcommand means the family does not have it.
+ */
+struct GaugeFamily {
+  const char* name;           /**< Family name, the start of its DeviceName(). */
+  uint8_t cells;              /**< Series cells reported, at most GAUGE_MAX_CELLS. */
+  uint8_t cellVoltage;        /**< Word command of cell 1's voltage. */
+  int8_t cellVoltageStep;     /**< Added to the command for each following cell. */
+  uint16_t cellStatus;        /**< MAC subcommand returning a GaugeCellStatus block. */
+  uint16_t temperatures;      /**< MAC subcommand returning a GaugeTemperatures block. */
+  uint8_t aliasFirst;         /**< MAC subcommands aliasFirst to aliasLast can also be read */
+  uint8_t aliasLast;          /**< directly as SBS block commands of the same number. */
+  uint16_t dataFlash;         /**< First data flash address, written to ManufacturerBlockAccess() to read it. */
+  uint16_t dataFlashSize;     /**< Bytes of data flash. */
+};
+
+static constexpr GaugeFamily GAUGE_TI_BQ40Z50 = {
+  "bq40z50", 4, TI_CELL_VOLTAGE_1, -1, TI_MAC_DA_STATUS_1, TI_MAC_DA_STATUS_2, 0x50, 0x72, 0x4000, 0x2000
+};
+static constexpr GaugeFamily GAUGE_TI_BQ4050 = {
+  "bq4050", 4, TI_CELL_VOLTAGE_1, -1, TI_MAC_DA_STATUS_1, TI_MAC_DA_STATUS_2, 0x50, 0x72, 0x4000, 0x2000
+};
+
+/**
+ * @class SMBusGauge
+ * @brief Reads a gauge's manufacturer-specific blocks through an ArduinoSMBus.
+ *
+ * TI gauges run ManufacturerAccess (MAC) subcommands written to ManufacturerBlockAccess()
+ * and return the result on the next block read, so a whole status block costs a write and
+ * a read. Unsealed bq40z50 and bq4050 gauges also answer the status subcommands directly
+ * as SBS block commands, which is a single transaction; readCellStatus() reads all cell
+ * voltages that way instead of one word read per cell. A sealed gauge NACKs those commands,
+ * which some cores report only as an empty read, so when one fails the SEC bits of
+ * OperationStatus are read through ManufacturerBlockAccess, and if they say sealed
+ * SMBusGauge switches to ManufacturerBlockAccess for good.
+ *
+ * Data flash is read a page at a time: after its address is written once, every Read Block
+ * of ManufacturerBlockAccess() returns the next GAUGE_DF_PAGE bytes, so a whole backup is
+ * one write followed by back-to-back reads. Each page comes back with its address and
+ * needs a Wire buffer of at least 35 bytes (36 with PEC), which rules out the 32-byte AVR
+ * buffer. writeDataFlash() rewrites only the bytes that differ from what the gauge holds.
+ */
+class SMBusGauge {
+public:
+  SMBusGauge(ArduinoSMBus& battery, const GaugeFamily& family = GAUGE_TI_BQ40Z50);
+
+  const GaugeFamily& family() const;
+  bool aliases() const;
+  void useAliases(bool enable = true);
+
+  SMBusStatus macCommand(uint16_t subcommand);
+  SMBusResult macRead(uint16_t subcommand, uint8_t* data, uint8_t length);
+  SMBusStatus readFlags(uint16_t subcommand, uint32_t& flags);
+
+  SMBusStatus readCellStatus(GaugeCellStatus& status);
+  SMBusStatus readCellVoltages(uint16_t* voltages);
+  SMBusStatus readTemperatures(GaugeTemperatures& temperatures);
+
+  SMBusStatus readDataFlash(uint16_t address, uint8_t* data, uint16_t length);
+  SMBusStatus writeDataFlash(uint16_t address, const uint8_t* data, uint16_t length,
+                             const uint8_t* current = nullptr);
+  uint16_t pagesWritten() const;
+
+  static const GaugeFamily* findFamily(const char* deviceName);
+
+private:
+  SMBusResult read(uint16_t subcommand, uint8_t* data, uint8_t length);
+  bool sealed();
+  bool inDataFlash(uint16_t address, uint16_t length) const;
+  SMBusStatus readDataFlashPage(uint16_t address, uint8_t* data, uint8_t length, bool& addressed);
+  SMBusStatus writeDataFlashSpan(uint16_t address, const uint8_t* data, uint8_t length);
+
+  ArduinoSMBus& _battery;
+  const GaugeFamily* _family;
+  bool _aliases;
+  uint16_t _pagesWritten;
+};
+
+#endif
@@ -0,0 +1,103 @@
+/**
+ * @file SMBusHostListener.h
+ * @brief Receives AlarmWarning and charger broadcasts sent by smart batteries.
+ * @version 1.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef SMBusHostListener_h
+#define SMBusHostListener_h
+
+#include "ArduinoSMBus.h"
+
+#define SMBUS_HOST_ADDRESS 0x08       // SMBus Host (0x10 as a write address)
+#define SMBUS_CHARGER_ADDRESS 0x09    // Smart Battery Charger (0x12 as a write address)
+
+#ifndef SMBUS_LISTENER_QUEUE_SIZE
+#define SMBUS_LISTENER_QUEUE_SIZE 8   // Broadcasts held between poll() calls, a power of two
+#endif
+
+static_assert((SMBUS_LISTENER_QUEUE_SIZE & (SMBUS_LISTENER_QUEUE_SIZE - 1)) == 0 && SMBUS_LISTENER_QUEUE_SIZE <= 128,
+              "SMBUS_LISTENER_QUEUE_SIZE must be a power of two up to 128");
+
+/**
+ * @brief Called for each AlarmWarning received.
+ * @param battery 7-bit address of the battery that sent it.
+ * @param status The battery's BatteryStatus at the time of the alarm.
+ * @param context The pointer passed to onAlarm().
+ */
+typedef void (*SMBusAlarmCallback)(uint8_t battery, BatteryStatus status, void* context);
+
+/**
+ * @brief Called for each ChargingCurrent or ChargingVoltage broadcast received.
+ * @param command CHARGING_CURRENT or CHARGING_VOLTAGE.
+ * @param value Requested current in mA or voltage in mV.
+ * @param context The pointer passed to onCharger().
+ */
+typedef void (*SMBusChargerCallback)(uint8_t command, uint16_t value, void* context);
+
+/**
+ * @class SMBusHostListener
+ * @brief Listens as an I2C target for the messages a smart battery sends as bus master.
+ *
+ * A battery whose BatteryMode alarm_mode bit is clear sends AlarmWarning to the SMBus Host
+ * and the charger as soon as an alarm is set, and one whose charger_mode bit is clear sends
+ * its ChargingCurrent and ChargingVoltage to the charger. Listening for them lets the regular
+ * polling drop to a slow heartbeat without delaying alarms.
+ *
+ * Messages are parsed in the Wire receive handler, which runs in interrupt context on AVR,
+ * and queued; callbacks run from poll(), called from loop(). Only one listener can be active
+ * at a time, because the Wire handler has no context pointer.
+ *
+ * At SMBUS_HOST_ADDRESS only AlarmWarning arrives. At SMBUS_CHARGER_ADDRESS the charging
+ * broadcasts arrive too, which is useful when no real charger is on the bus. On ESP32 the
+ * controller used for ArduinoSMBus cannot also be a target, so use a second controller
+ * (Wire1) connected to the same bus.
+ */
+class SMBusHostListener {
+public:
+  SMBusHostListener(TwoWire& wire);
+  ~SMBusHostListener();
+
+  bool begin(uint8_t address = SMBUS_HOST_ADDRESS);
+  void end();
+  void onAlarm(SMBusAlarmCallback callback, void* context = nullptr);
+  void onCharger(SMBusChargerCallback callback, void* context = nullptr);
+  void enablePEC(bool enable = true);
+
+  uint8_t poll();
+  uint8_t pending() const;
+  uint32_t received() const;
+  uint32_t dropped() const;
+  uint32_t pecErrors() const;
+
+private:
+  struct Message {
+    uint8_t command;
+    uint16_t value;
+  };
+
+  static void receiveEvent(int length);
+  void receive();
+
+  static SMBusHostListener* _active;
+
+  TwoWire& _wire;
+  uint8_t _address;
+  bool _pecEnabled;
+  SMBusAlarmCallback _alarmCallback;
+  void* _alarmContext;
+  SMBusChargerCallback _chargerCallback;
+  void* _chargerContext;
+  Message _queue[SMBUS_LISTENER_QUEUE_SIZE];
+  volatile uint8_t _head;
+  volatile uint8_t _tail;
+  volatile uint32_t _received;
+  volatile uint32_t _dropped;
+  volatile uint32_t _pecErrors;
+};
+
+#endif
@@ -0,0 +1,61 @@
+/**
+ * @file SMBusPEC.h
+ * @brief SMBus Packet Error Code (CRC-8, polynomial x^8 + x^2 + x + 1).
+ * @version 1.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef SMBusPEC_h
+#define SMBusPEC_h
+
+#include <Arduino.h>
+
+#define SMBUS_PEC_POLYNOMIAL 0x07
+
+// Define SMBUS_PEC_NIBBLE_TABLE to use a 16-byte table instead of the 256-byte one.
+// It takes two lookups per byte instead of one, in exchange for 240 bytes of flash.
+
+/**
+ * @brief Shift one bit of the PEC register, MSB first.
+ * Usable in constant expressions, so the lookup tables are computed by the compiler.
+ * @param crc
+ * @return uint8_t
+ */
+constexpr uint8_t smbusPecShift(uint8_t crc) {
+  return (crc & 0x80) ? (uint8_t)((crc << 1) ^ SMBUS_PEC_POLYNOMIAL) : (uint8_t)(crc << 1);
+}
+
+/**
+ * @brief PEC of a register value shifted through the given number of bits.
+ * smbusPecEntry(i) is entry i of the byte table; for i < 16 it is also entry i of the nibble table.
+ * @param crc
+ * @param bits
+ * @return uint8_t
+ */
+constexpr uint8_t smbusPecEntry(uint8_t crc, uint8_t bits = 8) {
+  return bits == 0 ? crc : smbusPecEntry(smbusPecShift(crc), bits - 1);
+}
+
+uint8_t smbusPecByteTable(uint8_t crc, uint8_t data);
+uint8_t smbusPecByteNibble(uint8_t crc, uint8_t data);
+
+/**
+ * @brief Add one byte to a running PEC, using the table selected at compile time.
+ * @param crc PEC of the bytes so far, 0 at the start of a message.
+ * @param data
+ * @return uint8_t
+ */
+inline uint8_t smbusPecByte(uint8_t crc, uint8_t data) {
+#ifdef SMBUS_PEC_NIBBLE_TABLE
+  return smbusPecByteNibble(crc, data);
+#else
+  return smbusPecByteTable(crc, data);
+#endif
+}
+
+uint8_t smbusPec(const uint8_t* data, size_t length, uint8_t crc = 0);
+
+#endif
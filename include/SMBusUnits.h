@@ -0,0 +1,100 @@
+/**
+ * @file SMBusUnits.h
+ * @brief Integer-only fixed-point conversions of Smart Battery register values.
+ * @version 1.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef SMBusUnits_h
+#define SMBusUnits_h
+
+#include <Arduino.h>
+
+// Every conversion here uses only shifts, adds and integer multiplies, so it costs a few
+// dozen cycles on an AVR instead of a soft-float or long division call. Results are
+// rounded to nearest and saturate instead of wrapping. Halves are rounded away from zero,
+// except by smbusDeciFahrenheit(), which rounds them up.
+
+#define SMBUS_DECI_KELVIN_AT_0C 2731    // 273.1 K, rounding 273.15 K so that 0.05 K steps round up
+
+/**
+ * @brief Saturate a 32-bit value to int16_t.
+ * @param value
+ * @return int16_t
+ */
+constexpr int16_t smbusSaturate16(int32_t value) {
+  return value > 32767 ? 32767 : value < -32768 ? -32768 : (int16_t)value;
+}
+
+/**
+ * @brief Divide by 1000, rounding down, without a division.
+ * Uses 1024 = 1000 + 24: x / 1000 = (x >> 10) + ((x >> 10) * 24 + (x & 1023)) / 1000,
+ * and the second term is reduced the same way until it is below 1024. At most five steps
+ * for any 32-bit value.
+ * @param x
+ * @param quotient Accumulated quotient, 0 for the first call.
+ * @return uint32_t
+ */
+constexpr uint32_t smbusDivide1000(uint32_t x, uint32_t quotient = 0) {
+  return x < 1024 ? quotient + (x >= 1000)
+                  : smbusDivide1000((x >> 10) * 24 + (x & 1023), quotient + (x >> 10));
+}
+
+/**
+ * @brief Divide a 16-bit value by 10, rounding down, without a division.
+ * 52429 / 2^19 is close enough to 1/10 to be exact for every 16-bit value.
+ * @param x
+ * @return uint16_t
+ */
+constexpr uint16_t smbusDivide10(uint16_t x) {
+  return (uint16_t)(((uint32_t)x * 52429UL) >> 19);
+}
+
+/**
+ * @brief Convert a Temperature() register value to 0.1 degrees Celsius.
+ * @param deciKelvin Temperature in 0.1 K.
+ * @return int16_t -2731 to 32767, saturating above 3276.7 degrees.
+ */
+constexpr int16_t smbusDeciCelsius(uint16_t deciKelvin) {
+  return smbusSaturate16((int32_t)deciKelvin - SMBUS_DECI_KELVIN_AT_0C);
+}
+
+/**
+ * @brief Convert a Temperature() register value to 0.1 degrees Fahrenheit.
+ * Exact rounding, halves up, of 1.8 * deciKelvin - 4596.7. With deciKelvin = 10q + r this is
+ * 18q - 4597 + (18r + 8) / 10, and the last term (at most 17) is divided by multiplying
+ * with 205 / 2048.
+ * @param deciKelvin Temperature in 0.1 K.
+ * @return int16_t -4597 to 32767, saturating above 3276.7 degrees.
+ */
+constexpr int16_t smbusDeciFahrenheit(uint16_t deciKelvin) {
+  return smbusSaturate16(18L * smbusDivide10(deciKelvin) - 4597 +
+                         ((18 * (deciKelvin - 10 * smbusDivide10(deciKelvin)) + 8) * 205 >> 11));
+}
+
+/**
+ * @brief Power from a voltage and a current.
+ * @param millivolts Voltage() or DesignVoltage().
+ * @param milliamps Current() or AverageCurrent(), negative when discharging.
+ * @return int32_t Power in mW, negative when discharging.
+ */
+constexpr int32_t smbusMilliwatts(uint16_t millivolts, int16_t milliamps) {
+  return milliamps < 0 ? -(int32_t)smbusDivide1000((uint32_t)millivolts * (uint32_t)(-(int32_t)milliamps) + 500)
+                       : (int32_t)smbusDivide1000((uint32_t)millivolts * (uint32_t)milliamps + 500);
+}
+
+/**
+ * @brief Energy of a capacity register, honouring BatteryMode capacity_mode.
+ * @param capacity RemainingCapacity(), FullChargeCapacity() or DesignCapacity().
+ * @param millivolts Voltage the capacity is delivered at, used when capacity is in mAh.
+ * @param capacityMode BatteryMode capacity_mode: false if capacity is in mAh, true if in 10 mWh.
+ * @return uint32_t Energy in mWh.
+ */
+constexpr uint32_t smbusMilliwattHours(uint16_t capacity, uint16_t millivolts, bool capacityMode) {
+  return capacityMode ? (uint32_t)capacity * 10 : smbusDivide1000((uint32_t)capacity * millivolts + 500);
+}
+
+#endif
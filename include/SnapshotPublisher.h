@@ -0,0 +1,130 @@
+/**
+ * @file SnapshotPublisher.h
+ * @brief Lock-free single-writer, multi-reader publication of snapshots.
+ * @version 1.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef SnapshotPublisher_h
+#define SnapshotPublisher_h
+
+#if defined(ESP32) || defined(ARDUINO_SMBUS_NATIVE)
+#define SMBUS_HAS_ATOMICS 1
+#endif
+
+#ifdef SMBUS_HAS_ATOMICS
+
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+#include <type_traits>
+
+/**
+ * @class SnapshotPublisher
+ * @brief A two-slot sequence lock holding the latest value of a trivially copyable type.
+ *
+ * One writer calls publish(); any number of readers call read() from any task or
+ * thread. Neither side ever takes a lock. The writer fills the slot not holding the
+ * latest value, making the sequence odd while it does and even again when done, so
+ * a reader always copies a completed value and never waits for a publish() in
+ * progress. A reader only retries if the writer finished a whole publication and
+ * started overwriting the reader's slot during the copy, which cannot happen when
+ * the reader has preempted the writer. Readers therefore never see a half-written
+ * value and can never delay the writer.
+ *
+ * The value is stored as relaxed atomic words so concurrent reads and writes are
+ * well defined in C++.
+ *
+ * @tparam T Type of the published value.
+ */
+template <typename T>
+class SnapshotPublisher {
+  static_assert(std::is_trivially_copyable<T>::value, "SnapshotPublisher needs a trivially copyable type");
+
+public:
+  SnapshotPublisher() : _sequence(0) {
+    for (size_t i = 0; i < 2 * WORDS; i++) {
+      _words[i].store(0, std::memory_order_relaxed);
+    }
+  }
+
+  /**
+   * @brief Publish a new value. Must only be called from one task at a time.
+   * @param value
+   */
+  void publish(const T& value) {
+    uint32_t buffer[WORDS] = {0};
+    memcpy(buffer, &value, sizeof(T));
+
+    uint32_t sequence = _sequence.load(std::memory_order_relaxed);
+    std::atomic<uint32_t>* slot = _words + slotOf(sequence / 2 + 1);
+    _sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (size_t i = 0; i < WORDS; i++) {
+      slot[i].store(buffer[i], std::memory_order_relaxed);
+    }
+    _sequence.store(sequence + 2, std::memory_order_release);
+  }
+
+  /**
+   * @brief Make one attempt to copy the latest value.
+   * @param value Receives the value if the attempt succeeded.
+   * @return bool False if the writer overwrote the slot during the copy, in which case
+   * value is unspecified.
+   */
+  bool tryRead(T& value) const {
+    uint32_t before = _sequence.load(std::memory_order_acquire);
+    const std::atomic<uint32_t>* slot = _words + slotOf(before / 2);
+    uint32_t buffer[WORDS];
+    for (size_t i = 0; i < WORDS; i++) {
+      buffer[i] = slot[i].load(std::memory_order_relaxed);
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    // The slot of publication n is next written by publication n + 2, which starts at 2n + 3
+    if (_sequence.load(std::memory_order_relaxed) - (before & ~1u) >= 3) {
+      return false;
+    }
+    memcpy(&value, buffer, sizeof(T));
+    return true;
+  }
+
+  /**
+   * @brief Copy the latest value, retrying if the writer overtook the copy.
+   * Never waits for a publish() in progress.
+   * @param value
+   */
+  void read(T& value) const {
+    while (!tryRead(value)) {
+    }
+  }
+
+  /**
+   * @brief Get the number of values published so far.
+   * @return uint32_t
+   */
+  uint32_t publications() const {
+    return _sequence.load(std::memory_order_acquire) / 2;
+  }
+
+private:
+  static const size_t WORDS = (sizeof(T) + sizeof(uint32_t) - 1) / sizeof(uint32_t);
+
+  /**
+   * @brief Get the offset of the slot holding a publication.
+   * @param publication Number of the publication, counting from 0 for the initial value.
+   * @return size_t
+   */
+  static size_t slotOf(uint32_t publication) {
+    return (publication & 1) * WORDS;
+  }
+
+  std::atomic<uint32_t> _sequence;
+  std::atomic<uint32_t> _words[2 * WORDS];
+};
+
+#endif
+
+#endif
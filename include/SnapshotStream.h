@@ -0,0 +1,107 @@
+/**
+ * @file SnapshotStream.h
+ * @brief Compact binary encoding of BatterySnapshot streams, and its decoder.
+ * @version 1.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef SnapshotStream_h
+#define SnapshotStream_h
+
+#include "ArduinoSMBus.h"
+
+#define SNAPSHOT_STREAM_SYNC 0xa5          // First byte of every record
+#define SNAPSHOT_STREAM_VERSION 1          // Format version, the high nibble of the second byte
+#define SNAPSHOT_STREAM_KEYFRAME 0x01      // Flag in the second byte: values are not deltas
+#define SNAPSHOT_STREAM_HEADER 4           // Sync, version and flags, field mask
+#define SNAPSHOT_STREAM_FIELDS 15          // Word fields of a BatterySnapshot, one per SNAPSHOT_* bit
+#define SNAPSHOT_STREAM_MAX_RECORD (SNAPSHOT_STREAM_HEADER + 5 + 2 + 3 * (SNAPSHOT_STREAM_FIELDS - 1) + 1)
+
+#ifndef SNAPSHOT_STREAM_KEYFRAME_INTERVAL
+#define SNAPSHOT_STREAM_KEYFRAME_INTERVAL 32   // Records between keyframes, where a decoder can join
+#endif
+
+/**
+ * @enum SnapshotStreamStatus
+ * @brief Result of SnapshotDecoder::decode().
+ */
+enum SnapshotStreamStatus : uint8_t {
+  SNAPSHOT_STREAM_OK,           // A record was decoded
+  SNAPSHOT_STREAM_INCOMPLETE,   // The data ends inside a record; call again with more
+  SNAPSHOT_STREAM_CORRUPT,      // Bad version, varint or CRC; skipped to the next sync byte
+  SNAPSHOT_STREAM_UNSYNCED,     // A valid delta record before any keyframe; skipped
+};
+
+/**
+ * @class SnapshotEncoder
+ * @brief Writes snapshots to a Print as compact binary records.
+ *
+ * Each record is:
+ *   - SNAPSHOT_STREAM_SYNC
+ *   - SNAPSHOT_STREAM_VERSION << 4, ORed with SNAPSHOT_STREAM_KEYFRAME on keyframes
+ *   - the snapshot's valid mask, 16 bits little-endian
+ *   - the timestamp as a varint: the change since the previous record, or millis() on keyframes
+ *   - the raw BatteryStatus word, little-endian, if its bit is in the mask
+ *   - each other field in the mask, in SNAPSHOT_* bit order, as a zigzag varint of its change
+ *     since the last record that had it, or of its value on keyframes
+ *   - the SMBus CRC-8 of all the bytes above
+ *
+ * Varints carry 7 bits a byte, least significant first, with the top bit set on all but the
+ * last byte. A record of the SNAPSHOT_ESSENTIAL fields polled once a second is typically
+ * 12 to 14 bytes. The duration field is not sent.
+ *
+ * Bytes go straight to the Print as they are produced; the encoder keeps only the values
+ * of the previous record.
+ */
+class SnapshotEncoder {
+public:
+  SnapshotEncoder(Print& out, uint16_t keyframeInterval = SNAPSHOT_STREAM_KEYFRAME_INTERVAL);
+
+  size_t write(const BatterySnapshot& snapshot);
+  void keyframe();
+  uint32_t records() const;
+
+private:
+  void put(uint8_t value);
+  void putVarint(uint32_t value);
+
+  Print& _out;
+  uint16_t _keyframeInterval;
+  uint16_t _sinceKeyframe;
+  uint32_t _records;
+  uint8_t _crc;
+  size_t _written;
+  uint32_t _timestamp;
+  uint16_t _values[SNAPSHOT_STREAM_FIELDS];
+};
+
+/**
+ * @class SnapshotDecoder
+ * @brief Turns a byte stream written by SnapshotEncoder back into snapshots.
+ *
+ * Plain C++ with no Arduino dependencies beyond the types, meant for gateways as much as for
+ * devices. Feed it whatever bytes have arrived; it decodes one record per call and says how
+ * far it got, so a record split across two reads is picked up on the next call. After a
+ * corrupt record it skips delta records until the next keyframe.
+ */
+class SnapshotDecoder {
+public:
+  SnapshotDecoder();
+
+  SnapshotStreamStatus decode(const uint8_t*& data, const uint8_t* end, BatterySnapshot& snapshot);
+  void reset();
+  uint32_t decoded() const;
+  uint32_t errors() const;
+
+private:
+  bool _synced;
+  uint32_t _decoded;
+  uint32_t _errors;
+  uint32_t _timestamp;
+  uint16_t _values[SNAPSHOT_STREAM_FIELDS];
+};
+
+#endif
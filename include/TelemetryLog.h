@@ -0,0 +1,313 @@
+/**
+ * @file TelemetryLog.h
+ * @brief Fixed-capacity history of battery readings for post-mortem analysis.
+ * @version 1.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef TelemetryLog_h
+#define TelemetryLog_h
+
+#include "ArduinoSMBus.h"
+#include "SnapshotPublisher.h"
+
+#ifdef SMBUS_HAS_ATOMICS
+
+#define TELEMETRY_DELTA_SECONDS 0x8000      // Delta flag: the other 15 bits count seconds, not ms
+#define TELEMETRY_DELTA_MAX 0x7fff          // Largest delta in either unit, about 9 hours in seconds
+#define TELEMETRY_TEMPERATURE_MIN 2231      // Lowest temperature recorded, -50.0 C in 0.1 K
+#define TELEMETRY_TEMPERATURE_SPAN 0x07ff   // Temperatures are kept in 11 bits above the minimum
+#define TELEMETRY_SOC_MAX 0x7f              // States of charge are kept in 7 bits
+
+/**
+ * @struct TelemetryRecord
+ * @brief One reading taken back out of a TelemetryLog.
+ */
+struct TelemetryRecord {
+  uint32_t timestamp;                 /**< millis() of the reading. */
+  uint16_t voltage;                   /**< Pack voltage, in mV. */
+  int16_t current;                    /**< Current, in mA, negative when discharging. */
+  uint16_t temperature;               /**< Temperature, in 0.1 K, clamped to -50.0 C to +154.7 C. */
+  uint8_t relative_state_of_charge;   /**< Percent, clamped to 127. */
+  uint16_t battery_status;            /**< Raw BatteryStatus register, reserved bits 10 and 13 clear. */
+};
+
+/**
+ * @class TelemetryLog
+ * @brief A circular log of timestamped voltage, current, temperature, state of charge and status.
+ *
+ * The storage is a member array, so the log lives wherever it is declared and never touches
+ * the heap. append() is O(1) and overwrites the oldest record once the log is full. Each
+ * record is packed into five 16-bit words:
+ *
+ *   0. Time since the previous record, in ms, or in s when bit 15 is set
+ *   1. Voltage
+ *   2. Current
+ *   3. Temperature above TELEMETRY_TEMPERATURE_MIN in bits 0-10, state of charge bits 0-4 above
+ *   4. State of charge bits 5-6, then BatteryStatus without its reserved bits 10 and 13
+ *
+ * At 10 bytes a record, three hours of 1 Hz readings take 108 KB. A delta in seconds is only
+ * used after a gap of more than 32.7 s; the log keeps the timestamps it has rounded, so the
+ * rounding never accumulates. Gaps longer than about 9 hours are shortened to that.
+ *
+ * One task appends; any number of tasks iterate at the same time without ever delaying it.
+ * Records are stored as relaxed atomic words, and the index of the oldest record is raised
+ * before a slot is overwritten, so a reader checks after copying a record that it still
+ * belonged to the log. A reader the writer laps skips ahead to the oldest record still held.
+ *
+ * @tparam N Number of records held.
+ */
+template <size_t N>
+class TelemetryLog {
+  static_assert(N >= 2, "TelemetryLog needs room for at least two records");
+  static_assert(sizeof(std::atomic<uint16_t>) == sizeof(uint16_t), "TelemetryLog needs plain 16-bit atomics");
+
+  static const size_t WORDS = 5;
+
+  struct Cursor {
+    uint32_t first;            // Index of the oldest record held
+    uint32_t end;              // One past the index of the newest record
+    uint32_t first_timestamp;  // Timestamp of the oldest record
+  };
+
+public:
+  /**
+   * @class Iterator
+   * @brief Walks the log from the oldest record to the newest present when end() was called.
+   */
+  class Iterator {
+  public:
+    const TelemetryRecord& operator*() const {
+      return _record;
+    }
+
+    const TelemetryRecord* operator->() const {
+      return &_record;
+    }
+
+    Iterator& operator++() {
+      _index++;
+      if (_index < _log->_end.load(std::memory_order_acquire)) {
+        uint16_t words[WORDS];
+        if (_log->load(_index, words)) {
+          _record.timestamp += decodeDelta(words[0]);
+          decode(words, _record);
+        } else {
+          resync();
+        }
+      }
+      return *this;
+    }
+
+    /**
+     * @brief True while this iterator has not reached other.
+     * A lapped iterator can jump past end(), so this compares positions rather than testing
+     * for equality.
+     */
+    bool operator!=(const Iterator& other) const {
+      return _index < other._index;
+    }
+
+    /**
+     * @brief Get the number of records overwritten before this iterator reached them.
+     * @return uint32_t
+     */
+    uint32_t skipped() const {
+      return _skipped;
+    }
+
+  private:
+    friend class TelemetryLog;
+
+    Iterator(const TelemetryLog* log, uint32_t end) : _log(log), _index(end), _skipped(0) {
+      _record = TelemetryRecord();
+    }
+
+    Iterator(const TelemetryLog* log) : _log(log), _skipped(0) {
+      Cursor cursor;
+      _log->_cursor.read(cursor);
+      _index = cursor.first;
+      _record = TelemetryRecord();
+      _record.timestamp = cursor.first_timestamp;
+      uint16_t words[WORDS];
+      if (_index < cursor.end) {
+        if (_log->load(_index, words)) {
+          decode(words, _record);
+        } else {
+          resync();
+        }
+      }
+    }
+
+    /**
+     * @brief Restart at the oldest record still held after the writer overwrote the next one.
+     */
+    void resync() {
+      uint16_t words[WORDS];
+      do {
+        Cursor cursor;
+        _log->_cursor.read(cursor);
+        _skipped += cursor.first - _index;
+        _index = cursor.first;
+        _record.timestamp = cursor.first_timestamp;
+      } while (!_log->load(_index, words));
+      decode(words, _record);
+    }
+
+    const TelemetryLog* _log;
+    uint32_t _index;
+    uint32_t _skipped;
+    TelemetryRecord _record;
+  };
+
+  TelemetryLog() : _first(0), _end(0), _firstTimestamp(0), _lastTimestamp(0) {
+    for (size_t i = 0; i < N * WORDS; i++) {
+      _words[i].store(0, std::memory_order_relaxed);
+    }
+    _cursor.publish(Cursor{0, 0, 0});
+  }
+
+  /**
+   * @brief Add a reading, overwriting the oldest once the log is full. Must only be called
+   * from one task at a time.
+   * @param timestamp millis() of the reading, no earlier than that of the previous one.
+   * @param voltage mV
+   * @param current mA
+   * @param temperature 0.1 K
+   * @param relativeStateOfCharge Percent.
+   * @param batteryStatus Raw BatteryStatus register.
+   */
+  void append(uint32_t timestamp, uint16_t voltage, int16_t current, uint16_t temperature,
+              uint8_t relativeStateOfCharge, uint16_t batteryStatus) {
+    uint32_t index = _end.load(std::memory_order_relaxed);
+    uint16_t delta = 0;
+    if (index == 0) {
+      _firstTimestamp = timestamp;
+      _lastTimestamp = timestamp;
+    } else {
+      delta = encodeDelta(timestamp - _lastTimestamp);
+      _lastTimestamp += decodeDelta(delta);
+    }
+
+    if (index >= N) {
+      // The record after the one overwritten becomes the oldest
+      uint32_t first = index - N + 1;
+      _firstTimestamp += decodeDelta(_words[(first % N) * WORDS].load(std::memory_order_relaxed));
+      _first.store(first, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_release);
+    }
+
+    if (temperature < TELEMETRY_TEMPERATURE_MIN) {
+      temperature = TELEMETRY_TEMPERATURE_MIN;
+    } else if (temperature > TELEMETRY_TEMPERATURE_MIN + TELEMETRY_TEMPERATURE_SPAN) {
+      temperature = TELEMETRY_TEMPERATURE_MIN + TELEMETRY_TEMPERATURE_SPAN;
+    }
+    if (relativeStateOfCharge > TELEMETRY_SOC_MAX) {
+      relativeStateOfCharge = TELEMETRY_SOC_MAX;
+    }
+    uint16_t status = (batteryStatus & 0x03ff) | ((batteryStatus & 0x1800) >> 1) | ((batteryStatus & 0xc000) >> 2);
+
+    std::atomic<uint16_t>* slot = &_words[(index % N) * WORDS];
+    slot[0].store(delta, std::memory_order_relaxed);
+    slot[1].store(voltage, std::memory_order_relaxed);
+    slot[2].store((uint16_t)current, std::memory_order_relaxed);
+    slot[3].store((temperature - TELEMETRY_TEMPERATURE_MIN) | ((relativeStateOfCharge & 0x1f) << 11),
+                  std::memory_order_relaxed);
+    slot[4].store((relativeStateOfCharge >> 5) | (status << 2), std::memory_order_relaxed);
+    _end.store(index + 1, std::memory_order_release);
+
+    _cursor.publish(Cursor{_first.load(std::memory_order_relaxed), index + 1, _firstTimestamp});
+  }
+
+  /**
+   * @brief Add the essential fields of a snapshot.
+   * @param snapshot Read with at least the SNAPSHOT_ESSENTIAL fields.
+   * @return bool False, and nothing added, if any of those fields is not valid.
+   */
+  bool append(const BatterySnapshot& snapshot) {
+    if ((snapshot.valid & SNAPSHOT_ESSENTIAL) != SNAPSHOT_ESSENTIAL) {
+      return false;
+    }
+    append(snapshot.timestamp, snapshot.voltage, snapshot.current, snapshot.temperature,
+           (uint8_t)snapshot.relative_state_of_charge, snapshot.battery_status);
+    return true;
+  }
+
+  Iterator begin() const {
+    return Iterator(this);
+  }
+
+  Iterator end() const {
+    return Iterator(this, _end.load(std::memory_order_acquire));
+  }
+
+  /**
+   * @brief Get the number of records held.
+   * @return size_t
+   */
+  size_t size() const {
+    uint32_t end = _end.load(std::memory_order_acquire);
+    return end < N ? end : N;
+  }
+
+  static constexpr size_t capacity() {
+    return N;
+  }
+
+  /**
+   * @brief Get the number of records appended since construction, including overwritten ones.
+   * @return uint32_t
+   */
+  uint32_t appended() const {
+    return _end.load(std::memory_order_acquire);
+  }
+
+private:
+  static uint16_t encodeDelta(uint32_t delta) {
+    if (delta <= TELEMETRY_DELTA_MAX) {
+      return delta;
+    }
+    delta /= 1000;
+    return TELEMETRY_DELTA_SECONDS | (delta > TELEMETRY_DELTA_MAX ? TELEMETRY_DELTA_MAX : delta);
+  }
+
+  static uint32_t decodeDelta(uint16_t delta) {
+    return (delta & TELEMETRY_DELTA_SECONDS) ? (delta & TELEMETRY_DELTA_MAX) * 1000UL : delta;
+  }
+
+  static void decode(const uint16_t* words, TelemetryRecord& record) {
+    uint16_t status = words[4] >> 2;
+    record.voltage = words[1];
+    record.current = (int16_t)words[2];
+    record.temperature = (words[3] & TELEMETRY_TEMPERATURE_SPAN) + TELEMETRY_TEMPERATURE_MIN;
+    record.relative_state_of_charge = (words[3] >> 11) | ((words[4] & 0x03) << 5);
+    record.battery_status = (status & 0x03ff) | ((status & 0x0c00) << 1) | ((status & 0x3000) << 2);
+  }
+
+  /**
+   * @brief Copy a record's words.
+   * @return bool False if the record was overwritten, in which case words are unspecified.
+   */
+  bool load(uint32_t index, uint16_t* words) const {
+    const std::atomic<uint16_t>* slot = &_words[(index % N) * WORDS];
+    for (size_t i = 0; i < WORDS; i++) {
+      words[i] = slot[i].load(std::memory_order_relaxed);
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return _first.load(std::memory_order_relaxed) <= index;
+  }
+
+  std::atomic<uint16_t> _words[N * WORDS];
+  std::atomic<uint32_t> _first;
+  std::atomic<uint32_t> _end;
+  SnapshotPublisher<Cursor> _cursor;
+  uint32_t _firstTimestamp;   // Only used by the writer
+  uint32_t _lastTimestamp;
+};
+
+#endif
+
+#endif
@@ -0,0 +1,87 @@
+/**
+ * @file Arduino.cpp
+ * @brief Simulated clock for host-native builds.
+ * @version 1.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "Arduino.h"
+
+#include <atomic>
+
+#include "SimBus.h"
+
+#define SIM_PINS 64
+
+static std::atomic<uint64_t> simClockNs(0);
+static uint8_t pinModes[SIM_PINS];
+static uint8_t pinLevels[SIM_PINS];
+
+uint64_t simNanos() {
+  return simClockNs.load(std::memory_order_relaxed);
+}
+
+void simAdvanceNanos(uint64_t ns) {
+  simClockNs.fetch_add(ns, std::memory_order_relaxed);
+}
+
+unsigned long millis() {
+  return (unsigned long)(simNanos() / 1000000ULL);
+}
+
+unsigned long micros() {
+  return (unsigned long)(simNanos() / 1000ULL);
+}
+
+void delay(unsigned long ms) {
+  simAdvanceNanos((uint64_t)ms * 1000000ULL);
+}
+
+void delayMicroseconds(unsigned int us) {
+  simAdvanceNanos((uint64_t)us * 1000ULL);
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {
+  if (pin >= SIM_PINS) {
+    return;
+  }
+  pinModes[pin] = mode;
+  if (pin == SCL) {
+    SimBus::instance().driveScl(mode == OUTPUT ? pinLevels[pin] : HIGH);
+  }
+}
+
+/**
+ * @brief Set a pin's output latch. Driving SCL clocks the simulated bus, as when
+ * bit-banging bus recovery.
+ * @param pin
+ * @param value
+ */
+void digitalWrite(uint8_t pin, uint8_t value) {
+  if (pin >= SIM_PINS) {
+    return;
+  }
+  pinLevels[pin] = value ? HIGH : LOW;
+  if (pin == SCL && pinModes[pin] == OUTPUT) {
+    SimBus::instance().driveScl(pinLevels[pin]);
+  }
+}
+
+/**
+ * @brief Read a pin. SDA and SCL are open-drain with pull-ups: either the host or a
+ * target can pull them low.
+ * @param pin
+ * @return int
+ */
+int digitalRead(uint8_t pin) {
+  if (pin >= SIM_PINS) {
+    return LOW;
+  }
+  if (pin == SDA && !SimBus::instance().sdaReleased()) {
+    return LOW;
+  }
+  return pinModes[pin] == OUTPUT ? pinLevels[pin] : HIGH;
+}
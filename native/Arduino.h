@@ -0,0 +1,69 @@
+/**
+ * @file Arduino.h
+ * @brief Minimal Arduino core shim for host-native (Linux) builds.
+ * @version 1.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ * Only the parts of the Arduino API used by ArduinoSMBus are provided. Time is
+ * simulated: millis() and micros() report a virtual clock that only moves when
+ * delay() is called or when the simulated I2C bus is busy, which makes bus
+ * benchmarks deterministic and independent of the host's speed.
+ */
+
+#ifndef Arduino_h
+#define Arduino_h
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "Print.h"
+
+#ifndef ARDUINO_SMBUS_NATIVE
+#define ARDUINO_SMBUS_NATIVE 1
+#endif
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH 0x1
+#define LOW 0x0
+
+#define INPUT 0x0
+#define OUTPUT 0x1
+#define INPUT_PULLUP 0x2
+
+// Flash is ordinary memory on the host
+#define PROGMEM
+#define pgm_read_byte(address) (*(const uint8_t*)(address))
+
+// Pins wired to the simulated bus, numbered as on an ESP32 DevKit
+static const uint8_t SDA = 21;
+static const uint8_t SCL = 22;
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+
+/**
+ * @brief Current value of the simulated clock, in nanoseconds.
+ * Unlike micros() this does not wrap, so it is the preferred time base for benchmarks.
+ * @return uint64_t
+ */
+uint64_t simNanos();
+
+/**
+ * @brief Advance the simulated clock.
+ * Used by the simulated bus to account for time spent clocking bits on the wire.
+ * @param ns
+ */
+void simAdvanceNanos(uint64_t ns);
+
+#endif
@@ -0,0 +1,107 @@
+/**
+ * @file Print.cpp
+ * @brief Print formatting and stdout-backed Serial for host-native builds.
+ * @version 1.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "Print.h"
+
+#include <stdio.h>
+#include <string.h>
+
+HardwareSerial Serial;
+
+size_t Print::write(const uint8_t* buffer, size_t size) {
+  size_t n = 0;
+  while (size--) {
+    n += write(*buffer++);
+  }
+  return n;
+}
+
+size_t Print::write(const char* str) {
+  if (str == nullptr) {
+    return 0;
+  }
+  return write(reinterpret_cast<const uint8_t*>(str), strlen(str));
+}
+
+size_t Print::print(const char* str) {
+  return write(str);
+}
+
+size_t Print::print(char c) {
+  return write(static_cast<uint8_t>(c));
+}
+
+size_t Print::print(unsigned char n, int base) {
+  return printNumber(n, base);
+}
+
+size_t Print::print(int n, int base) {
+  return print(static_cast<long long>(n), base);
+}
+
+size_t Print::print(unsigned int n, int base) {
+  return printNumber(n, base);
+}
+
+size_t Print::print(long n, int base) {
+  return print(static_cast<long long>(n), base);
+}
+
+size_t Print::print(unsigned long n, int base) {
+  return printNumber(n, base);
+}
+
+size_t Print::print(long long n, int base) {
+  if (base == DEC && n < 0) {
+    size_t count = print('-');
+    return count + printNumber(0ULL - static_cast<unsigned long long>(n), base);
+  }
+  return printNumber(static_cast<unsigned long long>(n), base);
+}
+
+size_t Print::print(unsigned long long n, int base) {
+  return printNumber(n, base);
+}
+
+size_t Print::print(double n, int digits) {
+  char buffer[48];
+  snprintf(buffer, sizeof(buffer), "%.*f", digits, n);
+  return write(buffer);
+}
+
+size_t Print::println() {
+  return write("\r\n");
+}
+
+size_t Print::printNumber(unsigned long long n, int base) {
+  char buffer[8 * sizeof(n) + 1];
+  char* str = &buffer[sizeof(buffer) - 1];
+  *str = '\0';
+
+  if (base < 2) {
+    base = 10;
+  }
+
+  do {
+    char digit = static_cast<char>(n % base);
+    n /= base;
+    *--str = digit < 10 ? digit + '0' : digit + 'A' - 10;
+  } while (n);
+
+  return write(str);
+}
+
+size_t HardwareSerial::write(uint8_t c) {
+  return fputc(c, stdout) == EOF ? 0 : 1;
+}
+
+size_t HardwareSerial::write(const uint8_t* buffer, size_t size) {
+  return fwrite(buffer, 1, size, stdout);
+}
@@ -0,0 +1,76 @@
+/**
+ * @file Print.h
+ * @brief Minimal Print class and Serial object for host-native builds.
+ * @version 1.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef Print_h
+#define Print_h
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define DEC 10
+#define HEX 16
+#define OCT 8
+#define BIN 2
+
+/**
+ * @class Print
+ * @brief Byte sink with the Arduino print()/println() formatting helpers.
+ */
+class Print {
+public:
+  virtual ~Print() {}
+
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t* buffer, size_t size);
+  size_t write(const char* str);
+
+  size_t print(const char* str);
+  size_t print(char c);
+  size_t print(unsigned char n, int base = DEC);
+  size_t print(int n, int base = DEC);
+  size_t print(unsigned int n, int base = DEC);
+  size_t print(long n, int base = DEC);
+  size_t print(unsigned long n, int base = DEC);
+  size_t print(long long n, int base = DEC);
+  size_t print(unsigned long long n, int base = DEC);
+  size_t print(double n, int digits = 2);
+
+  size_t println();
+  template <typename T>
+  size_t println(T value) {
+    size_t n = print(value);
+    return n + println();
+  }
+  template <typename T>
+  size_t println(T value, int format) {
+    size_t n = print(value, format);
+    return n + println();
+  }
+
+private:
+  size_t printNumber(unsigned long long n, int base);
+};
+
+/**
+ * @class HardwareSerial
+ * @brief Serial port stand-in that writes to the process's standard output.
+ */
+class HardwareSerial : public Print {
+public:
+  void begin(unsigned long baud) { (void)baud; }
+  size_t write(uint8_t c) override;
+  size_t write(const uint8_t* buffer, size_t size) override;
+  using Print::write;
+  operator bool() const { return true; }
+};
+
+extern HardwareSerial Serial;
+
+#endif
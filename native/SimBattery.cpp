@@ -0,0 +1,608 @@
+/**
+ * @file SimBattery.cpp
+ * @brief Register-level simulation of a Smart Battery Data Specification v1.1 device.
+ * @version 1.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "SimBattery.h"
+
+#include <string.h>
+
+#include "Arduino.h"
+#include "ArduinoSMBus.h"
+#include "SMBusGauge.h"
+
+#define SIM_AT_RATE 0x04
+#define SIM_AT_RATE_TIME_TO_EMPTY 0x06
+#define SIM_SPECIFICATION_INFO 0x1a
+
+// BatteryMode bits the host is allowed to change: CHGC_EN, PB, AM, CHGM, CAPM
+#define SIM_BATTERY_MODE_WRITABLE 0xe300
+
+/**
+ * @brief Add a byte to a PEC, bit by bit, independently of the library's table-driven version.
+ * @param crc
+ * @param data
+ * @return uint8_t
+ */
+static uint8_t pecByte(uint8_t crc, uint8_t data) {
+  crc ^= data;
+  for (int bit = 0; bit < 8; bit++) {
+    crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+  }
+  return crc;
+}
+
+/**
+ * @brief Construct a battery with plausible values for a 4S Li-ion pack.
+ * @param address 7-bit SMBus address
+ */
+SimBattery::SimBattery(uint8_t address) : _address(address), _command(0), _commandPending(false),
+    _commandNanos(0), _turnaroundUs(0), _clockStretching(true), _pec(false), _sealed(false), _mac(0), _dataFlashWrites(0), _reads(0), _writes(0), _nacks(0) {
+  memset(_words, 0, sizeof(_words));
+  memset(&_manufacturerName, 0, sizeof(Block));
+  memset(&_deviceName, 0, sizeof(Block));
+  memset(&_deviceChemistry, 0, sizeof(Block));
+  memset(&_manufacturerData, 0, sizeof(Block));
+  memset(_flags, 0, sizeof(_flags));
+  for (size_t i = 0; i < SIM_DATA_FLASH_SIZE; i++) {
+    _dataFlash[i] = static_cast<uint8_t>(i * 7 + (i >> 8)); // Any pattern that differs from page to page
+  }
+
+  _words[MANUFACTURER_ACCESS] = 0x0000;
+  _words[REMAINING_CAPACITY_ALARM] = 300;
+  _words[REMAINING_TIME_ALARM] = 10;
+  _words[BATTERY_MODE] = 0x6001;
+  _words[SIM_AT_RATE] = 0;
+  _words[0x05] = 0xffff;  // AtRateTimeToFull
+  _words[SIM_AT_RATE_TIME_TO_EMPTY] = 0xffff;
+  _words[0x07] = 1;       // AtRateOK
+  _words[TEMPERATURE] = 2982;
+  _words[VOLTAGE] = 15840;
+  _words[CURRENT] = static_cast<uint16_t>(-1250);
+  _words[AVERAGE_CURRENT] = static_cast<uint16_t>(-1198);
+  _words[MAX_ERROR] = 2;
+  _words[REL_STATE_OF_CHARGE] = 87;
+  _words[ABS_STATE_OF_CHARGE] = 82;
+  _words[REM_CAPACITY] = 2697;
+  _words[FULL_CAPACITY] = 3100;
+  _words[RUN_TIME_TO_EMPTY] = 129;
+  _words[AVG_TIME_TO_EMPTY] = 135;
+  _words[AVG_TIME_TO_FULL] = 0xffff;
+  _words[CHARGING_CURRENT] = 1600;
+  _words[CHARGING_VOLTAGE] = 16800;
+  _words[BATTERY_STATUS] = 0x00c0;
+  _words[CYCLE_COUNT] = 41;
+  _words[DESIGN_CAPACITY] = 3300;
+  _words[DESIGN_VOLTAGE] = 14400;
+  _words[SIM_SPECIFICATION_INFO] = 0x0031;
+  _words[MANUFACTURE_DATE] = 1 + 6 * 32 + (2023 - 1980) * 512;
+  _words[SERIAL_NUMBER] = 0x1234;
+  _words[STATE_OF_HEALTH] = 94;
+  _words[TI_CELL_VOLTAGE_1] = 3962;
+  _words[TI_CELL_VOLTAGE_1 - 1] = 3958;
+  _words[TI_CELL_VOLTAGE_1 - 2] = 3965;
+  _words[TI_CELL_VOLTAGE_1 - 3] = 3955;
+  _flags[TI_MAC_OPERATION_STATUS - SIM_MAC_FLAGS_FIRST] = 0x00000207; // PRES, DSG, CHG, unsealed
+
+  setString(MANUFACTURER_NAME, "Texas Instruments");
+  setString(DEVICE_NAME, "bq40z50-R2");
+  setString(DEVICE_CHEMISTRY, "LION");
+  setString(MANUFACTURER_DATA, "");
+}
+
+SimBattery::~SimBattery() {
+  detach();
+}
+
+/**
+ * @brief Attach the battery to the shared simulated bus at its address.
+ */
+void SimBattery::attach() {
+  SimBus::instance().attach(_address, this);
+}
+
+void SimBattery::detach() {
+  if (SimBus::instance().device(_address) == this) {
+    SimBus::instance().detach(_address);
+  }
+}
+
+uint8_t SimBattery::address() const {
+  return _address;
+}
+
+/**
+ * @brief Set the value returned by a word command, bypassing write protection.
+ * @param command
+ * @param value
+ */
+void SimBattery::setWord(uint8_t command, uint16_t value) {
+  _words[command] = value;
+}
+
+uint16_t SimBattery::word(uint8_t command) const {
+  return _words[command];
+}
+
+/**
+ * @brief Set the contents returned by a block command.
+ * @param command
+ * @param data
+ * @param length Truncated to SIM_BATTERY_MAX_BLOCK.
+ */
+void SimBattery::setBlock(uint8_t command, const uint8_t* data, uint8_t length) {
+  Block* target = block(command);
+  if (target == nullptr) {
+    return;
+  }
+  if (length > SIM_BATTERY_MAX_BLOCK) {
+    length = SIM_BATTERY_MAX_BLOCK;
+  }
+  memcpy(target->data, data, length);
+  target->length = length;
+}
+
+void SimBattery::setString(uint8_t command, const char* str) {
+  size_t length = strlen(str);
+  setBlock(command, reinterpret_cast<const uint8_t*>(str),
+           static_cast<uint8_t>(length > SIM_BATTERY_MAX_BLOCK ? SIM_BATTERY_MAX_BLOCK : length));
+}
+
+/**
+ * @brief Set how long the gauge needs between a command and valid data.
+ * @param us
+ */
+void SimBattery::setTurnaroundMicros(uint32_t us) {
+  _turnaroundUs = us;
+}
+
+uint32_t SimBattery::turnaroundMicros() const {
+  return _turnaroundUs;
+}
+
+/**
+ * @brief Choose whether an early read through a repeated START is stretched or NACKed.
+ * @param enable
+ */
+void SimBattery::setClockStretching(bool enable) {
+  _clockStretching = enable;
+}
+
+/**
+ * @brief Choose whether reads are followed by a PEC byte, if the master clocks one.
+ * @param enable
+ */
+void SimBattery::setPEC(bool enable) {
+  _pec = enable;
+}
+
+/**
+ * @brief Seal or unseal the gauge. A sealed gauge NACKs the SBS aliases of MAC subcommands.
+ * @param sealed
+ */
+void SimBattery::setSealed(bool sealed) {
+  _sealed = sealed;
+  uint32_t& operation = _flags[TI_MAC_OPERATION_STATUS - SIM_MAC_FLAGS_FIRST];
+  operation = (operation & ~0x300UL) | (sealed ? 0x300UL : 0x200UL); // SEC1 and SEC0
+}
+
+/**
+ * @brief Set the flags returned by one of the status subcommands, SafetyAlert to ManufacturingStatus.
+ * @param subcommand
+ * @param flags
+ */
+void SimBattery::setFlags(uint16_t subcommand, uint32_t flags) {
+  if (subcommand >= SIM_MAC_FLAGS_FIRST && subcommand < SIM_MAC_FLAGS_FIRST + SIM_MAC_FLAGS_COUNT) {
+    _flags[subcommand - SIM_MAC_FLAGS_FIRST] = flags;
+  }
+}
+
+/**
+ * @brief Get the data flash contents, SIM_DATA_FLASH_SIZE bytes from SIM_DATA_FLASH.
+ * @return uint8_t*
+ */
+uint8_t* SimBattery::dataFlash() {
+  return _dataFlash;
+}
+
+/**
+ * @brief Get the number of data flash writes received.
+ * @return uint32_t
+ */
+uint32_t SimBattery::dataFlashWrites() const {
+  return _dataFlashWrites;
+}
+
+/**
+ * @brief Set alarm bits in BatteryStatus and broadcast AlarmWarning to the host and charger.
+ * Nothing is broadcast while the BatteryMode AlarmMode bit is set.
+ * @param alarms BATTERY_STATUS_* alarm bits.
+ * @return uint8_t Number of broadcasts acknowledged.
+ */
+uint8_t SimBattery::raiseAlarm(uint16_t alarms) {
+  _words[BATTERY_STATUS] |= alarms;
+  if (_words[BATTERY_MODE] & BATTERY_MODE_ALARM_MODE) {
+    return 0;
+  }
+  // AlarmWarning is a Write Word whose command code is the sender's address
+  uint8_t acked = broadcast(SIM_HOST_ADDRESS, _address << 1, _words[BATTERY_STATUS]) == 0;
+  acked += broadcast(SIM_CHARGER_ADDRESS, _address << 1, _words[BATTERY_STATUS]) == 0;
+  return acked;
+}
+
+/**
+ * @brief Broadcast ChargingCurrent and ChargingVoltage to the charger.
+ * Nothing is broadcast while the BatteryMode ChargerMode bit is set.
+ * @return uint8_t Number of broadcasts acknowledged.
+ */
+uint8_t SimBattery::broadcastChargingValues() {
+  if (_words[BATTERY_MODE] & BATTERY_MODE_CHARGER_MODE) {
+    return 0;
+  }
+  uint8_t acked = broadcast(SIM_CHARGER_ADDRESS, CHARGING_CURRENT, _words[CHARGING_CURRENT]) == 0;
+  acked += broadcast(SIM_CHARGER_ADDRESS, CHARGING_VOLTAGE, _words[CHARGING_VOLTAGE]) == 0;
+  return acked;
+}
+
+/**
+ * @brief Send a Write Word as bus master, followed by a PEC if PEC is enabled.
+ * @param address 7-bit address of the receiver.
+ * @param command
+ * @param value
+ * @return uint8_t Bus status as Wire.endTransmission(): 0 if acknowledged.
+ */
+uint8_t SimBattery::broadcast(uint8_t address, uint8_t command, uint16_t value) {
+  uint8_t message[4] = {command, static_cast<uint8_t>(value & 0xff), static_cast<uint8_t>(value >> 8), 0};
+  size_t length = 3;
+  if (_pec) {
+    uint8_t crc = pecByte(0, address << 1);
+    for (size_t i = 0; i < length; i++) {
+      crc = pecByte(crc, message[i]);
+    }
+    message[length++] = crc;
+  }
+  return SimBus::instance().write(address, message, length, true);
+}
+
+uint32_t SimBattery::reads() const {
+  return _reads;
+}
+
+uint32_t SimBattery::writes() const {
+  return _writes;
+}
+
+uint32_t SimBattery::nacks() const {
+  return _nacks;
+}
+
+void SimBattery::resetCounters() {
+  _reads = 0;
+  _writes = 0;
+  _nacks = 0;
+}
+
+/**
+ * @brief Latch a command, or apply a Write Word or Write Block.
+ * A write longer than its protocol needs carries a PEC, which must match.
+ * @param data
+ * @param length
+ * @return bool
+ */
+bool SimBattery::onWrite(const uint8_t* data, size_t length) {
+  _writes++;
+  if (length == 0) {
+    return true; // Quick command, used by bus scanners
+  }
+
+  uint8_t command = data[0];
+  if ((!isWordCommand(command) && !isBlockCommand(command)) || (_sealed && isAliasCommand(command))) {
+    _commandPending = false;
+    _nacks++;
+    return false;
+  }
+
+  if (length >= 2 && isBlockCommand(command)) {
+    _commandPending = false;
+    size_t needed = 2 + data[1];
+    if (data[1] > SIM_BATTERY_MAX_BLOCK || length < needed || length > needed + 1 ||
+        (length > needed && !pecMatches(data, length)) || !writeBlock(command, data + 2, data[1])) {
+      _nacks++;
+      return false;
+    }
+    return true;
+  }
+
+  if (length >= 3) {
+    _commandPending = false;
+    if (length > 4 || (length == 4 && !pecMatches(data, length)) ||
+        !writeWord(command, static_cast<uint16_t>(data[1] | (data[2] << 8)))) {
+      _nacks++;
+      return false;
+    }
+    return true;
+  }
+
+  _command = command;
+  _commandPending = true;
+  _commandNanos = simNanos();
+  return true;
+}
+
+/**
+ * @brief Clock out the data for the latched command.
+ * @param data
+ * @param length
+ * @param repeatedStart
+ * @return size_t
+ */
+size_t SimBattery::onRead(uint8_t* data, size_t length, bool repeatedStart) {
+  if (!_commandPending) {
+    _nacks++;
+    return 0;
+  }
+
+  uint64_t readyNanos = _commandNanos + static_cast<uint64_t>(_turnaroundUs) * 1000ULL;
+  uint64_t now = simNanos();
+  if (now < readyNanos) {
+    if (!repeatedStart || !_clockStretching) {
+      _nacks++;
+      return 0;
+    }
+    simAdvanceNanos(readyNanos - now); // Hold SCL low until the data is ready
+  }
+
+  _commandPending = false;
+  _reads++;
+
+  size_t count = 0;
+  Block result;
+  const Block* source = block(_command);
+  if (source == nullptr && macBlock(_command, result)) {
+    source = &result;
+  }
+  if (source != nullptr) {
+    if (count < length) {
+      data[count++] = source->length;
+    }
+    for (uint8_t i = 0; i < source->length && count < length; i++) {
+      data[count++] = source->data[i];
+    }
+  } else {
+    uint16_t value = _words[_command];
+    if (count < length) {
+      data[count++] = value & 0xff;
+    }
+    if (count < length) {
+      data[count++] = value >> 8;
+    }
+  }
+
+  // The PEC covers every byte since the last START, including the address bytes
+  if (_pec && count < length) {
+    uint8_t crc = 0;
+    if (repeatedStart) {
+      crc = pecByte(crc, _address << 1);
+      crc = pecByte(crc, _command);
+    }
+    crc = pecByte(crc, (_address << 1) | 1);
+    for (size_t i = 0; i < count; i++) {
+      crc = pecByte(crc, data[i]);
+    }
+    data[count++] = crc;
+  }
+  return length;
+}
+
+/**
+ * @brief Check if a command is one of the SBS block (string) commands.
+ * @param command
+ * @return bool
+ */
+bool SimBattery::isBlockCommand(uint8_t command) {
+  return command == MANUFACTURER_NAME || command == DEVICE_NAME || command == DEVICE_CHEMISTRY ||
+         command == MANUFACTURER_DATA || command == MANUFACTURER_BLOCK_ACCESS || isAliasCommand(command);
+}
+
+/**
+ * @brief Check if a command is an SBS word command implemented by the simulation.
+ * @param command
+ * @return bool
+ */
+bool SimBattery::isWordCommand(uint8_t command) {
+  return command <= SIM_SPECIFICATION_INFO || command == MANUFACTURE_DATE || command == SERIAL_NUMBER ||
+         command == STATE_OF_HEALTH || (command >= TI_CELL_VOLTAGE_1 - 3 && command <= TI_CELL_VOLTAGE_1);
+}
+
+/**
+ * @brief Check if a command reads a MAC subcommand's result directly, as unsealed TI gauges allow.
+ * @param command
+ * @return bool
+ */
+bool SimBattery::isAliasCommand(uint8_t command) {
+  return (command >= SIM_MAC_FLAGS_FIRST && command < SIM_MAC_FLAGS_FIRST + SIM_MAC_FLAGS_COUNT) ||
+         command == TI_MAC_DA_STATUS_1 || command == TI_MAC_DA_STATUS_2;
+}
+
+SimBattery::Block* SimBattery::block(uint8_t command) {
+  return const_cast<Block*>(static_cast<const SimBattery*>(this)->block(command));
+}
+
+const SimBattery::Block* SimBattery::block(uint8_t command) const {
+  switch (command) {
+    case MANUFACTURER_NAME:
+      return &_manufacturerName;
+    case DEVICE_NAME:
+      return &_deviceName;
+    case DEVICE_CHEMISTRY:
+      return &_deviceChemistry;
+    case MANUFACTURER_DATA:
+      return &_manufacturerData;
+    default:
+      return nullptr;
+  }
+}
+
+/**
+ * @brief Check the PEC that ends a write, computed over the write address and every byte.
+ * @param data Bytes after the address, the last being the PEC.
+ * @param length
+ * @return bool
+ */
+bool SimBattery::pecMatches(const uint8_t* data, size_t length) const {
+  uint8_t crc = pecByte(0, _address << 1);
+  for (size_t i = 0; i < length - 1; i++) {
+    crc = pecByte(crc, data[i]);
+  }
+  return crc == data[length - 1];
+}
+
+/**
+ * @brief Apply an SBS Write Block.
+ * ManufacturerBlockAccess takes a MAC subcommand. ManufacturerData also accepts a block,
+ * so that block writes can be exercised.
+ * @param command
+ * @param data
+ * @param length
+ * @return bool False if the register is read-only.
+ */
+bool SimBattery::writeBlock(uint8_t command, const uint8_t* data, uint8_t length) {
+  if (command == MANUFACTURER_BLOCK_ACCESS && length >= 2) {
+    uint16_t subcommand = static_cast<uint16_t>(data[0] | (data[1] << 8));
+    if (length > 2) {
+      // Data flash write: the address, then the new contents
+      if (subcommand < SIM_DATA_FLASH || subcommand + length - 2 > SIM_DATA_FLASH + SIM_DATA_FLASH_SIZE) {
+        return false;
+      }
+      memcpy(_dataFlash + (subcommand - SIM_DATA_FLASH), data + 2, length - 2);
+      _dataFlashWrites++;
+    }
+    manufacturerAccess(subcommand);
+    return true;
+  }
+  if (command != MANUFACTURER_DATA) {
+    return false;
+  }
+  setBlock(command, data, length);
+  return true;
+}
+
+/**
+ * @brief Apply an SBS Write Word, honouring which registers are writable.
+ * @param command
+ * @param value
+ * @return bool False if the register is read-only.
+ */
+bool SimBattery::writeWord(uint8_t command, uint16_t value) {
+  switch (command) {
+    case MANUFACTURER_ACCESS:
+      _words[command] = value;
+      manufacturerAccess(value);
+      return true;
+    case REMAINING_CAPACITY_ALARM:
+    case REMAINING_TIME_ALARM:
+    case SIM_AT_RATE:
+      _words[command] = value;
+      return true;
+    case BATTERY_MODE:
+      _words[command] = (_words[command] & ~SIM_BATTERY_MODE_WRITABLE) | (value & SIM_BATTERY_MODE_WRITABLE);
+      return true;
+    default:
+      return false;
+  }
+}
+
+/**
+ * @brief Run a MAC subcommand. Its result is returned by ManufacturerBlockAccess(), after
+ * the subcommand, and by ManufacturerData().
+ * @param subcommand
+ */
+void SimBattery::manufacturerAccess(uint16_t subcommand) {
+  _mac = subcommand;
+  _manufacturerData.length = macResult(subcommand, _manufacturerData.data);
+}
+
+/**
+ * @brief Build the result of a MAC subcommand from the simulated registers.
+ * @param subcommand
+ * @param data At least SIM_BATTERY_MAX_BLOCK bytes.
+ * @return uint8_t Length of the result, 0 for subcommands that return nothing.
+ */
+uint8_t SimBattery::macResult(uint16_t subcommand, uint8_t* data) const {
+  uint16_t words[16];
+  uint8_t count = 0;
+  int16_t current = static_cast<int16_t>(_words[CURRENT]);
+  if (subcommand >= SIM_MAC_FLAGS_FIRST && subcommand < SIM_MAC_FLAGS_FIRST + SIM_MAC_FLAGS_COUNT) {
+    uint32_t flags = _flags[subcommand - SIM_MAC_FLAGS_FIRST];
+    words[count++] = static_cast<uint16_t>(flags);
+    words[count++] = static_cast<uint16_t>(flags >> 16);
+  } else if (subcommand == TI_MAC_DA_STATUS_1) {
+    uint16_t bat = 0;
+    for (int cell = 0; cell < 4; cell++) {
+      words[count++] = _words[TI_CELL_VOLTAGE_1 - cell];
+      bat += _words[TI_CELL_VOLTAGE_1 - cell];
+    }
+    words[count++] = bat;
+    words[count++] = bat - 6; // PACK pin, behind the FETs
+    for (int cell = 0; cell < 4; cell++) {
+      words[count++] = static_cast<uint16_t>(current);
+    }
+    for (int cell = 0; cell < 4; cell++) {
+      words[count++] = static_cast<uint16_t>(_words[TI_CELL_VOLTAGE_1 - cell] * current / 10000); // cW
+    }
+    words[count++] = static_cast<uint16_t>(_words[VOLTAGE] * current / 10000);
+    words[count++] = static_cast<uint16_t>(_words[VOLTAGE] * static_cast<int16_t>(_words[AVERAGE_CURRENT]) / 10000);
+  } else if (subcommand == TI_MAC_DA_STATUS_2) {
+    uint16_t temperature = _words[TEMPERATURE];
+    words[count++] = temperature + 9; // Die
+    words[count++] = temperature;     // TS1 to TS4
+    words[count++] = temperature - 3;
+    words[count++] = 0;
+    words[count++] = 0;
+    words[count++] = temperature;     // Cell
+    words[count++] = temperature + 19; // FET
+  }
+
+  for (uint8_t i = 0; i < count; i++) {
+    data[2 * i] = words[i] & 0xff;
+    data[2 * i + 1] = words[i] >> 8;
+  }
+  return 2 * count;
+}
+
+/**
+ * @brief Get the block read by ManufacturerBlockAccess() or by the alias of a MAC subcommand.
+ * Reading data flash advances the address.
+ * @param command
+ * @param result
+ * @return bool False if the command is neither.
+ */
+bool SimBattery::macBlock(uint8_t command, Block& result) {
+  if (command == MANUFACTURER_BLOCK_ACCESS && _mac >= SIM_DATA_FLASH && _mac < SIM_DATA_FLASH + SIM_DATA_FLASH_SIZE) {
+    // A data flash page, after which the address advances to the next page
+    uint16_t available = SIM_DATA_FLASH + SIM_DATA_FLASH_SIZE - _mac;
+    uint8_t count = available < SIM_DATA_FLASH_PAGE ? available : SIM_DATA_FLASH_PAGE;
+    result.data[0] = _mac & 0xff;
+    result.data[1] = _mac >> 8;
+    memcpy(result.data + 2, _dataFlash + (_mac - SIM_DATA_FLASH), count);
+    result.length = 2 + count;
+    _mac += count;
+    return true;
+  }
+  if (command == MANUFACTURER_BLOCK_ACCESS) {
+    result.data[0] = _mac & 0xff;
+    result.data[1] = _mac >> 8;
+    result.length = 2 + macResult(_mac, result.data + 2);
+    return true;
+  }
+  if (isAliasCommand(command)) {
+    result.length = macResult(command, result.data);
+    return true;
+  }
+  return false;
+}
@@ -0,0 +1,122 @@
+/**
+ * @file SimBattery.h
+ * @brief Register-level simulation of a Smart Battery Data Specification v1.1 device.
+ * @version 1.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef SimBattery_h
+#define SimBattery_h
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "SimBus.h"
+
+#define SIM_BATTERY_MAX_BLOCK 32
+#define SIM_HOST_ADDRESS 0x08     // SMBus Host, 7-bit
+#define SIM_CHARGER_ADDRESS 0x09  // Smart Battery Charger, 7-bit
+#define SIM_MAC_FLAGS_FIRST 0x50  // First of the TI status flag subcommands, SafetyAlert
+#define SIM_MAC_FLAGS_COUNT 8     // SafetyAlert to ManufacturingStatus
+#define SIM_DATA_FLASH 0x4000     // First data flash address
+#define SIM_DATA_FLASH_SIZE 0x2000
+#define SIM_DATA_FLASH_PAGE 32    // Bytes returned by each data flash read
+
+/**
+ * @class SimBattery
+ * @brief A smart battery that answers SBS Read Word, Write Word, Read Block and Write Block commands.
+ *
+ * Every command is latched by a write and must be followed by a read. The gauge needs
+ * a configurable preparation (turnaround) time after the command before its data is
+ * valid: a read that arrives through a repeated START before then is clock-stretched
+ * until the data is ready (unless clock stretching is disabled), a read that arrives as
+ * a new transaction is NACKed.
+ *
+ * Like a real pack it can also act as a bus master and broadcast AlarmWarning and its
+ * charging requests, as enabled by the AlarmMode and ChargerMode bits of BatteryMode.
+ *
+ * It also answers the TI bq40z50 extensions: CellVoltage1() to CellVoltage4(), MAC
+ * subcommands through ManufacturerAccess() and ManufacturerBlockAccess(), data flash reads
+ * with auto-increment and writes, and, unless sealed, the status flags and
+ * DAStatus1/DAStatus2 as SBS block commands.
+ */
+class SimBattery : public SimDevice {
+public:
+  explicit SimBattery(uint8_t address);
+  ~SimBattery();
+
+  void attach();
+  void detach();
+  uint8_t address() const;
+
+  void setWord(uint8_t command, uint16_t value);
+  uint16_t word(uint8_t command) const;
+  void setBlock(uint8_t command, const uint8_t* data, uint8_t length);
+  void setString(uint8_t command, const char* str);
+
+  void setTurnaroundMicros(uint32_t us);
+  uint32_t turnaroundMicros() const;
+  void setClockStretching(bool enable);
+  void setPEC(bool enable);
+  void setSealed(bool sealed);
+  void setFlags(uint16_t subcommand, uint32_t flags);
+  uint8_t* dataFlash();
+  uint32_t dataFlashWrites() const;
+
+  uint8_t raiseAlarm(uint16_t alarms);
+  uint8_t broadcastChargingValues();
+  uint8_t broadcast(uint8_t address, uint8_t command, uint16_t value);
+
+  uint32_t reads() const;
+  uint32_t writes() const;
+  uint32_t nacks() const;
+  void resetCounters();
+
+  bool onWrite(const uint8_t* data, size_t length) override;
+  size_t onRead(uint8_t* data, size_t length, bool repeatedStart) override;
+
+  static bool isBlockCommand(uint8_t command);
+  static bool isWordCommand(uint8_t command);
+  static bool isAliasCommand(uint8_t command);
+
+private:
+  struct Block {
+    uint8_t length;
+    uint8_t data[SIM_BATTERY_MAX_BLOCK + 2]; // ManufacturerBlockAccess() prefixes the subcommand
+  };
+
+  Block* block(uint8_t command);
+  const Block* block(uint8_t command) const;
+  bool writeWord(uint8_t command, uint16_t value);
+  bool writeBlock(uint8_t command, const uint8_t* data, uint8_t length);
+  bool pecMatches(const uint8_t* data, size_t length) const;
+  void manufacturerAccess(uint16_t subcommand);
+  uint8_t macResult(uint16_t subcommand, uint8_t* data) const;
+  bool macBlock(uint8_t command, Block& result);
+
+  uint8_t _address;
+  uint16_t _words[256];
+  Block _manufacturerName;
+  Block _deviceName;
+  Block _deviceChemistry;
+  Block _manufacturerData;
+  uint8_t _command;
+  bool _commandPending;
+  uint64_t _commandNanos;
+  uint32_t _turnaroundUs;
+  bool _clockStretching;
+  bool _pec;
+  bool _sealed;
+  uint16_t _mac;
+  uint32_t _flags[SIM_MAC_FLAGS_COUNT];
+  uint8_t _dataFlash[SIM_DATA_FLASH_SIZE];
+  uint32_t _dataFlashWrites;
+  uint32_t _reads;
+  uint32_t _writes;
+  uint32_t _nacks;
+};
+
+#endif
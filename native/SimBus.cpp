@@ -0,0 +1,272 @@
+/**
+ * @file SimBus.cpp
+ * @brief Simulated I2C/SMBus segment with a configurable latency model.
+ * @version 1.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "SimBus.h"
+
+#include <string.h>
+
+#include "Arduino.h"
+
+/**
+ * @brief Get the bus shared by all TwoWire objects.
+ * @return SimBus&
+ */
+SimBus& SimBus::instance() {
+  static SimBus bus;
+  return bus;
+}
+
+SimBus::SimBus() : _clockHz(100000), _overheadNs(0), _held(false), _heldAddress(0), _nackDataFaults(0),
+    _shortReadFaults(0), _bitFlipFaults(0), _stuckClocks(0), _scl(1) {
+  memset(_devices, 0, sizeof(_devices));
+  resetStats();
+}
+
+/**
+ * @brief Attach a device at a 7-bit address, replacing any device already there.
+ * @param address
+ * @param device
+ */
+void SimBus::attach(uint8_t address, SimDevice* device) {
+  _devices[address & 0x7F] = device;
+}
+
+void SimBus::detach(uint8_t address) {
+  _devices[address & 0x7F] = nullptr;
+}
+
+SimDevice* SimBus::device(uint8_t address) const {
+  return _devices[address & 0x7F];
+}
+
+/**
+ * @brief Set the SCL frequency used to charge time for each bit.
+ * @param hz
+ */
+void SimBus::setClock(uint32_t hz) {
+  _clockHz = hz ? hz : 100000;
+}
+
+uint32_t SimBus::clock() const {
+  return _clockHz;
+}
+
+/**
+ * @brief Set the fixed per-transaction cost of the host controller and driver.
+ * @param ns
+ */
+void SimBus::setTransactionOverheadNanos(uint32_t ns) {
+  _overheadNs = ns;
+}
+
+/**
+ * @brief Make the next transfers fail.
+ * @param fault
+ * @param count For SIM_FAULT_NACK_DATA, SIM_FAULT_SHORT_READ and SIM_FAULT_BIT_FLIP the number
+ *              of transfers to fail, for SIM_FAULT_STUCK_SDA the number of SCL pulses needed to release SDA.
+ */
+void SimBus::injectFault(SimFault fault, uint32_t count) {
+  switch (fault) {
+    case SIM_FAULT_NACK_DATA:
+      _nackDataFaults = count;
+      break;
+    case SIM_FAULT_SHORT_READ:
+      _shortReadFaults = count;
+      break;
+    case SIM_FAULT_STUCK_SDA:
+      _stuckClocks = count;
+      break;
+    case SIM_FAULT_BIT_FLIP:
+      _bitFlipFaults = count;
+      break;
+  }
+}
+
+void SimBus::clearFaults() {
+  _nackDataFaults = 0;
+  _shortReadFaults = 0;
+  _bitFlipFaults = 0;
+  _stuckClocks = 0;
+}
+
+/**
+ * @brief Set the SCL level driven by the host while Wire is not using the pins.
+ * Each rising edge clocks one bit out of a target that is holding SDA low.
+ * @param level
+ */
+void SimBus::driveScl(uint8_t level) {
+  if (level && !_scl) {
+    _stats.recoveryClocks++;
+    if (_stuckClocks) {
+      _stuckClocks--;
+    }
+  }
+  _scl = level ? 1 : 0;
+}
+
+/**
+ * @brief Check if SDA is released, i.e. no target is holding it low.
+ * @return bool
+ */
+bool SimBus::sdaReleased() const {
+  return _stuckClocks == 0;
+}
+
+/**
+ * @brief Perform a master write.
+ * @param address 7-bit target address.
+ * @param data
+ * @param length
+ * @param stop False to keep the bus for a repeated START.
+ * @return uint8_t 0 on success, 2 if the address was NACKed, 3 if the data was NACKed,
+ * 5 on a timeout, as TwoWire::endTransmission() on ESP32.
+ */
+uint8_t SimBus::write(uint8_t address, const uint8_t* data, size_t length, bool stop) {
+  if (!sdaReleased()) {
+    _stats.timeouts++;
+    charge(SIM_BUS_TIMEOUT_NS);
+    _held = false;
+    return 5;
+  }
+
+  beginTransfer(address, false);
+  SimDevice* target = device(address);
+
+  if (target != nullptr && length > 0 && _nackDataFaults) {
+    _nackDataFaults--;
+    charge(9 * bitNanos() + bitNanos()); // Command byte, then STOP
+    _stats.bytes++;
+    _stats.stops++;
+    _held = false;
+    return 3;
+  }
+
+  if (target == nullptr) {
+    _stats.nacks++;
+    charge(bitNanos()); // STOP
+    _stats.stops++;
+    _held = false;
+    return 2;
+  }
+
+  if (!target->onWrite(data, length)) {
+    // The target acknowledged its address and refused the command or data
+    _stats.nacks++;
+    charge(9 * bitNanos() + bitNanos()); // Command byte, then STOP
+    _stats.bytes++;
+    _stats.stops++;
+    _held = false;
+    return length > 0 ? 3 : 2;
+  }
+
+  charge(9 * bitNanos() * length);
+  _stats.bytes += length;
+
+  if (stop) {
+    charge(bitNanos());
+    _stats.stops++;
+    _held = false;
+  } else {
+    _held = true;
+    _heldAddress = address & 0x7F;
+  }
+  return 0;
+}
+
+/**
+ * @brief Perform a master read.
+ * @param address 7-bit target address.
+ * @param data
+ * @param length
+ * @param stop False to keep the bus after the read.
+ * @return size_t Number of bytes read, 0 if the address was NACKed.
+ */
+size_t SimBus::read(uint8_t address, uint8_t* data, size_t length, bool stop) {
+  if (!sdaReleased()) {
+    _stats.timeouts++;
+    charge(SIM_BUS_TIMEOUT_NS);
+    _held = false;
+    return 0;
+  }
+
+  bool repeatedStart = beginTransfer(address, true);
+  SimDevice* target = device(address);
+  memset(data, 0xFF, length);
+  uint64_t start = simNanos();
+  size_t count = target != nullptr ? target->onRead(data, length, repeatedStart) : 0;
+  _stats.busyNanos += simNanos() - start; // Clock stretching by the target
+
+  if (count == 0) {
+    _stats.nacks++;
+    charge(bitNanos());
+    _stats.stops++;
+    _held = false;
+    return 0;
+  }
+
+  // The master decides how many bytes are clocked; a device that runs out of data
+  // leaves SDA released, which reads as 0xFF.
+  if (_shortReadFaults && length > 1) {
+    _shortReadFaults--;
+    length = 1;
+  }
+  if (_bitFlipFaults) {
+    _bitFlipFaults--;
+    data[0] ^= 0x10;
+  }
+  charge(9 * bitNanos() * length);
+  _stats.bytes += length;
+
+  if (stop) {
+    charge(bitNanos());
+    _stats.stops++;
+    _held = false;
+  } else {
+    _held = true;
+    _heldAddress = address & 0x7F;
+  }
+  return length;
+}
+
+const SimBusStats& SimBus::stats() const {
+  return _stats;
+}
+
+void SimBus::resetStats() {
+  memset(&_stats, 0, sizeof(_stats));
+}
+
+void SimBus::charge(uint64_t ns) {
+  simAdvanceNanos(ns);
+  _stats.busyNanos += ns;
+}
+
+uint64_t SimBus::bitNanos() const {
+  return 1000000000ULL / _clockHz;
+}
+
+/**
+ * @brief Charge the START (or repeated START) and address byte of a transfer.
+ * @param address
+ * @param read
+ * @return bool True if this was a repeated START to the same device.
+ */
+bool SimBus::beginTransfer(uint8_t address, bool read) {
+  bool repeatedStart = _held && read && _heldAddress == (address & 0x7F);
+  _stats.transactions++;
+  if (_held) {
+    _stats.repeatedStarts++;
+  }
+  // A combined write/read runs as one job on the host controller, so the driver
+  // overhead is only paid for a fresh START.
+  charge((_held ? 0 : _overheadNs) + bitNanos() + 9 * bitNanos());
+  _stats.bytes++;
+  return repeatedStart;
+}
@@ -0,0 +1,122 @@
+/**
+ * @file SimBus.h
+ * @brief Simulated I2C/SMBus segment with a configurable latency model.
+ * @version 1.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef SimBus_h
+#define SimBus_h
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * @class SimDevice
+ * @brief A target device attached to the simulated bus.
+ */
+class SimDevice {
+public:
+  virtual ~SimDevice() {}
+
+  /**
+   * @brief Called when a master writes to this device.
+   * @param data Bytes following the address byte.
+   * @param length Number of bytes.
+   * @return bool False to NACK the address, true to ACK.
+   */
+  virtual bool onWrite(const uint8_t* data, size_t length) = 0;
+
+  /**
+   * @brief Called when a master reads from this device.
+   * @param data Buffer to fill with the bytes the device clocks out.
+   * @param length Number of bytes the master will clock.
+   * @param repeatedStart True if the read directly follows a write to this device
+   *                      without a STOP in between.
+   * @return size_t Number of bytes supplied, 0 to NACK the address.
+   */
+  virtual size_t onRead(uint8_t* data, size_t length, bool repeatedStart) = 0;
+};
+
+#define SIM_BUS_TIMEOUT_NS 50000000ULL // Time a controller waits on a stuck bus, as the ESP32 default
+
+/**
+ * @enum SimFault
+ * @brief Faults that can be injected into the simulated bus.
+ */
+enum SimFault : uint8_t {
+  SIM_FAULT_NACK_DATA,  /**< The target ACKs its address but NACKs the command byte. */
+  SIM_FAULT_SHORT_READ, /**< A read ends after its first byte. */
+  SIM_FAULT_STUCK_SDA,  /**< A target holds SDA low until SCL is clocked by hand. */
+  SIM_FAULT_BIT_FLIP    /**< One bit of a read's first data byte is corrupted on the wire. */
+};
+
+/**
+ * @struct SimBusStats
+ * @brief Counters kept by the simulated bus.
+ */
+struct SimBusStats {
+  uint32_t transactions;    /**< START or repeated START conditions issued. */
+  uint32_t stops;           /**< STOP conditions issued. */
+  uint32_t repeatedStarts;  /**< Repeated START conditions issued. */
+  uint32_t nacks;           /**< Transactions whose address was not acknowledged. */
+  uint32_t timeouts;        /**< Transactions that failed because SDA was stuck low. */
+  uint32_t recoveryClocks;  /**< SCL pulses driven by hand. */
+  uint32_t bytes;           /**< Bytes clocked, including address bytes. */
+  uint64_t busyNanos;       /**< Time the bus was owned by a master. */
+};
+
+/**
+ * @class SimBus
+ * @brief Routes TwoWire transactions to SimDevice instances and charges bus time.
+ *
+ * Each byte costs nine SCL periods (eight data bits plus ACK), START, repeated START and
+ * STOP cost one period each, and every transaction started with a fresh START additionally
+ * costs a fixed driver overhead which models the host controller's setup time.
+ */
+class SimBus {
+public:
+  static SimBus& instance();
+
+  void attach(uint8_t address, SimDevice* device);
+  void detach(uint8_t address);
+  SimDevice* device(uint8_t address) const;
+
+  void setClock(uint32_t hz);
+  uint32_t clock() const;
+  void setTransactionOverheadNanos(uint32_t ns);
+
+  void injectFault(SimFault fault, uint32_t count = 1);
+  void clearFaults();
+  void driveScl(uint8_t level);
+  bool sdaReleased() const;
+
+  uint8_t write(uint8_t address, const uint8_t* data, size_t length, bool stop);
+  size_t read(uint8_t address, uint8_t* data, size_t length, bool stop);
+
+  const SimBusStats& stats() const;
+  void resetStats();
+
+private:
+  SimBus();
+  void charge(uint64_t ns);
+  uint64_t bitNanos() const;
+  bool beginTransfer(uint8_t address, bool read);
+
+  SimDevice* _devices[128];
+  uint32_t _clockHz;
+  uint32_t _overheadNs;
+  bool _held;
+  uint8_t _heldAddress;
+  uint32_t _nackDataFaults;
+  uint32_t _shortReadFaults;
+  uint32_t _bitFlipFaults;
+  uint32_t _stuckClocks;
+  uint8_t _scl;
+  SimBusStats _stats;
+};
+
+#endif
@@ -0,0 +1,202 @@
+/**
+ * @file Wire.cpp
+ * @brief Drop-in TwoWire for host-native builds, backed by the simulated bus.
+ * @version 1.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "Wire.h"
+
+#include <string.h>
+
+TwoWire Wire;
+TwoWire Wire1;
+
+/**
+ * @class TwoWireTarget
+ * @brief Attaches a TwoWire in target mode to the simulated bus.
+ */
+class TwoWireTarget : public SimDevice {
+public:
+  explicit TwoWireTarget(TwoWire& wire) : _wire(wire) {}
+
+  /**
+   * @brief Deliver a master's write to the onReceive() handler, as the TWI interrupt does.
+   */
+  bool onWrite(const uint8_t* data, size_t length) override {
+    if (length > I2C_BUFFER_LENGTH) {
+      length = I2C_BUFFER_LENGTH;
+    }
+    memcpy(_wire._rxBuffer, data, length);
+    _wire._rxLength = length;
+    _wire._rxIndex = 0;
+    if (_wire._onReceive != nullptr && length > 0) {
+      _wire._onReceive(static_cast<int>(length));
+    }
+    return true;
+  }
+
+  /**
+   * @brief Answer a master's read with what the onRequest() handler writes.
+   */
+  size_t onRead(uint8_t* data, size_t length, bool repeatedStart) override {
+    (void)repeatedStart;
+    _wire._txLength = 0;
+    _wire._txOverflow = false;
+    if (_wire._onRequest != nullptr) {
+      _wire._onRequest();
+    }
+    size_t count = _wire._txLength < length ? _wire._txLength : length;
+    memcpy(data, _wire._txBuffer, count);
+    memset(data + count, 0xff, length - count); // A released SDA reads as ones
+    return count ? length : 0;
+  }
+
+private:
+  TwoWire& _wire;
+};
+
+void TwoWire::begin() {
+  _txLength = 0;
+  _writePending = false;
+  _rxLength = 0;
+  _rxIndex = 0;
+}
+
+/**
+ * @brief Join the simulated bus as a target as well as a master.
+ * @param address 7-bit address to answer at.
+ */
+void TwoWire::begin(uint8_t address) {
+  begin();
+  end();
+  _target = new TwoWireTarget(*this);
+  SimBus::instance().attach(address, _target);
+}
+
+void TwoWire::begin(int address) {
+  begin(static_cast<uint8_t>(address));
+}
+
+/**
+ * @brief Leave target mode.
+ */
+void TwoWire::end() {
+  if (_target != nullptr) {
+    for (int address = 0; address < 128; address++) {
+      if (SimBus::instance().device(address) == _target) {
+        SimBus::instance().detach(address);
+      }
+    }
+    delete _target;
+    _target = nullptr;
+  }
+}
+
+void TwoWire::onReceive(void (*handler)(int)) {
+  _onReceive = handler;
+}
+
+void TwoWire::onRequest(void (*handler)(void)) {
+  _onRequest = handler;
+}
+
+/**
+ * @brief Set the SCL frequency of the simulated bus.
+ * @param hz
+ */
+void TwoWire::setClock(uint32_t hz) {
+  SimBus::instance().setClock(hz);
+}
+
+/**
+ * @brief Choose when a write ended without a STOP is sent.
+ * @param enable True to queue it for the next requestFrom(), as arduino-esp32 does; false
+ *               to send it at once, as the AVR core does.
+ */
+void TwoWire::setDeferredWrites(bool enable) {
+  _deferWrites = enable;
+  _writePending = false;
+}
+
+void TwoWire::beginTransmission(int address) {
+  _txAddress = static_cast<uint8_t>(address);
+  _txLength = 0;
+  _txOverflow = false;
+}
+
+/**
+ * @brief Send the queued bytes.
+ * @param sendStop False to hold the bus for a repeated START.
+ * @return uint8_t 0 success, 1 data too long, 2 NACK on address, 3 NACK on data. Always 0
+ * for a write without a STOP when writes are deferred.
+ */
+uint8_t TwoWire::endTransmission(bool sendStop) {
+  _writePending = false;
+  if (_txOverflow) {
+    return 1;
+  }
+  if (!sendStop && _deferWrites) {
+    _writePending = true;
+    return 0;
+  }
+  return SimBus::instance().write(_txAddress, _txBuffer, _txLength, sendStop);
+}
+
+/**
+ * @brief Read bytes from a device into the receive buffer.
+ * @param address
+ * @param quantity
+ * @param sendStop
+ * @return uint8_t Number of bytes received, 0 if the address was NACKed.
+ */
+uint8_t TwoWire::requestFrom(int address, int quantity, int sendStop) {
+  if (quantity < 0) {
+    quantity = 0;
+  }
+  if (quantity > I2C_BUFFER_LENGTH) {
+    quantity = I2C_BUFFER_LENGTH;
+  }
+  _rxIndex = 0;
+  if (_writePending) {
+    _writePending = false;
+    if (SimBus::instance().write(_txAddress, _txBuffer, _txLength, false) != 0) {
+      _rxLength = 0;
+      return 0;
+    }
+  }
+  _rxLength = SimBus::instance().read(static_cast<uint8_t>(address), _rxBuffer, quantity, sendStop != 0);
+  return static_cast<uint8_t>(_rxLength);
+}
+
+size_t TwoWire::write(uint8_t data) {
+  if (_txLength >= I2C_BUFFER_LENGTH) {
+    _txOverflow = true;
+    return 0;
+  }
+  _txBuffer[_txLength++] = data;
+  return 1;
+}
+
+size_t TwoWire::write(const uint8_t* data, size_t quantity) {
+  size_t n = 0;
+  while (n < quantity && write(data[n])) {
+    n++;
+  }
+  return n;
+}
+
+int TwoWire::available() {
+  return static_cast<int>(_rxLength - _rxIndex);
+}
+
+int TwoWire::read() {
+  return _rxIndex < _rxLength ? _rxBuffer[_rxIndex++] : -1;
+}
+
+int TwoWire::peek() {
+  return _rxIndex < _rxLength ? _rxBuffer[_rxIndex] : -1;
+}
@@ -0,0 +1,77 @@
+/**
+ * @file Wire.h
+ * @brief Drop-in TwoWire for host-native builds, backed by the simulated bus.
+ * @version 1.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef TwoWire_h
+#define TwoWire_h
+
+#include "Arduino.h"
+#include "SimBus.h"
+
+#define I2C_BUFFER_LENGTH 128
+
+/**
+ * @class TwoWire
+ * @brief Subset of the Arduino TwoWire API.
+ *
+ * Master mode uses the simulated bus directly. begin(address) additionally attaches the
+ * object to the bus as a target, so simulated devices acting as masters (a battery
+ * broadcasting AlarmWarning) reach its onReceive() handler, as the TWI interrupt would.
+ *
+ * setDeferredWrites() switches from AVR to arduino-esp32 behaviour for repeated STARTs:
+ * endTransmission(false) then only queues the write, and requestFrom() performs it together
+ * with the read, so a NACK of the address or the command shows up only as requestFrom()
+ * returning 0.
+ *
+ * Only has plain data members so the global Wire object is usable from other
+ * translation units' static constructors, as it is on the real cores.
+ */
+class TwoWire : public Print {
+public:
+  void begin();
+  void begin(uint8_t address);
+  void begin(int address);
+  void end();
+  void onReceive(void (*handler)(int));
+  void onRequest(void (*handler)(void));
+  void setClock(uint32_t hz);
+  void setDeferredWrites(bool enable);
+
+  void beginTransmission(int address);
+  uint8_t endTransmission(bool sendStop = true);
+  uint8_t requestFrom(int address, int quantity, int sendStop = 1);
+
+  size_t write(uint8_t data) override;
+  size_t write(const uint8_t* data, size_t quantity) override;
+  using Print::write;
+  int available();
+  int read();
+  int peek();
+
+private:
+  friend class TwoWireTarget;
+
+  uint8_t _txAddress;
+  uint8_t _txBuffer[I2C_BUFFER_LENGTH];
+  size_t _txLength;
+  bool _txOverflow;
+  bool _deferWrites;
+  bool _writePending;
+  uint8_t _rxBuffer[I2C_BUFFER_LENGTH];
+  size_t _rxLength;
+  size_t _rxIndex;
+  SimDevice* _target;
+  void (*_onReceive)(int);
+  void (*_onRequest)(void);
+};
+
+extern TwoWire Wire;
+extern TwoWire Wire1;
+
+#endif
@@ -0,0 +1,169 @@
+/**
+ * @file AdaptivePollRate.cpp
+ * @brief Picks the time to the next poll from what the battery is doing.
+ * @version 1.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "AdaptivePollRate.h"
+
+/**
+ * @brief Construct a controller with the default thresholds. It starts at the minimum interval.
+ * @param minIntervalMs Fastest poll interval.
+ * @param maxIntervalMs Slowest poll interval.
+ */
+AdaptivePollRate::AdaptivePollRate(uint32_t minIntervalMs, uint32_t maxIntervalMs)
+    : _restCurrent(POLL_RATE_REST_CURRENT), _highCurrent(POLL_RATE_HIGH_CURRENT),
+      _currentSlew(POLL_RATE_CURRENT_SLEW), _temperatureRise(POLL_RATE_TEMPERATURE_RISE) {
+  setLimits(minIntervalMs, maxIntervalMs);
+  reset();
+}
+
+/**
+ * @brief Set the fastest and slowest poll intervals.
+ * @param minIntervalMs At least 1.
+ * @param maxIntervalMs Raised to minIntervalMs if lower.
+ */
+void AdaptivePollRate::setLimits(uint32_t minIntervalMs, uint32_t maxIntervalMs) {
+  _minMs = minIntervalMs ? minIntervalMs : 1;
+  _maxMs = maxIntervalMs > _minMs ? maxIntervalMs : _minMs;
+}
+
+/**
+ * @brief Set the current at or below which the pack is considered at rest.
+ * Also sets the charge per poll while current flows: maximum interval times this current.
+ * @param milliamps At least 1.
+ */
+void AdaptivePollRate::setRestCurrent(uint16_t milliamps) {
+  _restCurrent = milliamps ? milliamps : 1;
+}
+
+/**
+ * @brief Set the current at or above which the pack is polled at the minimum interval.
+ * @param milliamps
+ */
+void AdaptivePollRate::setHighCurrent(uint16_t milliamps) {
+  _highCurrent = milliamps;
+}
+
+/**
+ * @brief Set the rate of current change at or above which the pack is polled at the minimum interval.
+ * @param milliampsPerSecond
+ */
+void AdaptivePollRate::setCurrentSlew(uint16_t milliampsPerSecond) {
+  _currentSlew = milliampsPerSecond;
+}
+
+/**
+ * @brief Set the temperature rise at or above which the pack is polled at the minimum interval.
+ * @param decikelvinPerMinute
+ */
+void AdaptivePollRate::setTemperatureRise(uint16_t decikelvinPerMinute) {
+  _temperatureRise = decikelvinPerMinute;
+}
+
+/**
+ * @brief Take the latest snapshot and decide the interval to the next poll.
+ * @param snapshot
+ * @return uint32_t Milliseconds until the next poll.
+ */
+uint32_t AdaptivePollRate::update(const BatterySnapshot& snapshot) {
+  if (!(snapshot.valid & SNAPSHOT_CURRENT)) {
+    // A failed read tells nothing about the pack; bus faults are retried by the caller
+    _reason = POLL_NO_DATA;
+    return _intervalMs;
+  }
+
+  int16_t current = snapshot.current;
+  uint32_t slew = 0;
+  if (_haveCurrent && snapshot.timestamp != _currentTime) {
+    int32_t change = (int32_t)current - _current;
+    slew = (uint32_t)(change < 0 ? -change : change) * 1000 / (snapshot.timestamp - _currentTime);
+  }
+  _haveCurrent = true;
+  _current = current;
+  _currentTime = snapshot.timestamp;
+
+  if (snapshot.valid & SNAPSHOT_TEMPERATURE) {
+    if (!_haveTemperature) {
+      _haveTemperature = true;
+      _temperature = snapshot.temperature;
+      _temperatureTime = snapshot.timestamp;
+    } else if (snapshot.timestamp - _temperatureTime >= POLL_RATE_TEMPERATURE_WINDOW_MS) {
+      // The register moves in 0.1 K steps, so the rise is only measured over a long enough window
+      _rise = ((int32_t)snapshot.temperature - _temperature) * 60000 / (int32_t)(snapshot.timestamp - _temperatureTime);
+      _temperature = snapshot.temperature;
+      _temperatureTime = snapshot.timestamp;
+    }
+  }
+
+  uint32_t magnitude = current < 0 ? -(int32_t)current : current;
+  if ((snapshot.valid & SNAPSHOT_BATTERY_STATUS) && (snapshot.battery_status & BATTERY_STATUS_CRITICAL_ALARMS)) {
+    _reason = POLL_ALARM;
+  } else if (_rise >= _temperatureRise) {
+    _reason = POLL_TEMPERATURE_RISING;
+  } else if (slew >= _currentSlew) {
+    _reason = POLL_CURRENT_SLEW;
+  } else if (magnitude >= _highCurrent) {
+    _reason = POLL_HIGH_CURRENT;
+  } else if (magnitude > _restCurrent) {
+    _reason = current < 0 ? POLL_DISCHARGING : POLL_CHARGING;
+  } else {
+    _reason = POLL_REST;
+  }
+
+  if (_reason == POLL_REST) {
+    _intervalMs = _intervalMs > _maxMs / 2 ? _maxMs : _intervalMs * 2;
+  } else if (_reason == POLL_DISCHARGING || _reason == POLL_CHARGING) {
+    uint32_t interval = (uint64_t)_maxMs * _restCurrent / magnitude;
+    _intervalMs = interval < _minMs ? _minMs : interval;
+  } else {
+    _intervalMs = _minMs;
+  }
+  if (_intervalMs < _minMs) {
+    _intervalMs = _minMs;
+  }
+  return _intervalMs;
+}
+
+/**
+ * @brief Forget the history, e.g. after switching packs. The interval returns to the minimum.
+ */
+void AdaptivePollRate::reset() {
+  _intervalMs = _minMs;
+  _reason = POLL_NO_DATA;
+  _haveCurrent = false;
+  _current = 0;
+  _currentTime = 0;
+  _haveTemperature = false;
+  _temperature = 0;
+  _temperatureTime = 0;
+  _rise = 0;
+}
+
+/**
+ * @brief Get the interval decided by the last update().
+ * @return uint32_t Milliseconds.
+ */
+uint32_t AdaptivePollRate::interval() const {
+  return _intervalMs;
+}
+
+/**
+ * @brief Get what decided the interval.
+ * @return PollReason
+ */
+PollReason AdaptivePollRate::reason() const {
+  return _reason;
+}
+
+/**
+ * @brief Get the last measured temperature rise.
+ * @return int32_t 0.1 K per minute, negative when cooling.
+ */
+int32_t AdaptivePollRate::temperatureRise() const {
+  return _rise;
+}
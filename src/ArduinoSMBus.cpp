@@ -11,6 +11,49 @@
 
 #include "ArduinoSMBus.h"
 
+#include <stddef.h>
+
+/**
+ * @brief Registers read by readSnapshot(), in bus order.
+ * Entry n corresponds to bit n of the snapshot field mask.
+ */
+struct SnapshotRegister {
+  uint8_t command;
+  uint8_t offset;
+};
+
+static constexpr SnapshotRegister snapshotRegisters[] = {
+  {BATTERY_STATUS, offsetof(BatterySnapshot, battery_status)},
+  {VOLTAGE, offsetof(BatterySnapshot, voltage)},
+  {CURRENT, offsetof(BatterySnapshot, current)},
+  {AVERAGE_CURRENT, offsetof(BatterySnapshot, average_current)},
+  {TEMPERATURE, offsetof(BatterySnapshot, temperature)},
+  {REL_STATE_OF_CHARGE, offsetof(BatterySnapshot, relative_state_of_charge)},
+  {ABS_STATE_OF_CHARGE, offsetof(BatterySnapshot, absolute_state_of_charge)},
+  {REM_CAPACITY, offsetof(BatterySnapshot, remaining_capacity)},
+  {FULL_CAPACITY, offsetof(BatterySnapshot, full_capacity)},
+  {RUN_TIME_TO_EMPTY, offsetof(BatterySnapshot, run_time_to_empty)},
+  {AVG_TIME_TO_EMPTY, offsetof(BatterySnapshot, avg_time_to_empty)},
+  {AVG_TIME_TO_FULL, offsetof(BatterySnapshot, avg_time_to_full)},
+  {CHARGING_CURRENT, offsetof(BatterySnapshot, charging_current)},
+  {CHARGING_VOLTAGE, offsetof(BatterySnapshot, charging_voltage)},
+  {MAX_ERROR, offsetof(BatterySnapshot, max_error)},
+};
+
+/**
+ * @brief Check at compile time that every snapshot register is a described word register.
+ * @param i First entry to check.
+ * @return bool
+ */
+static constexpr bool snapshotRegistersAreWords(uint8_t i = 0) {
+  return i >= sizeof(snapshotRegisters) / sizeof(snapshotRegisters[0]) ||
+         (smbusRegisterIndex(snapshotRegisters[i].command) < SMBUS_REGISTER_COUNT &&
+          smbusRegisters[smbusRegisterIndex(snapshotRegisters[i].command)].wireType != SMBUS_WIRE_BLOCK &&
+          snapshotRegistersAreWords(i + 1));
+}
+
+static_assert(snapshotRegistersAreWords(), "readSnapshot() can only read word registers");
+
 /**
  * @brief Construct a new ArduinoSMBus:: ArduinoSMBus object.
  * 
@@ -18,305 +61,514 @@
  */
 ArduinoSMBus::ArduinoSMBus(uint8_t batteryAddress) {
   _batteryAddress = batteryAddress;
+  _turnaround.us = 0;
+  _turnaround.goodUs = 0;
+  _turnaround.streak = 0;
+  _splitTurnaround = _turnaround;
+  _adaptiveTurnaround = true;
+  _deferredRepeatedStart = SMBUS_DEFERRED_REPEATED_START;
+  _retries = SMBUS_DEFAULT_RETRIES;
+  _retryBackoffUs = SMBUS_RETRY_BACKOFF_US;
+  _sdaPin = SDA;
+  _sclPin = SCL;
+  _lastStatus = SMBUS_OK;
+  _pecEnabled = false;
+  _pecErrors = 0;
+  _cacheEnabled = false;
+  _cacheCount = 0;
+  _cacheHits = 0;
+  _cacheMisses = 0;
+  _manufacturerName[0] = '\0';
+  _deviceName[0] = '\0';
+  _deviceChemistry[0] = '\0';
+  _asyncCount = 0;
+  _asyncState = ASYNC_IDLE;
+  resetLatency();
+  _command = 0;
+  _commandPending = false;
+  _commandStart = 0;
   Wire.begin();
 }
 
 /**
  * @brief Set the battery's I2C address.
- * Can be used to change the address after the object is created
+ * Can be used to change the address after the object is created.
+ * Cached values belong to the previous battery, so the cache is invalidated.
  * @param batteryAddress 
  */
 void ArduinoSMBus::setBatteryAddress(uint8_t batteryAddress) {
   _batteryAddress = batteryAddress;
+  invalidateCache();
 }
 
 /**
- * @brief Get the battery's remaining capacity alarm.
- * Returns the battery's remaining capacity alarm threshold value, in mAh.
- * @return uint16_t 
+ * @brief Pin the delay between sending a command and reading its data.
+ * Disables turnaround adaptation. Use turnaround() on a running system to find
+ * the value learned for a given battery, then pin it here in production.
+ * @param microseconds Delay in microseconds, 0 to read immediately.
  */
-uint16_t ArduinoSMBus::remainingCapacityAlarm() {
-  return readRegister(REMAINING_CAPACITY_ALARM);
+void ArduinoSMBus::setTurnaround(uint16_t microseconds) {
+  _turnaround.us = microseconds;
+  _turnaround.goodUs = microseconds;
+  _turnaround.streak = 0;
+  _splitTurnaround = _turnaround;
+  _adaptiveTurnaround = false;
 }
 
 /**
- * @brief Get the battery's remaining time alarm.
- * Returns the battery's remaining time alarm threshold value, in minutes.
- * @return uint16_t 
+ * @brief Enable or disable turnaround adaptation.
+ * When enabled (the default), the turnaround starts from its current value and is
+ * raised whenever the battery NACKs the read or returns garbage, then the read is retried.
+ * After SMBUS_TURNAROUND_PROBE_READS good reads in a row a slightly shorter turnaround is
+ * tried, so the delay settles on the smallest value the battery reliably answers to.
+ * @param enable
  */
-uint16_t ArduinoSMBus::remainingTimeAlarm() {
-  return readRegister(REMAINING_TIME_ALARM);
+void ArduinoSMBus::setAdaptiveTurnaround(bool enable) {
+  _adaptiveTurnaround = enable;
+  _turnaround.streak = 0;
+  _splitTurnaround.streak = 0;
 }
 
 /**
- * @brief Get the battery's mode.
- * 
- * This method reads the battery's mode register, which contains various settings and status bits.
- * It then creates a BatteryMode struct and sets its fields based on the bits in the mode.
- * 
- * @return BatteryMode A struct containing the following fields:
- * - internal_charge_controller: bit 0 of the mode register
- * - primary_battery_support: bit 1 of the mode register
- * - condition_flag: bit 7 of the mode register
- * - charge_controller_enabled: bit 8 of the mode register
- * - primary_battery: bit 9 of the mode register
- * - alarm_mode: bit 13 of the mode register
- * - charger_mode: bit 14 of the mode register
- * - capacity_mode: bit 15 of the mode register
+ * @brief Get the current command-to-read turnaround.
+ * @return uint16_t Turnaround in microseconds, as pinned or as learned so far.
  */
-BatteryMode ArduinoSMBus::batteryMode() {
-  // Read the battery mode from the device...
-  uint16_t mode = readRegister(BATTERY_MODE);
+uint16_t ArduinoSMBus::turnaround() const {
+  return _turnaround.us;
+}
 
-  // Create a BatteryMode struct and set its fields based on the mode
-  BatteryMode batteryMode;
-  batteryMode.internal_charge_controller = mode & 0x0001;
-  batteryMode.primary_battery_support = (mode >> 1) & 0x0001;
-  batteryMode.condition_flag = (mode >> 7) & 0x0001;
-  batteryMode.charge_controller_enabled = (mode >> 8) & 0x0001;
-  batteryMode.primary_battery = (mode >> 9) & 0x0001;
-  batteryMode.alarm_mode = (mode >> 13) & 0x0001;
-  batteryMode.charger_mode = (mode >> 14) & 0x0001;
-  batteryMode.capacity_mode = (mode >> 15) & 0x0001;
+/**
+ * @brief Get the turnaround used by non-blocking reads.
+ * Non-blocking reads release the bus between the command and the read, so the
+ * battery cannot hold the read off by clock stretching and the turnaround they
+ * need is learned separately. setTurnaround() pins both values.
+ * @return uint16_t Turnaround in microseconds, as pinned or as learned so far.
+ */
+uint16_t ArduinoSMBus::splitTurnaround() const {
+  return _splitTurnaround.us;
+}
 
-  // Return the struct
-  return batteryMode;
+/**
+ * @brief Check if turnaround adaptation is enabled.
+ * @return bool
+ */
+bool ArduinoSMBus::adaptiveTurnaround() const {
+  return _adaptiveTurnaround;
 }
 
 /**
- * @brief Get the battery's temperature.
- * Returns the battery temperature in Kelvin.
- * @return uint16_t 
+ * @brief Tell the library how the Wire core sends a command ended without a STOP.
+ * Most cores send it at once and report its ACK, so reads are combined transactions with the
+ * turnaround between the command and the repeated START. arduino-esp32 only queues it and sends
+ * it together with the following read, so there a read that needs a turnaround sends the
+ * command with a STOP instead. Defaults to SMBUS_DEFERRED_REPEATED_START.
+ * @param deferred True if endTransmission(false) only queues the command.
  */
-uint16_t ArduinoSMBus::temperature() {
-  return readRegister(TEMPERATURE);
+void ArduinoSMBus::setDeferredRepeatedStart(bool deferred) {
+  _deferredRepeatedStart = deferred;
 }
 
 /**
- * @brief Get the battery's temperature in Celsius.
- * Returns the battery temperature in 0.1 degrees Celsius.
- * @return uint16_t 
+ * @brief Check if the Wire core is taken to defer a command ended without a STOP.
+ * @return bool
  */
-uint16_t ArduinoSMBus::temperatureC() {
-  uint16_t temperatureKelvin = readRegister(TEMPERATURE);
-  uint16_t temperatureCelsius = temperatureKelvin - 2731; // Convert from Kelvin to Celsius
-  return temperatureCelsius;
+bool ArduinoSMBus::deferredRepeatedStart() const {
+  return _deferredRepeatedStart;
 }
 
 /**
- * @brief Get the battery's temperature in Fahrenheit.
- * Returns the battery temperature in 0.1 degrees Fahrenheit.
- * @return uint16_t 
+ * @brief Set how often a failed read is retried.
+ * Each retry repeats the whole transaction after a backoff that doubles with every
+ * attempt, so a battery that is briefly busy gets time to recover while a dead one
+ * costs a bounded amount of bus time. A read that timed out triggers recoverBus()
+ * before it is retried.
+ * @param retries Extra attempts after the first, 0 to fail on the first error.
+ * @param backoffUs Wait before the first retry, in microseconds.
  */
-uint16_t ArduinoSMBus::temperatureF() {
-  uint16_t temperatureKelvin = readRegister(TEMPERATURE);
-  uint16_t temperatureFahrenheit = (temperatureKelvin * 18 - 45967) / 10; // Convert from Kelvin to Fahrenheit
-  return temperatureFahrenheit;
+void ArduinoSMBus::setRetries(uint8_t retries, uint16_t backoffUs) {
+  _retries = retries;
+  _retryBackoffUs = backoffUs;
 }
 
 /**
- * @brief Get the battery's voltage.
- * Returns the sum of all cell voltages, in mV.
- * @return uint16_t 
+ * @brief Set the pins used by recoverBus().
+ * Defaults to the board's SDA and SCL pins. They must be the pins Wire is using.
+ * @param sda SDA pin, or -1 to disable bus recovery.
+ * @param scl SCL pin, or -1 to disable bus recovery.
  */
-uint16_t ArduinoSMBus::voltage() {
-  return readRegister(VOLTAGE);
+void ArduinoSMBus::setBusPins(int sda, int scl) {
+  _sdaPin = sda;
+  _sclPin = scl;
 }
 
+/**
+ * @brief Free a bus whose SDA line is held low by a target.
+ * A target that lost clocks in the middle of a byte, e.g. because the host was reset
+ * mid-transaction, keeps driving SDA low and blocks every transaction. Clocking SCL by
+ * hand until the target has shifted out its byte and releases SDA, then issuing a STOP,
+ * returns it to idle. Wire is shut down while the pins are driven and restarted afterwards.
+ * @return bool True if SDA is released afterwards.
+ */
+bool ArduinoSMBus::recoverBus() {
+  if (_sdaPin < 0 || _sclPin < 0) {
+    return false;
+  }
+  Wire.end();
+  pinMode(_sdaPin, INPUT_PULLUP);
+  digitalWrite(_sclPin, HIGH); // Latch high first so switching to output does not clock the bus
+  pinMode(_sclPin, OUTPUT);
 
+  for (uint8_t i = 0; i < SMBUS_RECOVERY_CLOCKS && digitalRead(_sdaPin) == LOW; i++) {
+    digitalWrite(_sclPin, LOW);
+    delayMicroseconds(5);
+    digitalWrite(_sclPin, HIGH);
+    delayMicroseconds(5);
+  }
+
+  // STOP condition: SDA rises while SCL is high
+  digitalWrite(_sclPin, LOW);
+  digitalWrite(_sdaPin, LOW);
+  pinMode(_sdaPin, OUTPUT);
+  delayMicroseconds(5);
+  digitalWrite(_sclPin, HIGH);
+  delayMicroseconds(5);
+  pinMode(_sdaPin, INPUT_PULLUP);
+  bool released = digitalRead(_sdaPin) == HIGH;
+
+  pinMode(_sclPin, INPUT_PULLUP);
+  Wire.begin();
+  return released;
+}
 
 /**
- * @brief Get the battery's current.
- * Returns the battery measured current (from the coulomb counter) in mA.
- * @return uint16_t 
+ * @brief Enable or disable Packet Error Checking on reads.
+ * With PEC every read clocks one more byte, a CRC-8 the battery computes over the whole
+ * transaction, and a read whose PEC does not match is failed with SMBUS_PEC_ERROR and
+ * retried like any other error. The battery must support PEC; most smart battery gauges do.
+ * @param enable
  */
-uint16_t ArduinoSMBus::current() {
-  return readRegister(CURRENT);
+void ArduinoSMBus::enablePEC(bool enable) {
+  _pecEnabled = enable;
 }
 
 /**
- * @brief Get the battery's average current.
- * Returns the average current in a 1-minute rolling average, in mA.
- * @return uint16_t 
+ * @brief Check if Packet Error Checking is enabled.
+ * @return bool
  */
-uint16_t ArduinoSMBus::averageCurrent() {
-  return readRegister(AVERAGE_CURRENT);
+bool ArduinoSMBus::pecEnabled() const {
+  return _pecEnabled;
 }
 
 /**
- * @brief Get the battery's state of charge error.
- * Returns the battery's margin of error when estimating SOC, in percent
- * @return uint16_t 
+ * @brief Get the number of reads from this battery that failed their PEC check.
+ * Each failed attempt is counted, including ones that succeeded on a retry, so this
+ * measures the error rate of the wiring rather than of the data returned.
+ * @return uint32_t
  */
-uint16_t ArduinoSMBus::maxError() {
-  return readRegister(MAX_ERROR);
+uint32_t ArduinoSMBus::pecErrors() const {
+  return _pecErrors;
 }
 
 /**
- * @brief Get the battery's current relative charge.
- * Returns the predicted remaining battery capacity as a percentage of fullChargeCapacity()
- * @return uint16_t 
+ * @brief Reset the PEC error counter.
  */
-uint16_t ArduinoSMBus::relativeStateOfCharge() {
-  return readRegister(REL_STATE_OF_CHARGE);
+void ArduinoSMBus::resetPecErrors() {
+  _pecErrors = 0;
 }
 
 /**
- * @brief Get the battery's absolute charge.
- * Returns the predicted remaining battery capacity as a percentage of designCapacity()
- * @return uint16_t 
+ * @brief Get the status of the last read made through this object.
+ * Lets callers of the plain getters, which return 0 on failure, tell a failed read from a
+ * real 0 reading.
+ * @return SMBusStatus
  */
-uint16_t ArduinoSMBus::absoluteStateOfCharge() {
-  return readRegister(ABS_STATE_OF_CHARGE);
+SMBusStatus ArduinoSMBus::lastStatus() const {
+  return _lastStatus;
 }
 
 /**
- * @brief Get the battery's capacity.
- * Returns the predicted battery capacity when fully charged, in mAh.
- * For some batteries, this may be in 10s of mWh, if the BatteryMode() register (0x03) is set that way
- * See protocol documentation for details.
- * @return uint16_t 
+ * @brief Read a 16-bit register and report the outcome.
+ * Uses the SBS Read Word protocol: the command write and the data read form one
+ * transaction joined by a repeated START, so no other master can get between them
+ * and no STOP/START is paid in the middle. Failed transactions are retried as set
+ * by setRetries().
+ * @param reg Command code of the register.
+ * @return SMBusResult
  */
-uint16_t ArduinoSMBus::remainingCapacity() {
-  return readRegister(REM_CAPACITY);
+SMBusResult ArduinoSMBus::readWord(uint8_t reg) {
+  SMBusResult result = {SMBUS_OK, 0};
+  uint8_t attempt = 0;
+  do {
+    result.status = wordTransaction(reg, result.value);
+  } while (result.status != SMBUS_OK && retryAfter(result.status, attempt++));
+
+  if (result.ok()) {
+    cacheStore(reg, result.value);
+  } else {
+    result.value = 0;
+  }
+  _lastStatus = result.status;
+  return result;
 }
 
 /**
- * @brief Get the battery's full capacity.
- * Returns the predicted battery capacity when fully charged, in mAh.
- * For some batteries, this may be in 10s of mWh, if the BatteryMode() register (0x03) is set that way
- * See protocol documentation for details.
- * @return uint16_t 
+ * @brief Look up a register's descriptor.
+ * @param reg Command code of the register.
+ * @return const SMBusRegisterInfo* nullptr if the register is not in SMBUS_REGISTERS.
  */
-uint16_t ArduinoSMBus::fullCapacity() {
-  return readRegister(FULL_CAPACITY);
+const SMBusRegisterInfo* ArduinoSMBus::registerInfo(uint8_t reg) {
+  uint8_t index = smbusRegisterIndex(reg);
+  return index < SMBUS_REGISTER_COUNT ? &smbusRegisters[index] : nullptr;
 }
 
 /**
- * @brief Get the battery's time to empty.
- * Returns the predicted time to empty, in minutes, based on current instantaneous discharge rate.
- * @return uint16_t 
+ * @brief Read a block register and report the outcome.
+ * Uses the SBS Read Block protocol, a command write and a data read joined by a repeated
+ * START. A block longer than length is truncated; a block that ends early is reported as
+ * SMBUS_SHORT_READ rather than left silently half-filled. Failed transactions are retried
+ * as set by setRetries(). A buffer larger than SMBUS_BLOCK_MAX also accepts blocks up to
+ * its size, for vendor commands such as TI ManufacturerBlockAccess() that return 34 bytes;
+ * the Wire buffer must then hold length + 2 bytes. With PEC the whole block and its PEC
+ * must fit the Wire buffer, so on AVR, whose buffer holds 32 bytes, a block longer than
+ * 30 bytes fails with SMBUS_BUS_ERROR.
+ * @param reg Command code of the register.
+ * @param data Buffer for the block.
+ * @param length Size of data.
+ * @return SMBusResult value is the number of bytes stored in data.
  */
-uint16_t ArduinoSMBus::runTimeToEmpty() {
-  return readRegister(RUN_TIME_TO_EMPTY);
+SMBusResult ArduinoSMBus::readBlock(uint8_t reg, uint8_t* data, uint8_t length) {
+  SMBusResult result = {SMBUS_OK, 0};
+  uint8_t attempt = 0;
+  uint8_t count = 0;
+  do {
+    result.status = blockTransaction(reg, data, length, count);
+  } while (result.status != SMBUS_OK && retryAfter(result.status, attempt++));
+
+  result.value = result.ok() ? count : 0;
+  _lastStatus = result.status;
+  return result;
 }
 
 /**
- * @brief Get the battery's average time to empty.
- * Returns the predicted time to empty, in minutes, based on 1-minute rolling average discharge rate.
- * @return uint16_t 
+ * @brief Write a 16-bit register.
+ * Uses the SBS Write Word protocol, followed by a PEC if enablePEC() is set. Failed
+ * transactions are retried as set by setRetries(). A successful write discards the
+ * register's cached value; writing BatteryMode discards the whole cache, since its
+ * capacity_mode bit changes the units of the capacity registers.
+ * @param reg Command code of the register.
+ * @param value
+ * @return SMBusStatus
  */
-uint16_t ArduinoSMBus::avgTimeToEmpty() {
-  return readRegister(AVG_TIME_TO_EMPTY);
+SMBusStatus ArduinoSMBus::writeRegister(uint8_t reg, uint16_t value) {
+  uint8_t data[2] = {(uint8_t)(value & 0xff), (uint8_t)(value >> 8)};
+  SMBusStatus status;
+  uint8_t attempt = 0;
+  do {
+    status = writeTransaction(reg, data, sizeof(data), false);
+  } while (status != SMBUS_OK && retryAfter(status, attempt++));
+
+  if (status == SMBUS_OK) {
+    writeCompleted(reg);
+  }
+  _lastStatus = status;
+  return status;
 }
 
 /**
- * @brief Get the battery's time to full.
- * Returns the predicted time to full charge, in minutes, based on 1-minute rolling average charge rate.
- * @return uint16_t 
+ * @brief Write a block register.
+ * Uses the SBS Write Block protocol, followed by a PEC if enablePEC() is set. The whole
+ * message must fit the Wire buffer, which is 32 bytes on AVR: up to 29 data bytes with
+ * PEC, 30 without.
+ * @param reg Command code of the register.
+ * @param data
+ * @param length At most SMBUS_BLOCK_MAX.
+ * @return SMBusStatus SMBUS_BUS_ERROR if the block is too long.
  */
-uint16_t ArduinoSMBus::avgTimeToFull() {
-  return readRegister(AVG_TIME_TO_FULL);
+SMBusStatus ArduinoSMBus::writeBlock(uint8_t reg, const uint8_t* data, uint8_t length) {
+  if (length > SMBUS_BLOCK_MAX) {
+    _lastStatus = SMBUS_BUS_ERROR;
+    return SMBUS_BUS_ERROR;
+  }
+  SMBusStatus status;
+  uint8_t attempt = 0;
+  do {
+    status = writeTransaction(reg, data, length, true);
+  } while (status != SMBUS_OK && retryAfter(status, attempt++));
+
+  if (status == SMBUS_OK) {
+    writeCompleted(reg);
+  }
+  _lastStatus = status;
+  return status;
 }
 
 /**
- * @brief Get the battery's status.
- * 
- * This function reads the BatteryStatus register and returns a struct with its value.
- * The BatteryStatus register indicates various alarm conditions and states of the battery.
- * These include over charge, termination charge, over temperature, termination discharge,
- * remaining capacity, remaining time, initialization, discharging, fully charged, and fully discharged states.
- * 
- * @return BatteryStatus A struct containing the status of each bit in the BatteryStatus register.
+ * @brief Write several registers, then verify them all in one read-back pass.
+ * Every entry is written first, so a gauge that applies settings with a delay has the
+ * time of the remaining writes to do so. Each written register is then read back and
+ * compared under its verifyMask. Each register should appear at most once in a batch.
+ * @param writes Entries to write; their status is set to the outcome.
+ * @param count Number of entries.
+ * @return bool True if every entry was written and verified. lastStatus() is the first failure.
  */
-BatteryStatus ArduinoSMBus::batteryStatus() {
-  uint16_t status = readRegister(BATTERY_STATUS);
-  BatteryStatus batteryStatus;
+bool ArduinoSMBus::writeRegisters(SMBusWordWrite writes[], uint8_t count) {
+  for (uint8_t i = 0; i < count; i++) {
+    writes[i].status = writeRegister(writes[i].reg, writes[i].value);
+  }
 
-  batteryStatus.over_charged_alarm = status & (1 << 15);
-  batteryStatus.term_charge_alarm = status & (1 << 14);
-  batteryStatus.over_temp_alarm = status & (1 << 12);
-  batteryStatus.term_discharge_alarm = status & (1 << 11);
-  batteryStatus.rem_capacity_alarm = status & (1 << 9);
-  batteryStatus.rem_time_alarm = status & (1 << 8);
-  batteryStatus.initialized = status & (1 << 7);
-  batteryStatus.discharging = status & (1 << 6);
-  batteryStatus.fully_charged = status & (1 << 5);
-  batteryStatus.fully_discharged = status & (1 << 4);
+  SMBusStatus first = SMBUS_OK;
+  for (uint8_t i = 0; i < count; i++) {
+    SMBusWordWrite& write = writes[i];
+    if (write.status == SMBUS_OK) {
+      SMBusResult readBack = readWord(write.reg);
+      if (!readBack.ok()) {
+        write.status = readBack.status;
+      } else if ((readBack.value ^ write.value) & write.verifyMask) {
+        write.status = SMBUS_VERIFY_ERROR;
+      }
+    }
+    if (first == SMBUS_OK) {
+      first = write.status;
+    }
+  }
+  _lastStatus = first;
+  return first == SMBUS_OK;
+}
 
-  return batteryStatus;
+/**
+ * @brief Set the remaining capacity alarm threshold and verify it.
+ * The battery sends AlarmWarning with REMAINING_CAPACITY_ALARM set once its remaining
+ * capacity falls below this.
+ * @param capacity In mAh, or 10 mWh if capacity_mode is set. 0 disables the alarm.
+ * @return SMBusStatus
+ */
+SMBusStatus ArduinoSMBus::setRemainingCapacityAlarm(uint16_t capacity) {
+  return writeVerified(REMAINING_CAPACITY_ALARM, capacity, 0xffff);
 }
 
 /**
- * @brief Get the battery's design charging current.
- * Returns the desired design charging current of the battery, in mA.
- * @return uint16_t 
+ * @brief Set the remaining time alarm threshold and verify it.
+ * The battery sends AlarmWarning with REMAINING_TIME_ALARM set once its average time to
+ * empty falls below this.
+ * @param minutes 0 disables the alarm.
+ * @return SMBusStatus
  */
-uint16_t ArduinoSMBus::chargingCurrent() {
-  return readRegister(CHARGING_CURRENT);
+SMBusStatus ArduinoSMBus::setRemainingTimeAlarm(uint16_t minutes) {
+  return writeVerified(REMAINING_TIME_ALARM, minutes, 0xffff);
 }
 
 /**
- * @brief Get the battery's design charging voltage.
- * Returns the desired design charging voltage of the battery, in mV.
- * @return uint16_t 
+ * @brief Write BatteryMode and verify the bits the host may change.
+ * @param mode
+ * @return SMBusStatus
  */
-uint16_t ArduinoSMBus::chargingVoltage() {
-  return readRegister(CHARGING_VOLTAGE);
+SMBusStatus ArduinoSMBus::setBatteryMode(BatteryMode mode) {
+  return writeVerified(BATTERY_MODE, mode.raw, BATTERY_MODE_WRITABLE);
 }
 
+/**
+ * @brief Choose the units of the capacity registers.
+ * @param tenMilliwattHours True for 10 mWh, false for mAh.
+ * @return SMBusStatus
+ */
+SMBusStatus ArduinoSMBus::setCapacityMode(bool tenMilliwattHours) {
+  return setModeBits(BATTERY_MODE_CAPACITY_MODE, tenMilliwattHours);
+}
 
 /**
- * @brief Check if the battery status is OK.
- * Check for any alarm conditions in the battery status. These include over charge, 
- * termination charge, over temperature, termination discharge alarms. If any of these alarms are set, the battery is not OK.
- * 
- * @return bool True if the battery status is OK, false otherwise.
+ * @brief Enable or disable AlarmWarning broadcasts.
+ * Batteries clear this bit by themselves every 60 seconds, re-enabling broadcasts.
+ * @param disableBroadcasts True to stop AlarmWarning being sent to the host and charger.
+ * @return SMBusStatus
  */
-bool ArduinoSMBus::statusOK() {
-  BatteryStatus status = this->batteryStatus();
-  return !(status.over_charged_alarm || status.term_charge_alarm || status.over_temp_alarm || 
-           status.term_discharge_alarm);
+SMBusStatus ArduinoSMBus::setAlarmMode(bool disableBroadcasts) {
+  return setModeBits(BATTERY_MODE_ALARM_MODE, disableBroadcasts);
+}
+
+/**
+ * @brief Enable or disable ChargingCurrent and ChargingVoltage broadcasts to the charger.
+ * @param disableBroadcasts True to stop the broadcasts.
+ * @return SMBusStatus
+ */
+SMBusStatus ArduinoSMBus::setChargerMode(bool disableBroadcasts) {
+  return setModeBits(BATTERY_MODE_CHARGER_MODE, disableBroadcasts);
+}
+
+/**
+ * @brief Get the battery's temperature in Celsius.
+ * Returns the battery temperature in 0.1 degrees Celsius, negative below freezing.
+ * @return int16_t
+ */
+int16_t ArduinoSMBus::temperatureC() {
+  return smbusDeciCelsius(temperature());
+}
+
+/**
+ * @brief Get the battery's temperature in Fahrenheit.
+ * Returns the battery temperature in 0.1 degrees Fahrenheit.
+ * @return int16_t
+ */
+int16_t ArduinoSMBus::temperatureF() {
+  return smbusDeciFahrenheit(temperature());
 }
 
 /**
- * @brief  Get the battery's cycle count.
- * Returns the number of discharge cycles the battery has experienced.
- * A cycle is defined as an amount of discharge equal to the battery's design capacity.
- * @return uint16_t 
+ * @brief Get the battery's power.
+ * Returns voltage() times current(), in mW, negative when discharging.
+ * @return int32_t
  */
-uint16_t ArduinoSMBus::cycleCount() {
-  return readRegister(CYCLE_COUNT);
+int32_t ArduinoSMBus::power() {
+  uint16_t millivolts = voltage();
+  return smbusMilliwatts(millivolts, current());
 }
 
 /**
- * @brief Get the battery's design capacity.
- * Returns the theoretical maximum capacity of the battery, in mAh.
- * For some batteries, this may be in 10 mWh, if the BatteryMode() register (0x03) is set to CAPM 1.
- * See TI protocol documentation for details.
- * @return uint16_t 
+ * @brief Get the battery's average power.
+ * Returns voltage() times averageCurrent(), in mW, negative when discharging.
+ * @return int32_t
  */
-uint16_t ArduinoSMBus::designCapacity() {
-  return readRegister(DESIGN_CAPACITY);
+int32_t ArduinoSMBus::averagePower() {
+  uint16_t millivolts = voltage();
+  return smbusMilliwatts(millivolts, averageCurrent());
 }
 
 /**
- * @brief Get the battery's design voltage.
- * Returns the nominal voltage of the battery, in mV.
- * @return uint16_t 
+ * @brief Get the battery's remaining energy.
+ * Returns remainingCapacity() in mWh. If the battery reports capacity in mAh
+ * (BatteryMode capacity_mode clear), it is multiplied by designVoltage().
+ * @return uint32_t
  */
-uint16_t ArduinoSMBus::designVoltage() {
-  return readRegister(DESIGN_VOLTAGE);
+uint32_t ArduinoSMBus::remainingEnergy() {
+  if (batteryMode().capacityMode()) {
+    return smbusMilliwattHours(remainingCapacity(), 0, true);
+  }
+  uint16_t capacity = remainingCapacity();
+  return smbusMilliwattHours(capacity, designVoltage(), false);
 }
 
 /**
- * @brief  Get the battery's manufacture date.
- * Returns the date the battery was manufactured, in the following format: 
- * Day + Month*32 + (Year–1980)*512
- * @return uint16_t 
+ * @brief Get the battery's full charge energy.
+ * Returns fullCapacity() in mWh. If the battery reports capacity in mAh
+ * (BatteryMode capacity_mode clear), it is multiplied by designVoltage().
+ * @return uint32_t
  */
-uint16_t ArduinoSMBus::manufactureDate() {
-  return readRegister(MANUFACTURE_DATE);
+uint32_t ArduinoSMBus::fullEnergy() {
+  if (batteryMode().capacityMode()) {
+    return smbusMilliwattHours(fullCapacity(), 0, true);
+  }
+  uint16_t capacity = fullCapacity();
+  return smbusMilliwattHours(capacity, designVoltage(), false);
+}
+
+/**
+ * @brief Check if the battery status is OK.
+ * Check for any alarm conditions in the battery status. These include over charge, 
+ * termination charge, over temperature, termination discharge alarms. If any of these alarms are set, the battery is not OK.
+ * 
+ * @return bool True if the battery status is OK, false otherwise.
+ */
+bool ArduinoSMBus::statusOK() {
+  return batteryStatus().ok();
 }
 
 /**
@@ -329,115 +581,982 @@ int ArduinoSMBus::manufactureYear() {
   return year;
 }
 
-/**
- * @brief Get the Serial Number from the battery.
- * 
- * @return uint16_t 
- */
-uint16_t ArduinoSMBus::serialNumber() {
-  return readRegister(SERIAL_NUMBER);
-}
-
 /**
  * @brief Get the Manufacturer Name from the battery.
  * 
- * @return const char* 
+ * @return const char* Pointer to a buffer owned by this object, valid until the next call.
  */
 const char* ArduinoSMBus::manufacturerName() {
-  static char manufacturerName[21]; // 20 characters plus null terminator
-  readBlock(MANUFACTURER_NAME, reinterpret_cast<uint8_t*>(manufacturerName), 20);
-  manufacturerName[20] = '\0'; // Null-terminate the C-string
-  return manufacturerName;
+  return readString(MANUFACTURER_NAME, _manufacturerName, sizeof(_manufacturerName));
 }
 
 /**
  * @brief Get the Device Name from the battery.
  * 
- * @return const char* 
+ * @return const char* Pointer to a buffer owned by this object, valid until the next call.
  */
 const char* ArduinoSMBus::deviceName() {
-  static char deviceName[21]; // Assuming the device name is up to 20 characters long
-  readBlock(DEVICE_NAME, reinterpret_cast<uint8_t*>(deviceName), 20);
-  deviceName[20] = '\0'; // Null-terminate the C-string
-  return deviceName;
+  return readString(DEVICE_NAME, _deviceName, sizeof(_deviceName));
 }
 
 /**
  * @brief Get the Device Chemistry from the battery.
  * 
- * @return const char* 
+ * @return const char* Pointer to a buffer owned by this object, valid until the next call.
  */
 const char* ArduinoSMBus::deviceChemistry() {
-  static char deviceChemistry[5];
-  readBlock(DEVICE_CHEMISTRY, reinterpret_cast<uint8_t*>(deviceChemistry), 8);
-  deviceChemistry[4] = '\0';
-  return deviceChemistry;
+  return readString(DEVICE_CHEMISTRY, _deviceChemistry, sizeof(_deviceChemistry));
 }
 
 /**
- * @brief Get the State of Health from the battery.
- * Returns the estimated health of the battery, as a percentage of design capacity
- * This command is not supported by all batteries.
- * @return uint16_t 
+ * @brief Read the Manufacturer Name into a caller-provided buffer.
+ * Uses no storage of its own, so any number of objects and tasks can read identity
+ * strings at once, each with its own buffer. Always reads from the battery.
+ * @param buffer Receives the name, null-terminated.
+ * @param length Size of buffer; SMBUS_BLOCK_MAX + 1 holds any name the battery can return.
+ * @return uint8_t Number of characters stored, 0 if the read failed (see lastStatus()).
  */
-uint16_t ArduinoSMBus::stateOfHealth() {
-  uint8_t data[2];
-  readBlock(STATE_OF_HEALTH, data, 2);
-  uint16_t stateOfHealth = (data[1] << 8) | data[0];
-  return stateOfHealth;
+uint8_t ArduinoSMBus::manufacturerName(char* buffer, uint8_t length) {
+  return readBlockString(MANUFACTURER_NAME, buffer, length);
 }
 
+/**
+ * @brief Read the Device Name into a caller-provided buffer.
+ * See manufacturerName(char*, uint8_t).
+ * @param buffer Receives the name, null-terminated.
+ * @param length Size of buffer; SMBUS_BLOCK_MAX + 1 holds any name the battery can return.
+ * @return uint8_t Number of characters stored, 0 if the read failed (see lastStatus()).
+ */
+uint8_t ArduinoSMBus::deviceName(char* buffer, uint8_t length) {
+  return readBlockString(DEVICE_NAME, buffer, length);
+}
 
+/**
+ * @brief Read the Device Chemistry into a caller-provided buffer.
+ * See manufacturerName(char*, uint8_t).
+ * @param buffer Receives the chemistry, null-terminated.
+ * @param length Size of buffer; SMBUS_BLOCK_MAX + 1 holds any string the battery can return.
+ * @return uint8_t Number of characters stored, 0 if the read failed (see lastStatus()).
+ */
+uint8_t ArduinoSMBus::deviceChemistry(char* buffer, uint8_t length) {
+  return readBlockString(DEVICE_CHEMISTRY, buffer, length);
+}
+
+/**
+ * @brief Enable or disable the register cache.
+ * The first time the cache is enabled, every SMBUS_STATIC register in SMBUS_REGISTERS
+ * (design capacity and voltage, serial number, manufacture date and the identity strings)
+ * is set to SMBUS_CACHE_IMMUTABLE, and every SMBUS_SLOW register (cycle count, state of
+ * health) to a SMBUS_SLOW_TTL_MS TTL, unless a policy was already set for it. All other
+ * registers are live until configured with setCachePolicy().
+ * @param enable
+ */
+void ArduinoSMBus::enableCache(bool enable) {
+  if (enable && _cacheCount == 0) {
+    for (uint8_t i = 0; i < SMBUS_REGISTER_COUNT; i++) {
+      if (smbusRegisters[i].volatility == SMBUS_STATIC) {
+        setCachePolicy(smbusRegisters[i].command, SMBUS_CACHE_IMMUTABLE);
+      } else if (smbusRegisters[i].volatility == SMBUS_SLOW) {
+        setCachePolicy(smbusRegisters[i].command, SMBUS_CACHE_TTL, SMBUS_SLOW_TTL_MS);
+      }
+    }
+  }
+  _cacheEnabled = enable;
+}
+
+/**
+ * @brief Check if the register cache is enabled.
+ * @return bool
+ */
+bool ArduinoSMBus::cacheEnabled() const {
+  return _cacheEnabled;
+}
+
+/**
+ * @brief Set how a register is cached.
+ * Changing a register's policy discards its cached value.
+ * @param reg Command code of the register.
+ * @param policy
+ * @param ttl Maximum age of a cached value in milliseconds, for SMBUS_CACHE_TTL.
+ * @return bool False if SMBUS_CACHE_SIZE registers already have a policy.
+ */
+bool ArduinoSMBus::setCachePolicy(uint8_t reg, SMBusCachePolicy policy, uint32_t ttl) {
+  CacheEntry* entry = cacheEntry(reg);
+  if (entry == nullptr) {
+    if (_cacheCount >= SMBUS_CACHE_SIZE) {
+      return false;
+    }
+    entry = &_cache[_cacheCount++];
+    entry->reg = reg;
+  }
+  entry->policy = policy;
+  entry->ttl = ttl;
+  entry->valid = false;
+  return true;
+}
+
+/**
+ * @brief Get the cache policy of a register.
+ * @param reg
+ * @return SMBusCachePolicy SMBUS_CACHE_LIVE for registers without a policy.
+ */
+SMBusCachePolicy ArduinoSMBus::cachePolicy(uint8_t reg) const {
+  for (uint8_t i = 0; i < _cacheCount; i++) {
+    if (_cache[i].reg == reg) {
+      return _cache[i].policy;
+    }
+  }
+  return SMBUS_CACHE_LIVE;
+}
+
+/**
+ * @brief Discard all cached values. Policies are kept.
+ */
+void ArduinoSMBus::invalidateCache() {
+  for (uint8_t i = 0; i < _cacheCount; i++) {
+    _cache[i].valid = false;
+  }
+}
+
+/**
+ * @brief Discard the cached value of one register.
+ * @param reg
+ */
+void ArduinoSMBus::invalidateCache(uint8_t reg) {
+  CacheEntry* entry = cacheEntry(reg);
+  if (entry != nullptr) {
+    entry->valid = false;
+  }
+}
+
+/**
+ * @brief Get the number of reads answered from the cache.
+ * @return uint32_t
+ */
+uint32_t ArduinoSMBus::cacheHits() const {
+  return _cacheHits;
+}
+
+/**
+ * @brief Get the number of reads of cached registers that had to go to the battery.
+ * Reads of live registers are not counted.
+ * @return uint32_t
+ */
+uint32_t ArduinoSMBus::cacheMisses() const {
+  return _cacheMisses;
+}
+
+/**
+ * @brief Reset the cache hit and miss counters.
+ */
+void ArduinoSMBus::resetCacheStats() {
+  _cacheHits = 0;
+  _cacheMisses = 0;
+}
+
+/**
+ * @brief Read a set of dynamic registers in one pass.
+ * The registers selected by fields are read back to back, with nothing but the
+ * command turnaround between them, so together they describe the battery at one
+ * point in time. Fields that were not requested or could not be read are left
+ * unchanged and have their bit cleared in snapshot.valid. Snapshots always read
+ * from the battery, but refresh any cached registers they include.
+ * @param snapshot Snapshot to fill.
+ * @param fields Mask of SNAPSHOT_* bits to read, SNAPSHOT_ALL by default.
+ * @return bool True if every requested field was read.
+ */
+bool ArduinoSMBus::readSnapshot(BatterySnapshot& snapshot, uint16_t fields) {
+  snapshot.timestamp = millis();
+  snapshot.valid = 0;
+  unsigned long start = micros();
+
+  for (uint8_t i = 0; i < sizeof(snapshotRegisters) / sizeof(snapshotRegisters[0]); i++) {
+    uint16_t bit = 1 << i;
+    if (!(fields & bit)) {
+      continue;
+    }
+    uint16_t* field = reinterpret_cast<uint16_t*>(reinterpret_cast<uint8_t*>(&snapshot) + snapshotRegisters[i].offset);
+    SMBusResult result = readWord(snapshotRegisters[i].command);
+    if (result.ok()) {
+      *field = result.value;
+      snapshot.valid |= bit;
+    }
+  }
+
+  snapshot.duration = micros() - start;
+  return (snapshot.valid & fields) == fields;
+}
+
+/**
+ * @brief Read snapshots from several batteries on the same bus, overlapping their turnarounds.
+ * Each register is read from all batteries with split transactions: the command is sent to
+ * every battery first, each with a STOP, and the words are collected afterwards in the same
+ * order. While one battery prepares its data the bus carries the commands and data of the
+ * others, so the time spent waiting for turnarounds is shared instead of paid once per battery.
+ * Each read is a single attempt; a battery whose read fails simply misses that field this round.
+ * The batteries must not have non-blocking reads pending.
+ * @param batteries Battery objects, each with its own address.
+ * @param snapshots One snapshot per battery to fill, see readSnapshot().
+ * @param fields One mask of SNAPSHOT_* bits per battery.
+ * @param count Number of batteries.
+ * @return uint8_t Number of batteries for which every requested field was read.
+ */
+uint8_t ArduinoSMBus::readSnapshots(ArduinoSMBus* const batteries[], BatterySnapshot snapshots[],
+                                    const uint16_t fields[], uint8_t count) {
+  uint32_t timestamp = millis();
+  unsigned long start = micros();
+  for (uint8_t j = 0; j < count; j++) {
+    snapshots[j].timestamp = timestamp;
+    snapshots[j].valid = 0;
+  }
+
+  for (uint8_t i = 0; i < sizeof(snapshotRegisters) / sizeof(snapshotRegisters[0]); i++) {
+    uint16_t bit = 1 << i;
+    uint8_t command = snapshotRegisters[i].command;
+    for (uint8_t j = 0; j < count; j++) {
+      if (fields[j] & bit) {
+        batteries[j]->sendCommand(command);
+      }
+    }
+    for (uint8_t j = 0; j < count; j++) {
+      if (!(fields[j] & bit)) {
+        continue;
+      }
+      SMBusResult result = batteries[j]->receiveWord();
+      if (result.ok()) {
+        *reinterpret_cast<uint16_t*>(reinterpret_cast<uint8_t*>(&snapshots[j]) + snapshotRegisters[i].offset) =
+            result.value;
+        snapshots[j].valid |= bit;
+      }
+    }
+  }
+
+  uint8_t complete = 0;
+  for (uint8_t j = 0; j < count; j++) {
+    snapshots[j].duration = micros() - start;
+    complete += (snapshots[j].valid & fields[j]) == fields[j];
+  }
+  return complete;
+}
+
+/**
+ * @brief Find where a register is held in a BatterySnapshot.
+ * @param reg Command code of the register.
+ * @param snapshot
+ * @param value Receives a pointer to the field if the snapshot has one, otherwise nullptr.
+ * @return uint16_t The field's SNAPSHOT_* bit, or 0 if a snapshot does not include the register.
+ */
+uint16_t ArduinoSMBus::snapshotField(uint8_t reg, const BatterySnapshot& snapshot, const uint16_t*& value) {
+  for (uint8_t i = 0; i < sizeof(snapshotRegisters) / sizeof(snapshotRegisters[0]); i++) {
+    if (snapshotRegisters[i].command == reg) {
+      value = reinterpret_cast<const uint16_t*>(reinterpret_cast<const uint8_t*>(&snapshot) + snapshotRegisters[i].offset);
+      return 1 << i;
+    }
+  }
+  value = nullptr;
+  return 0;
+}
 
+/**
+ * @brief Send a command as its own transaction, ending with a STOP.
+ * First half of a split read: the bus is free while the battery prepares the data,
+ * which receiveWord() collects afterwards. Lets a caller do other bus work, such as
+ * commanding other batteries, during the turnaround.
+ * @param reg Command code of the register.
+ * @return SMBusStatus
+ */
+SMBusStatus ArduinoSMBus::sendCommand(uint8_t reg) {
+  Wire.beginTransmission(_batteryAddress);
+  Wire.write(reg);
+  SMBusStatus status = writeStatus(Wire.endTransmission());
+  _commandPending = status == SMBUS_OK;
+  _command = reg;
+  _commandStart = micros();
+  _lastStatus = status;
+  return status;
+}
 
+/**
+ * @brief Collect the word for the command last sent with sendCommand().
+ * Waits only for whatever part of the split turnaround has not already passed since the
+ * command was sent. An early read is NACKed by the battery; the turnaround is then raised
+ * and the read retried, without resending the command.
+ * @return SMBusResult If no command is pending, the status of the failed sendCommand().
+ */
+SMBusResult ArduinoSMBus::receiveWord() {
+  SMBusResult result = {SMBUS_OK, 0};
+  if (!_commandPending) {
+    result.status = _lastStatus != SMBUS_OK ? _lastStatus : SMBUS_BUS_ERROR;
+    return result;
+  }
+  _commandPending = false;
 
+  for (;;) {
+    unsigned long elapsed = micros() - _commandStart;
+    if (elapsed < _splitTurnaround.us) {
+      delayMicroseconds(_splitTurnaround.us - elapsed);
+    }
 
+    uint8_t received = Wire.requestFrom((int)_batteryAddress, (int)wordQuantity());
+    result.status = receiveWordData(_command, false, received, result.value);
+    if (result.status == SMBUS_OK) {
+      turnaroundSucceeded(_splitTurnaround);
+      cacheStore(_command, result.value);
+      break;
+    }
+    if (result.status != SMBUS_NACK_ADDRESS || !turnaroundFailed(_splitTurnaround)) {
+      result.value = 0;
+      break;
+    }
+  }
+  _lastStatus = result.status;
+  return result;
+}
+
+/**
+ * @brief Queue a non-blocking word read.
+ * The read is carried out by subsequent calls to poll(), which never wait: the command
+ * is sent with a STOP so the bus is free while the battery prepares the data, and the
+ * data is collected by the first poll() after the turnaround has elapsed.
+ * Blocking getters must not be called on this object while reads are pending.
+ *
+ * Reads are served highest priority first, in the order queued within a priority. A read
+ * queued while one of lower priority waits for its turnaround preempts it: the waiting
+ * read's data is never collected, and its command is sent again once the higher priority
+ * reads are done. A read that has reached its data phase is always finished first, so an
+ * urgent read waits at most for one data phase, then its own command, turnaround and data.
+ * @param reg Command code of the register.
+ * @param callback Called from poll() with the register value once the read completes or fails.
+ * @param context Passed through to the callback.
+ * @param priority
+ * @return bool False if SMBUS_ASYNC_QUEUE_SIZE reads are already pending.
+ */
+bool ArduinoSMBus::beginRead(uint8_t reg, SMBusReadCallback callback, void* context, SMBusPriority priority) {
+  return beginReadBlock(reg, nullptr, 0, callback, context, priority);
+}
+
+/**
+ * @brief Queue a non-blocking block read.
+ * Like beginRead(), but for the block (string) registers. The callback receives the
+ * number of bytes stored in data as its value. Queue name strings at SMBUS_PRIORITY_LOW
+ * so status reads are not held up by their longer turnaround and transfer.
+ * @param reg Command code of the register.
+ * @param data Buffer for the block, which must stay valid until the callback runs.
+ * @param length Size of data.
+ * @param callback
+ * @param context
+ * @param priority
+ * @return bool False if SMBUS_ASYNC_QUEUE_SIZE reads are already pending.
+ */
+bool ArduinoSMBus::beginReadBlock(uint8_t reg, uint8_t* data, uint8_t length, SMBusReadCallback callback,
+                                  void* context, SMBusPriority priority) {
+  if (_asyncCount >= SMBUS_ASYNC_QUEUE_SIZE) {
+    return false;
+  }
+  if (priority >= SMBUS_PRIORITY_COUNT) {
+    priority = SMBUS_PRIORITY_URGENT;
+  }
+  // Insert after every read of the same or higher priority. The head stays in place while
+  // its command is latched, unless this read outranks it.
+  bool preempt = _asyncState == ASYNC_WAITING && priority > _asyncQueue[0].priority;
+  uint8_t first = _asyncState == ASYNC_WAITING && !preempt ? 1 : 0;
+  uint8_t i = _asyncCount;
+  while (i > first && _asyncQueue[i - 1].priority < priority) {
+    _asyncQueue[i] = _asyncQueue[i - 1];
+    i--;
+  }
+  AsyncRead& read = _asyncQueue[i];
+  read.reg = reg;
+  read.data = data;
+  read.length = length;
+  read.callback = callback;
+  read.context = context;
+  read.priority = priority;
+  read.queued = micros();
+  _asyncCount++;
+  if (preempt) {
+    // The preempted read goes back to sending its command
+    _asyncState = ASYNC_IDLE;
+    _asyncPreemptions++;
+  }
+  return true;
+}
+
+/**
+ * @brief Advance pending non-blocking reads.
+ * Performs at most one bus operation per call and returns immediately if the battery
+ * is still preparing data. Call it from loop() as often as convenient.
+ * @return bool True while reads are still pending.
+ */
+bool ArduinoSMBus::poll() {
+  if (_asyncCount == 0) {
+    return false;
+  }
+
+  AsyncRead& read = _asyncQueue[0];
+
+  if (_asyncState == ASYNC_IDLE) {
+    Wire.beginTransmission(_batteryAddress);
+    Wire.write(read.reg);
+    if (Wire.endTransmission() != 0) {
+      completeAsync(false, 0);
+    } else {
+      _asyncState = ASYNC_WAITING;
+      _asyncStart = micros();
+    }
+    return _asyncCount > 0;
+  }
+
+  if ((unsigned long)(micros() - _asyncStart) < _splitTurnaround.us) {
+    return true;
+  }
+
+  SMBusStatus status;
+  uint16_t value = 0;
+  if (read.data != nullptr) {
+    uint8_t count = 0;
+    uint8_t received = Wire.requestFrom((int)_batteryAddress, (int)blockQuantity(read.length));
+    status = receiveBlock(read.reg, false, received, read.data, read.length, count);
+    value = count;
+  } else {
+    uint8_t received = Wire.requestFrom((int)_batteryAddress, (int)wordQuantity());
+    status = receiveWordData(read.reg, false, received, value);
+    if (status == SMBUS_OK) {
+      cacheStore(read.reg, value);
+    }
+  }
+  _lastStatus = status;
+
+  if (status == SMBUS_OK) {
+    turnaroundSucceeded(_splitTurnaround);
+    completeAsync(true, value);
+  } else if (status != SMBUS_NACK_ADDRESS || !turnaroundFailed(_splitTurnaround)) {
+    completeAsync(false, 0);
+  }
+  // Otherwise keep waiting: the command is still latched and the turnaround was raised
+  return _asyncCount > 0;
+}
+
+/**
+ * @brief Get the number of non-blocking reads queued or in progress.
+ * @return uint8_t
+ */
+uint8_t ArduinoSMBus::pending() const {
+  return _asyncCount;
+}
+
+/**
+ * @brief Get the longest time a non-blocking read of a priority took, from being queued
+ * to its callback, including any time spent behind other reads.
+ * @param priority
+ * @return uint32_t Microseconds, 0 if none has completed since resetLatency().
+ */
+uint32_t ArduinoSMBus::worstLatency(SMBusPriority priority) const {
+  return priority < SMBUS_PRIORITY_COUNT ? _asyncWorst[priority] : 0;
+}
+
+/**
+ * @brief Get the number of times a waiting read was set back by a higher priority one.
+ * @return uint32_t
+ */
+uint32_t ArduinoSMBus::preemptions() const {
+  return _asyncPreemptions;
+}
+
+/**
+ * @brief Clear the latencies and preemption count.
+ */
+void ArduinoSMBus::resetLatency() {
+  for (uint8_t i = 0; i < SMBUS_PRIORITY_COUNT; i++) {
+    _asyncWorst[i] = 0;
+  }
+  _asyncPreemptions = 0;
+}
 
 /**
  * @brief Read a register from the battery.
  * Reads a standard 16-bit register from the battery.
  * @param reg 
- * @return uint16_t 
+ * @return uint16_t The register value, or 0 if the read failed; lastStatus() tells which.
  */
 uint16_t ArduinoSMBus::readRegister(uint8_t reg) {
+  uint16_t value = 0;
+  if (cacheLookup(reg, value)) {
+    _lastStatus = SMBUS_OK;
+    return value;
+  }
+  return readWord(reg).value;
+}
+
+/**
+ * @brief Make one Read Word transaction, adapting the turnaround.
+ * The read is a combined transaction with the turnaround between the command and the repeated
+ * START, which a gauge that needs more time clock-stretches. Where the core defers the command
+ * to the read, the delay cannot go between them, so once a turnaround is needed the command is
+ * sent with a STOP and the data read after it.
+ * @param reg
+ * @param value Set to the register value on success, left unchanged otherwise.
+ * @return SMBusStatus
+ */
+SMBusStatus ArduinoSMBus::wordTransaction(uint8_t reg, uint16_t& value) {
+  bool split = false;
+  for (;;) {
+    bool combined = !split && (!_deferredRepeatedStart || _turnaround.us == 0);
+    SMBusStatus status = writeCommand(reg, !combined);
+    if (status != SMBUS_OK) {
+      return status; // Battery absent or command rejected, waiting longer will not help
+    }
+
+    if (_turnaround.us) {
+      delayMicroseconds(_turnaround.us);
+    }
+
+    uint8_t received = Wire.requestFrom((int)_batteryAddress, (int)wordQuantity());
+    status = receiveWordData(reg, combined, received, value);
+    if (status == SMBUS_OK) {
+      turnaroundSucceeded(_turnaround);
+      return SMBUS_OK;
+    }
+
+    if (status == SMBUS_NACK_ADDRESS && combined && _deferredRepeatedStart) {
+      split = true; // The command's ACK was not seen: resend it on its own before blaming the turnaround
+      continue;
+    }
+    if (status != SMBUS_NACK_ADDRESS || !turnaroundFailed(_turnaround)) {
+      return status;
+    }
+  }
+}
+
+/**
+ * @brief Make one Read Block transaction, adapting the turnaround as wordTransaction() does.
+ * @param reg
+ * @param data
+ * @param length Size of data.
+ * @param count Set to the number of bytes stored in data.
+ * @return SMBusStatus
+ */
+SMBusStatus ArduinoSMBus::blockTransaction(uint8_t reg, uint8_t* data, uint8_t length, uint8_t& count) {
+  count = 0;
+  bool split = false;
+  for (;;) {
+    bool combined = !split && (!_deferredRepeatedStart || _turnaround.us == 0);
+    SMBusStatus status = writeCommand(reg, !combined);
+    if (status != SMBUS_OK) {
+      return status;
+    }
+
+    if (_turnaround.us) {
+      delayMicroseconds(_turnaround.us); // Give the device time to prepare the data
+    }
+
+    uint8_t received = Wire.requestFrom((int)_batteryAddress, (int)blockQuantity(length));
+    status = receiveBlock(reg, combined, received, data, length, count);
+    if (status == SMBUS_OK) {
+      turnaroundSucceeded(_turnaround);
+      return SMBUS_OK;
+    }
+
+    if (status == SMBUS_NACK_ADDRESS && combined && _deferredRepeatedStart) {
+      split = true;
+      continue;
+    }
+    if (status != SMBUS_NACK_ADDRESS || !turnaroundFailed(_turnaround)) {
+      return status;
+    }
+  }
+}
+
+/**
+ * @brief Write a command byte on its own.
+ * @param reg
+ * @param stop False to follow it with a repeated START. arduino-esp32 then reports 0 and
+ * sends it with the next read.
+ * @return SMBusStatus
+ */
+SMBusStatus ArduinoSMBus::writeCommand(uint8_t reg, bool stop) {
   Wire.beginTransmission(_batteryAddress);
   Wire.write(reg);
-  Wire.endTransmission();
-  
-  delay(10);
-  
-  Wire.requestFrom(_batteryAddress, 2);
-  
-  if(Wire.available()) {
-    return Wire.read() | Wire.read() << 8;
-  } else {
-    return 0;
+  return writeStatus(Wire.endTransmission(stop));
+}
+
+/**
+ * @brief Get the number of bytes to clock for a word read.
+ * @return uint8_t
+ */
+uint8_t ArduinoSMBus::wordQuantity() const {
+  return _pecEnabled ? 3 : 2;
+}
+
+/**
+ * @brief Get the number of bytes to clock for a block read into a buffer.
+ * Without PEC only as much of the block as fits in the buffer is clocked. With PEC the
+ * whole block and the PEC byte that follows it must be, so the largest block the buffer
+ * accepts is requested, or as much as the Wire buffer holds if that is less.
+ * @param length Size of the buffer.
+ * @return uint8_t
+ */
+uint8_t ArduinoSMBus::blockQuantity(uint8_t length) const {
+  uint16_t quantity = _pecEnabled ? (length > SMBUS_BLOCK_MAX ? length : SMBUS_BLOCK_MAX) + 2 : length + 1; // Length byte, data and PEC
+  return quantity < SMBUS_WIRE_BUFFER_LENGTH ? quantity : SMBUS_WIRE_BUFFER_LENGTH;
+}
+
+/**
+ * @brief Start the PEC of a read with the bytes the host sent.
+ * The PEC covers every byte since the last START, so a combined transaction includes the
+ * write address and command, while a split read starts from the read address.
+ * @param reg
+ * @param combined True if the read followed the command through a repeated START.
+ * @return uint8_t
+ */
+uint8_t ArduinoSMBus::pecStart(uint8_t reg, bool combined) const {
+  uint8_t crc = 0;
+  if (combined) {
+    crc = smbusPecByte(crc, _batteryAddress << 1);
+    crc = smbusPecByte(crc, reg);
   }
+  return smbusPecByte(crc, (_batteryAddress << 1) | 1);
 }
 
 /**
- * @brief Reads a block of data from the battery.
- * Length of block is specified by the length parameter.
- * @param reg 
- * @param data 
- * @param length 
+ * @brief Check the PEC byte that ends a read.
+ * @param crc PEC computed over the message.
+ * @param pec PEC byte received.
+ * @return SMBusStatus SMBUS_PEC_ERROR, counted in pecErrors(), if they differ.
+ */
+SMBusStatus ArduinoSMBus::checkPec(uint8_t crc, uint8_t pec) {
+  if (crc != pec) {
+    _pecErrors++;
+    return SMBUS_PEC_ERROR;
+  }
+  return SMBUS_OK;
+}
+
+/**
+ * @brief Take a word, and its PEC if enabled, from the bytes Wire received.
+ * @param reg Command the word belongs to.
+ * @param combined True if the read followed the command through a repeated START.
+ * @param received Return value of Wire.requestFrom().
+ * @param value Set to the word on success, left unchanged otherwise.
+ * @return SMBusStatus
+ */
+SMBusStatus ArduinoSMBus::receiveWordData(uint8_t reg, bool combined, uint8_t received, uint16_t& value) {
+  if (received == 0) {
+    return SMBUS_NACK_ADDRESS;
+  }
+  if (received < wordQuantity()) {
+    return SMBUS_SHORT_READ;
+  }
+  uint8_t low = Wire.read();
+  uint8_t high = Wire.read();
+  if (_pecEnabled) {
+    uint8_t crc = smbusPecByte(smbusPecByte(pecStart(reg, combined), low), high);
+    if (checkPec(crc, Wire.read()) != SMBUS_OK) {
+      return SMBUS_PEC_ERROR;
+    }
+  }
+  value = low | (high << 8);
+  return SMBUS_OK;
+}
+
+/**
+ * @brief Take a block, and its PEC if enabled, from the bytes Wire received.
+ * A block longer than the buffer is truncated to it. With PEC, a block that does not fit the
+ * Wire buffer together with its length byte and PEC fails with SMBUS_BUS_ERROR.
+ * @param reg Command the block belongs to.
+ * @param combined True if the read followed the command through a repeated START.
+ * @param received Return value of Wire.requestFrom().
+ * @param data Buffer for the block.
+ * @param length Size of data.
+ * @param count Set to the number of bytes stored in data.
+ * @return SMBusStatus
  */
-void ArduinoSMBus::readBlock(uint8_t reg, uint8_t* data, uint8_t length) {
+SMBusStatus ArduinoSMBus::receiveBlock(uint8_t reg, bool combined, uint8_t received, uint8_t* data,
+                                       uint8_t length, uint8_t& count) {
+  count = 0;
+  if (received == 0 || !Wire.available()) {
+    return SMBUS_NACK_ADDRESS;
+  }
+
+  // A released SDA line reads as 0xFF, so that length means the battery sent nothing. Any other
+  // length is real, e.g. a vendor block longer than 32 bytes, and is truncated like the rest.
+  uint8_t blockLength = Wire.read();
+  if (blockLength == 0xff) {
+    return SMBUS_NACK_ADDRESS;
+  }
+  if (_pecEnabled && blockLength + 2 > SMBUS_WIRE_BUFFER_LENGTH) {
+    return SMBUS_BUS_ERROR; // The PEC lies beyond what the Wire buffer can hold, so the block cannot be checked
+  }
+
+  uint8_t crc = smbusPecByte(pecStart(reg, combined), blockLength);
+  for (uint8_t i = 0; i < blockLength && (i < length || _pecEnabled); i++) {
+    if (!Wire.available()) {
+      return SMBUS_SHORT_READ;
+    }
+    uint8_t value = Wire.read();
+    crc = smbusPecByte(crc, value);
+    if (i < length) {
+      data[count++] = value;
+    }
+  }
+
+  if (_pecEnabled) {
+    if (!Wire.available()) {
+      return SMBUS_SHORT_READ;
+    }
+    return checkPec(crc, Wire.read());
+  }
+  return SMBUS_OK;
+}
+
+/**
+ * @brief Make one Write Word or Write Block transaction.
+ * @param reg
+ * @param data Word bytes, low byte first, or block contents.
+ * @param length
+ * @param block True to send the length byte of a Write Block before data.
+ * @return SMBusStatus
+ */
+SMBusStatus ArduinoSMBus::writeTransaction(uint8_t reg, const uint8_t* data, uint8_t length, bool block) {
   Wire.beginTransmission(_batteryAddress);
   Wire.write(reg);
-  Wire.endTransmission(false);
+  uint8_t crc = smbusPecByte(smbusPecByte(0, _batteryAddress << 1), reg);
+  if (block) {
+    Wire.write(length);
+    crc = smbusPecByte(crc, length);
+  }
+  Wire.write(data, length);
+  if (_pecEnabled) {
+    Wire.write(smbusPec(data, length, crc));
+  }
+  return writeStatus(Wire.endTransmission());
+}
 
-  delay(10); // Add a small delay to give the device time to prepare the data
+/**
+ * @brief Discard cached values made stale by a write.
+ * @param reg
+ */
+void ArduinoSMBus::writeCompleted(uint8_t reg) {
+  if (reg == BATTERY_MODE) {
+    invalidateCache();
+  } else {
+    invalidateCache(reg);
+  }
+}
+
+/**
+ * @brief Write one register and verify it, as a batch of one.
+ * @param reg
+ * @param value
+ * @param verifyMask
+ * @return SMBusStatus
+ */
+SMBusStatus ArduinoSMBus::writeVerified(uint8_t reg, uint16_t value, uint16_t verifyMask) {
+  SMBusWordWrite write = {reg, value, verifyMask, SMBUS_OK};
+  writeRegisters(&write, 1);
+  return write.status;
+}
+
+/**
+ * @brief Set or clear BatteryMode bits, keeping the others as the battery reports them.
+ * @param bits BATTERY_MODE_* bits the host may write.
+ * @param set
+ * @return SMBusStatus
+ */
+SMBusStatus ArduinoSMBus::setModeBits(uint16_t bits, bool set) {
+  SMBusResult mode = readWord(BATTERY_MODE);
+  if (!mode.ok()) {
+    return mode.status;
+  }
+  return setBatteryMode(BatteryMode(set ? mode.value | bits : mode.value & ~bits));
+}
+
+/**
+ * @brief Decide whether to retry a failed transaction, and wait before doing so.
+ * @param status Result of the failed attempt.
+ * @param attempt Number of retries made so far.
+ * @return bool True if the transaction should be repeated.
+ */
+bool ArduinoSMBus::retryAfter(SMBusStatus status, uint8_t attempt) {
+  if (attempt >= _retries) {
+    return false;
+  }
+  if (status == SMBUS_TIMEOUT) {
+    recoverBus();
+  }
+  delayMicroseconds((uint32_t)_retryBackoffUs << (attempt < 8 ? attempt : 8));
+  return true;
+}
+
+/**
+ * @brief Translate a TwoWire::endTransmission() result.
+ * @param error 0 success, 2 address NACK, 3 data NACK, 5 timeout (ESP32), other values are controller errors.
+ * @return SMBusStatus
+ */
+SMBusStatus ArduinoSMBus::writeStatus(uint8_t error) {
+  switch (error) {
+    case 0:
+      return SMBUS_OK;
+    case 2:
+      return SMBUS_NACK_ADDRESS;
+    case 3:
+      return SMBUS_NACK_DATA;
+    case 5:
+      return SMBUS_TIMEOUT;
+    default:
+      return SMBUS_BUS_ERROR;
+  }
+}
 
-  uint8_t count = Wire.requestFrom(_batteryAddress, length + 1); // Request one extra byte for the length
+/**
+ * @brief Record a good read for turnaround adaptation.
+ * Remembers the turnaround as known-good and, every SMBUS_TURNAROUND_PROBE_READS good reads,
+ * shortens it by an eighth to probe for a smaller value.
+ * @param turnaround
+ */
+void ArduinoSMBus::turnaroundSucceeded(Turnaround& turnaround) {
+  if (!_adaptiveTurnaround) {
+    return;
+  }
+  turnaround.goodUs = turnaround.us;
+  if (turnaround.us > 0 && ++turnaround.streak >= SMBUS_TURNAROUND_PROBE_READS) {
+    turnaround.streak = 0;
+    uint16_t step = turnaround.us / 8;
+    turnaround.us -= step ? step : turnaround.us;
+  }
+}
 
-  if (Wire.available()) {
-    count = Wire.read(); // The first byte is the length of the block
+/**
+ * @brief Record a failed read for turnaround adaptation.
+ * A failed probe falls back to the last known-good turnaround, otherwise the turnaround is
+ * doubled, up to SMBUS_TURNAROUND_MAX_US. Only for a read that came back empty after the
+ * battery ACKed its command with a STOP, so an absent pack or a rejected command, which
+ * waiting cannot fix, never raises it.
+ * @param turnaround
+ * @return bool True if the turnaround was raised and the read should be retried.
+ */
+bool ArduinoSMBus::turnaroundFailed(Turnaround& turnaround) {
+  turnaround.streak = 0;
+  if (!_adaptiveTurnaround || turnaround.us >= SMBUS_TURNAROUND_MAX_US) {
+    return false;
   }
+  if (turnaround.us < turnaround.goodUs) {
+    turnaround.us = turnaround.goodUs;
+  } else if (turnaround.us == 0) {
+    turnaround.us = SMBUS_TURNAROUND_STEP_US;
+  } else {
+    turnaround.us = turnaround.us > SMBUS_TURNAROUND_MAX_US / 2 ? SMBUS_TURNAROUND_MAX_US : turnaround.us * 2;
+  }
+  return true;
+}
 
-  for (uint8_t i = 0; i < count && i < length; i++) {
-    if (Wire.available()) {
-      data[i] = Wire.read();
+/**
+ * @brief Find the cache entry of a register.
+ * @param reg
+ * @return CacheEntry* nullptr if the register has no cache policy.
+ */
+ArduinoSMBus::CacheEntry* ArduinoSMBus::cacheEntry(uint8_t reg) {
+  for (uint8_t i = 0; i < _cacheCount; i++) {
+    if (_cache[i].reg == reg) {
+      return &_cache[i];
     }
   }
-}
\ No newline at end of file
+  return nullptr;
+}
+
+/**
+ * @brief Look up a register in the cache.
+ * Counts a hit or a miss for registers with a non-live policy.
+ * @param reg
+ * @param value Set to the cached value on a hit.
+ * @return bool True if the cached value is fresh and can be used instead of reading.
+ */
+bool ArduinoSMBus::cacheLookup(uint8_t reg, uint16_t& value) {
+  if (!_cacheEnabled) {
+    return false;
+  }
+  CacheEntry* entry = cacheEntry(reg);
+  if (entry == nullptr || entry->policy == SMBUS_CACHE_LIVE) {
+    return false;
+  }
+  if (entry->valid && (entry->policy == SMBUS_CACHE_IMMUTABLE || millis() - entry->timestamp < entry->ttl)) {
+    _cacheHits++;
+    value = entry->value;
+    return true;
+  }
+  _cacheMisses++;
+  return false;
+}
+
+/**
+ * @brief Store a freshly read value for a cached register.
+ * @param reg
+ * @param value
+ */
+void ArduinoSMBus::cacheStore(uint8_t reg, uint16_t value) {
+  if (!_cacheEnabled) {
+    return;
+  }
+  CacheEntry* entry = cacheEntry(reg);
+  if (entry != nullptr && entry->policy != SMBUS_CACHE_LIVE) {
+    entry->value = value;
+    entry->timestamp = millis();
+    entry->valid = true;
+  }
+}
+
+/**
+ * @brief Read a string register into a buffer owned by this object, through the cache.
+ * @param reg
+ * @param buffer
+ * @param length Size of buffer, including the null terminator.
+ * @return const char* buffer
+ */
+const char* ArduinoSMBus::readString(uint8_t reg, char* buffer, uint8_t length) {
+  uint16_t unused;
+  if (!cacheLookup(reg, unused) && readBlockString(reg, buffer, length) > 0) {
+    cacheStore(reg, 0);
+  }
+  return buffer;
+}
+
+/**
+ * @brief Read a string register straight into a buffer and null-terminate it.
+ * The block is stored in place, up to its length byte or the size of the buffer,
+ * whichever is smaller; no intermediate copy is made.
+ * @param reg
+ * @param buffer
+ * @param length Size of buffer, including the null terminator.
+ * @return uint8_t Number of characters stored, 0 if the read failed or length is 0.
+ */
+uint8_t ArduinoSMBus::readBlockString(uint8_t reg, char* buffer, uint8_t length) {
+  if (length == 0) {
+    return 0;
+  }
+  SMBusResult result = readBlock(reg, reinterpret_cast<uint8_t*>(buffer), length - 1);
+  uint8_t count = result.ok() ? result.value : 0; // Do not return a partial string
+  buffer[count] = '\0';
+  return count;
+}
+
+/**
+ * @brief Finish the non-blocking read at the head of the queue and run its callback.
+ * The read is removed from the queue first, so the callback may queue further reads.
+ * @param ok
+ * @param value
+ */
+void ArduinoSMBus::completeAsync(bool ok, uint16_t value) {
+  AsyncRead read = _asyncQueue[0];
+  _asyncCount--;
+  for (uint8_t i = 0; i < _asyncCount; i++) {
+    _asyncQueue[i] = _asyncQueue[i + 1];
+  }
+  _asyncState = ASYNC_IDLE;
+  uint32_t latency = micros() - read.queued;
+  if (latency > _asyncWorst[read.priority]) {
+    _asyncWorst[read.priority] = latency;
+  }
+  if (read.callback != nullptr) {
+    read.callback(read.reg, value, ok, read.context);
+  }
+}
@@ -0,0 +1,282 @@
+/**
+ * @file BatteryBus.cpp
+ * @brief Fair scheduling of many battery packs on one SMBus.
+ * @version 1.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "BatteryBus.h"
+
+// Virtual time is bus microseconds scaled by this factor and divided by the pack weight
+#define BATTERY_BUS_VIRTUAL_SCALE 16
+
+BatteryBus::BatteryBus() : _count(0), _windowStart(0) {
+}
+
+/**
+ * @brief Register a pack.
+ * Each pack is polled through its own ArduinoSMBus object, so turnaround, cache and
+ * identity strings are kept per pack.
+ * @param battery The pack's battery object.
+ * @param weight Relative share of bus time, at least 1.
+ * @param fields SNAPSHOT_* bits to read on each poll.
+ * @return int8_t Index of the pack, or -1 if BATTERY_BUS_MAX_PACKS packs are registered.
+ */
+int8_t BatteryBus::addPack(ArduinoSMBus& battery, uint8_t weight, uint16_t fields) {
+  if (_count >= BATTERY_BUS_MAX_PACKS) {
+    return -1;
+  }
+  Pack& pack = _packs[_count];
+  memset(&pack, 0, sizeof(Pack));
+  pack.battery = &battery;
+  pack.fields = fields;
+  pack.weight = weight ? weight : 1;
+  pack.maxShare = 100;
+  pack.virtualTime = minimumVirtualTime(); // Join at the current front, without credit
+  return _count++;
+}
+
+/**
+ * @brief Get the number of registered packs.
+ * @return uint8_t
+ */
+uint8_t BatteryBus::packCount() const {
+  return _count;
+}
+
+/**
+ * @brief Set a pack's relative share of bus time.
+ * @param pack Index returned by addPack().
+ * @param weight At least 1. A pack with weight 2 gets twice the bus time of a pack with weight 1.
+ */
+void BatteryBus::setWeight(uint8_t pack, uint8_t weight) {
+  if (pack < _count) {
+    _packs[pack].weight = weight ? weight : 1;
+  }
+}
+
+/**
+ * @brief Cap the share of bus time a pack may use in each BATTERY_BUS_WINDOW_MS window.
+ * The cap is checked before each poll, so a pack can exceed it by at most one poll.
+ * @param pack Index returned by addPack().
+ * @param percent 1 to 100, 100 meaning no cap.
+ */
+void BatteryBus::setMaxShare(uint8_t pack, uint8_t percent) {
+  if (pack < _count) {
+    _packs[pack].maxShare = percent > 100 ? 100 : percent;
+  }
+}
+
+/**
+ * @brief Set the minimum time between polls of a pack.
+ * @param pack Index returned by addPack().
+ * @param periodMs 0 to poll as often as the schedule allows.
+ */
+void BatteryBus::setPeriod(uint8_t pack, uint32_t periodMs) {
+  if (pack < _count) {
+    _packs[pack].periodMs = periodMs;
+  }
+}
+
+/**
+ * @brief Set which registers are read when a pack is polled.
+ * @param pack Index returned by addPack().
+ * @param fields SNAPSHOT_* bits.
+ */
+void BatteryBus::setFields(uint8_t pack, uint16_t fields) {
+  if (pack < _count) {
+    _packs[pack].fields = fields;
+  }
+}
+
+/**
+ * @brief Poll the next pack due according to the schedule.
+ * Call this from loop() or a polling task as often as bus time should be spent.
+ * @return int8_t Index of the pack polled, or -1 if no pack is currently eligible.
+ */
+int8_t BatteryBus::service() {
+  unsigned long now = millis();
+  rollWindow(now);
+
+  int8_t next = -1;
+  for (uint8_t i = 0; i < _count; i++) {
+    if (eligible(_packs[i], now) &&
+        (next < 0 || (int32_t)(_packs[i].virtualTime - _packs[next].virtualTime) < 0)) {
+      next = i;
+    }
+  }
+  if (next < 0) {
+    return -1;
+  }
+
+  Pack& pack = _packs[next];
+  unsigned long start = micros();
+  bool ok = pack.battery->readSnapshot(pack.snapshot, pack.fields);
+  uint32_t cost = micros() - start;
+
+  account(pack, now, cost, ok);
+  return next;
+}
+
+/**
+ * @brief Poll every eligible pack once, overlapping their turnarounds.
+ * Uses ArduinoSMBus::readSnapshots(): each register's command is sent to all packs before
+ * any data is collected, so one pack's turnaround is spent on the others' transfers rather
+ * than idling the bus. Aggregate throughput therefore grows with the number of packs until
+ * the bus itself is saturated. Weights do not apply within a round; share caps, periods and
+ * backoff do. The bus time of the round is divided evenly between the packs polled.
+ * @return uint8_t Number of packs polled.
+ */
+uint8_t BatteryBus::pollAll() {
+  unsigned long now = millis();
+  rollWindow(now);
+
+  ArduinoSMBus* batteries[BATTERY_BUS_MAX_PACKS];
+  BatterySnapshot snapshots[BATTERY_BUS_MAX_PACKS];
+  uint16_t fields[BATTERY_BUS_MAX_PACKS];
+  uint8_t indexes[BATTERY_BUS_MAX_PACKS];
+  uint8_t count = 0;
+  for (uint8_t i = 0; i < _count; i++) {
+    if (eligible(_packs[i], now)) {
+      batteries[count] = _packs[i].battery;
+      snapshots[count] = _packs[i].snapshot; // Fields that fail keep their previous value
+      fields[count] = _packs[i].fields;
+      indexes[count++] = i;
+    }
+  }
+  if (count == 0) {
+    return 0;
+  }
+
+  unsigned long start = micros();
+  ArduinoSMBus::readSnapshots(batteries, snapshots, fields, count);
+  uint32_t cost = (micros() - start) / count;
+
+  for (uint8_t j = 0; j < count; j++) {
+    Pack& pack = _packs[indexes[j]];
+    pack.snapshot = snapshots[j];
+    account(pack, now, cost, (snapshots[j].valid & fields[j]) == fields[j]);
+  }
+  return count;
+}
+
+/**
+ * @brief Get the battery object of a pack, e.g. to read its identity strings.
+ * Must not be used for bus access from another task while service() may run.
+ * @param pack Index returned by addPack().
+ * @return ArduinoSMBus&
+ */
+ArduinoSMBus& BatteryBus::battery(uint8_t pack) {
+  return *_packs[pack].battery;
+}
+
+/**
+ * @brief Get the latest snapshot of a pack.
+ * @param pack Index returned by addPack().
+ * @return const BatterySnapshot&
+ */
+const BatterySnapshot& BatteryBus::snapshot(uint8_t pack) const {
+  return _packs[pack].snapshot;
+}
+
+/**
+ * @brief Get the scheduling counters of a pack.
+ * @param pack Index returned by addPack().
+ * @return const BatteryBusPackStats&
+ */
+const BatteryBusPackStats& BatteryBus::stats(uint8_t pack) const {
+  return _packs[pack].stats;
+}
+
+/**
+ * @brief Check if a pack may be polled now.
+ * A pack coming out of backoff rejoins at the current front of the schedule, so it does
+ * not get a burst of polls to make up for the time it was skipped.
+ * @param pack
+ * @param now millis()
+ * @return bool
+ */
+bool BatteryBus::eligible(Pack& pack, unsigned long now) {
+  if (pack.stats.backingOff) {
+    if (now - pack.backoffStart < pack.backoffMs) {
+      return false;
+    }
+    uint32_t front = minimumVirtualTime(); // Excludes this pack while it is still backing off
+    if ((int32_t)(pack.virtualTime - front) < 0) {
+      pack.virtualTime = front;
+    }
+    pack.stats.backingOff = false;
+  }
+  if (pack.periodMs && pack.stats.polls && now - pack.lastPoll < pack.periodMs) {
+    return false;
+  }
+  if (pack.maxShare < 100 && pack.windowMicros >= (uint32_t)pack.maxShare * BATTERY_BUS_WINDOW_MS * 10) {
+    return false;
+  }
+  return true;
+}
+
+/**
+ * @brief Start a new share-cap window if the current one has ended.
+ * @param now millis()
+ */
+void BatteryBus::rollWindow(unsigned long now) {
+  if (now - _windowStart >= BATTERY_BUS_WINDOW_MS) {
+    _windowStart = now;
+    for (uint8_t i = 0; i < _count; i++) {
+      _packs[i].windowMicros = 0;
+    }
+  }
+}
+
+/**
+ * @brief Charge a poll to a pack and start or end its backoff.
+ * @param pack
+ * @param now millis() when the poll was scheduled.
+ * @param cost Bus time of the poll, in microseconds.
+ * @param ok True if every requested field was read.
+ */
+void BatteryBus::account(Pack& pack, unsigned long now, uint32_t cost, bool ok) {
+  cost = cost ? cost : 1;
+  pack.lastPoll = now;
+  pack.stats.polls++;
+  pack.stats.busMicros += cost;
+  pack.windowMicros += cost;
+  pack.virtualTime += cost * BATTERY_BUS_VIRTUAL_SCALE / pack.weight;
+
+  if (ok) {
+    pack.stats.consecutiveFailures = 0;
+    pack.backoffMs = 0;
+  } else {
+    pack.stats.failures++;
+    if (pack.stats.consecutiveFailures < 255) {
+      pack.stats.consecutiveFailures++;
+    }
+    pack.backoffMs = pack.backoffMs ? pack.backoffMs * 2 : BATTERY_BUS_BACKOFF_MIN_MS;
+    if (pack.backoffMs > BATTERY_BUS_BACKOFF_MAX_MS) {
+      pack.backoffMs = BATTERY_BUS_BACKOFF_MAX_MS;
+    }
+    pack.backoffStart = millis();
+    pack.stats.backingOff = true;
+  }
+}
+
+/**
+ * @brief Get the smallest virtual time of the packs that are not backing off.
+ * @return uint32_t
+ */
+uint32_t BatteryBus::minimumVirtualTime() const {
+  bool found = false;
+  uint32_t minimum = 0;
+  for (uint8_t i = 0; i < _count; i++) {
+    const Pack& pack = _packs[i];
+    if (!pack.stats.backingOff && (!found || (int32_t)(pack.virtualTime - minimum) < 0)) {
+      minimum = pack.virtualTime;
+      found = true;
+    }
+  }
+  return minimum;
+}
@@ -0,0 +1,209 @@
+/**
+ * @file BatteryPoller.cpp
+ * @brief Background task that owns the bus and publishes battery snapshots.
+ * @version 1.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "BatteryPoller.h"
+
+#ifdef SMBUS_HAS_ATOMICS
+
+/**
+ * @brief Construct a poller for a battery.
+ * @param battery Battery to poll. Must not be used by other code while the poller runs.
+ * @param fields SNAPSHOT_* bits to read on every poll.
+ */
+BatteryPoller::BatteryPoller(ArduinoSMBus& battery, uint16_t fields)
+    : _battery(battery), _fields(fields), _periodMs(0), _periodReason(POLL_NO_DATA), _rate(nullptr), _running(false),
+      _stopped(true) {
+#ifdef ESP32
+  _task = nullptr;
+#endif
+}
+
+BatteryPoller::~BatteryPoller() {
+  stop();
+}
+
+/**
+ * @brief Start the polling task.
+ * @param periodMs Time between the starts of consecutive snapshots, in milliseconds. With a rate
+ * controller, the time to the first snapshot after the first.
+ * @param stackSize Task stack size in bytes (ESP32 only).
+ * @param priority Task priority (ESP32 only).
+ * @return bool False if the poller is already running or the task could not be created.
+ */
+bool BatteryPoller::start(uint32_t periodMs, uint32_t stackSize, uint8_t priority) {
+  if (_running.load()) {
+    return false;
+  }
+  _periodMs.store(periodMs);
+  if (_rate != nullptr) {
+    _rate->reset();
+  }
+  _running.store(true);
+  _stopped.store(false);
+#ifdef ESP32
+  if (xTaskCreate(taskEntry, "BatteryPoller", stackSize, this, priority, &_task) != pdPASS) {
+    _task = nullptr;
+    _running.store(false);
+    _stopped.store(true);
+    return false;
+  }
+#else
+  (void)stackSize;
+  (void)priority;
+  _thread = std::thread(taskEntry, this);
+#endif
+  return true;
+}
+
+/**
+ * @brief Stop the polling task and wait for it to finish its current snapshot.
+ * A task waiting for its next poll is woken at once, so this never waits out a long period.
+ */
+void BatteryPoller::stop() {
+  _running.store(false);
+#ifdef ESP32
+  if (_task != nullptr) {
+    xTaskNotifyGive(_task);
+    while (!_stopped.load()) {
+      vTaskDelay(1);
+    }
+    vTaskDelete(_task);
+    _task = nullptr;
+  }
+#else
+  if (_thread.joinable()) {
+    _thread.join();
+  }
+#endif
+}
+
+/**
+ * @brief Check if the polling task is running.
+ * @return bool
+ */
+bool BatteryPoller::running() const {
+  return _running.load();
+}
+
+/**
+ * @brief Let a controller pick the period from each snapshot instead of using a fixed one.
+ * Set it before start(); the controller is then only used by the polling task.
+ * @param controller nullptr for a fixed period.
+ */
+void BatteryPoller::setRateController(AdaptivePollRate* controller) {
+  _rate = controller;
+}
+
+/**
+ * @brief Get the period in use. Safe to call from any task.
+ * @return uint32_t Milliseconds.
+ */
+uint32_t BatteryPoller::period() const {
+  return _periodMs.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Get what the rate controller based the period on. Safe to call from any task.
+ * @return PollReason POLL_NO_DATA without a rate controller.
+ */
+PollReason BatteryPoller::periodReason() const {
+  return (PollReason)_periodReason.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Read one snapshot and publish it.
+ * Used by the task, and can be called directly when no task is running.
+ * @return bool True if every requested field was read.
+ */
+bool BatteryPoller::pollOnce() {
+  BatterySnapshot snapshot;
+  memset(&snapshot, 0, sizeof(snapshot));
+  bool ok = _battery.readSnapshot(snapshot, _fields);
+  _publisher.publish(snapshot);
+  if (_rate != nullptr) {
+    _periodMs.store(_rate->update(snapshot), std::memory_order_relaxed);
+    _periodReason.store(_rate->reason(), std::memory_order_relaxed);
+  }
+  return ok;
+}
+
+/**
+ * @brief Get the most recently published snapshot.
+ * Safe to call from any number of tasks at once; never blocks and never uses the bus.
+ * @param snapshot
+ * @return bool False if nothing has been published yet.
+ */
+bool BatteryPoller::latest(BatterySnapshot& snapshot) const {
+  if (_publisher.publications() == 0) {
+    return false;
+  }
+  _publisher.read(snapshot);
+  return true;
+}
+
+/**
+ * @brief Get the number of snapshots published so far.
+ * @return uint32_t
+ */
+uint32_t BatteryPoller::publications() const {
+  return _publisher.publications();
+}
+
+/**
+ * @brief Get the underlying publisher, for readers that only need the snapshot.
+ * @return const SnapshotPublisher<BatterySnapshot>&
+ */
+const SnapshotPublisher<BatterySnapshot>& BatteryPoller::publisher() const {
+  return _publisher;
+}
+
+void BatteryPoller::taskEntry(void* poller) {
+  static_cast<BatteryPoller*>(poller)->run();
+#ifdef ESP32
+  // stop() deletes the task, so its handle stays valid until stop() is done with it
+  for (;;) {
+    vTaskSuspend(nullptr);
+  }
+#endif
+}
+
+/**
+ * @brief Task body: poll at the period, fixed or from the rate controller, until stopped.
+ * On ESP32 the wait for the next poll is a notification wait that stop() cuts short, as
+ * a rate controller can stretch the period to many seconds. On native builds time is
+ * simulated, so the period only advances the simulated clock and the thread polls as fast
+ * as the host allows, which is what a stress test wants.
+ */
+void BatteryPoller::run() {
+#ifdef ESP32
+  TickType_t wake = xTaskGetTickCount();
+  while (_running.load()) {
+    pollOnce();
+    TickType_t period = pdMS_TO_TICKS(_periodMs.load());
+    period = period ? period : 1;
+    wake += period;
+    TickType_t now = xTaskGetTickCount();
+    if ((TickType_t)(wake - now) > period) {
+      wake = now; // Already past the next start: poll now rather than catch up with a burst
+    } else {
+      ulTaskNotifyTake(pdTRUE, wake - now);
+    }
+  }
+#else
+  while (_running.load()) {
+    pollOnce();
+    delay(_periodMs.load());
+    std::this_thread::yield();
+  }
+#endif
+  _stopped.store(true);
+}
+
+#endif
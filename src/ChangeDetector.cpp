@@ -0,0 +1,200 @@
+/**
+ * @file ChangeDetector.cpp
+ * @brief Deadband filtering of register values, with a callback when a value moves.
+ * @version 1.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "ChangeDetector.h"
+
+/**
+ * @brief Construct a detector with no registers watched.
+ * @param battery Battery read by poll().
+ */
+ChangeDetector::ChangeDetector(ArduinoSMBus& battery)
+    : _battery(battery), _count(0), _samples(0), _notifications(0) {
+}
+
+/**
+ * @brief Watch a register, or change the settings of one already watched.
+ * @param reg Command code of a word register described in SMBUS_REGISTERS.
+ * @param deadband Smallest change reported, in raw register units. Ignored for bit fields.
+ * @param callback
+ * @param context Passed to the callback.
+ * @return bool False for block registers, unknown registers, or when CHANGE_DETECTOR_MAX_WATCHES
+ * registers are already watched.
+ */
+bool ChangeDetector::watch(uint8_t reg, uint16_t deadband, SMBusChangeCallback callback, void* context) {
+  uint8_t index = smbusRegisterIndex(reg);
+  if (index >= SMBUS_REGISTER_COUNT || smbusRegisters[index].wireType == SMBUS_WIRE_BLOCK) {
+    return false;
+  }
+  Watch* watch = find(reg);
+  if (watch == nullptr) {
+    if (_count >= CHANGE_DETECTOR_MAX_WATCHES) {
+      return false;
+    }
+    watch = &_watches[_count++];
+    watch->reg = reg;
+    watch->reported = false;
+    watch->value = 0;
+  }
+  watch->isSigned = smbusRegisters[index].wireType == SMBUS_WIRE_SIGNED_WORD;
+  watch->bitField = smbusRegisters[index].unit == SMBUS_UNIT_NONE;
+  watch->deadband = deadband;
+  watch->callback = callback;
+  watch->context = context;
+  return true;
+}
+
+/**
+ * @brief Stop watching a register.
+ * @param reg
+ * @return bool False if it was not watched.
+ */
+bool ChangeDetector::unwatch(uint8_t reg) {
+  Watch* watch = find(reg);
+  if (watch == nullptr) {
+    return false;
+  }
+  *watch = _watches[--_count];
+  return true;
+}
+
+/**
+ * @brief Change the deadband of a watched register. The value last reported stays the reference.
+ * @param reg
+ * @param deadband
+ * @return bool False if the register is not watched.
+ */
+bool ChangeDetector::setDeadband(uint8_t reg, uint16_t deadband) {
+  Watch* watch = find(reg);
+  if (watch == nullptr) {
+    return false;
+  }
+  watch->deadband = deadband;
+  return true;
+}
+
+/**
+ * @brief Forget the values reported, so the next sample of every register is reported.
+ */
+void ChangeDetector::reset() {
+  for (uint8_t i = 0; i < _count; i++) {
+    _watches[i].reported = false;
+  }
+}
+
+/**
+ * @brief Read every watched register through the battery and report those that moved.
+ * Registers whose read fails are skipped until the next poll.
+ * @return uint8_t Number of callbacks run.
+ */
+uint8_t ChangeDetector::poll() {
+  uint8_t changed = 0;
+  for (uint8_t i = 0; i < _count; i++) {
+    SMBusResult result = _battery.readWord(_watches[i].reg);
+    if (result.ok()) {
+      changed += check(_watches[i], result.value);
+    }
+  }
+  return changed;
+}
+
+/**
+ * @brief Take the watched registers a snapshot holds and report those that moved.
+ * Registers the snapshot does not hold, or read unsuccessfully, are left alone.
+ * @param snapshot
+ * @return uint8_t Number of callbacks run.
+ */
+uint8_t ChangeDetector::update(const BatterySnapshot& snapshot) {
+  uint8_t changed = 0;
+  for (uint8_t i = 0; i < _count; i++) {
+    const uint16_t* value;
+    uint16_t bit = ArduinoSMBus::snapshotField(_watches[i].reg, snapshot, value);
+    if (snapshot.valid & bit) {
+      changed += check(_watches[i], *value);
+    }
+  }
+  return changed;
+}
+
+/**
+ * @brief Report a value obtained some other way, e.g. from a beginRead() callback.
+ * @param reg
+ * @param value Raw register value.
+ * @return bool True if the callback ran.
+ */
+bool ChangeDetector::sample(uint8_t reg, uint16_t value) {
+  Watch* watch = find(reg);
+  return watch != nullptr && check(*watch, value);
+}
+
+/**
+ * @brief Get the number of samples taken of all watched registers.
+ * @return uint32_t
+ */
+uint32_t ChangeDetector::samples() const {
+  return _samples;
+}
+
+/**
+ * @brief Get the number of callbacks run.
+ * @return uint32_t
+ */
+uint32_t ChangeDetector::notifications() const {
+  return _notifications;
+}
+
+/**
+ * @brief Get the number of samples that did not move past their deadband.
+ * @return uint32_t
+ */
+uint32_t ChangeDetector::suppressed() const {
+  return _samples - _notifications;
+}
+
+ChangeDetector::Watch* ChangeDetector::find(uint8_t reg) {
+  for (uint8_t i = 0; i < _count; i++) {
+    if (_watches[i].reg == reg) {
+      return &_watches[i];
+    }
+  }
+  return nullptr;
+}
+
+/**
+ * @brief Compare a sample with the value last reported and run the callback if it moved.
+ * @param watch
+ * @param value
+ * @return bool True if the callback ran.
+ */
+bool ChangeDetector::check(Watch& watch, uint16_t value) {
+  _samples++;
+  uint16_t previous = watch.reported ? watch.value : value;
+  if (watch.reported) {
+    if (watch.bitField) {
+      if (value == watch.value) {
+        return false;
+      }
+    } else {
+      int32_t a = watch.isSigned ? (int16_t)value : value;
+      int32_t b = watch.isSigned ? (int16_t)watch.value : watch.value;
+      uint32_t change = a > b ? a - b : b - a;
+      if (change == 0 || change < watch.deadband) {
+        return false;
+      }
+    }
+  }
+
+  watch.reported = true;
+  watch.value = value;
+  _notifications++;
+  if (watch.callback != nullptr) {
+    watch.callback(watch.reg, value, previous, watch.context);
+  }
+  return true;
+}
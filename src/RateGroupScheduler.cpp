@@ -0,0 +1,293 @@
+/**
+ * @file RateGroupScheduler.cpp
+ * @brief Cyclic schedule of register reads at per-register rates.
+ * @version 1.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "RateGroupScheduler.h"
+
+/**
+ * @brief Construct a scheduler with no schedule.
+ * @param battery Battery to read. Should not be read by other code between frames.
+ */
+RateGroupScheduler::RateGroupScheduler(ArduinoSMBus& battery)
+    : _battery(battery), _busHz(RATE_GROUP_BUS_HZ), _overheadUs(RATE_GROUP_OVERHEAD_US),
+      _maxUtilisation(RATE_GROUP_MAX_UTILISATION), _turnaroundBound(RATE_GROUP_TURNAROUND_AUTO), _callback(nullptr), _context(nullptr), _count(0), _minorMs(0),
+      _frameCount(0), _worstUs(0), _started(false), _frame(0), _frameStart(0), _frames(0), _overruns(0),
+      _longestUs(0) {
+}
+
+/**
+ * @brief Set the SCL clock used to estimate read costs. Takes effect at the next configure().
+ * @param hz
+ */
+void RateGroupScheduler::setBusClock(uint32_t hz) {
+  _busHz = hz ? hz : RATE_GROUP_BUS_HZ;
+}
+
+/**
+ * @brief Set the driver time per transaction used to estimate read costs.
+ * Takes effect at the next configure().
+ * @param us
+ */
+void RateGroupScheduler::setTransactionOverhead(uint16_t us) {
+  _overheadUs = us;
+}
+
+/**
+ * @brief Set the share of a minor frame the busiest frame may fill. Takes effect at the next configure().
+ * @param percent 1 to 100.
+ */
+void RateGroupScheduler::setMaxUtilisation(uint8_t percent) {
+  _maxUtilisation = percent == 0 ? 1 : percent > 100 ? 100 : percent;
+}
+
+/**
+ * @brief Set the longest turnaround the battery is known to need, used to estimate read costs.
+ * Takes effect at the next configure().
+ * @param us RATE_GROUP_TURNAROUND_AUTO, the default, for the battery's fixed turnaround, or
+ * SMBUS_TURNAROUND_MAX_US while it adapts.
+ */
+void RateGroupScheduler::setTurnaroundBound(uint16_t us) {
+  _turnaroundBound = us;
+}
+
+/**
+ * @brief Set the callback for each read.
+ * @param callback
+ * @param context Passed to the callback.
+ */
+void RateGroupScheduler::onRead(SMBusReadCallback callback, void* context) {
+  _callback = callback;
+  _context = context;
+}
+
+/**
+ * @brief Build the schedule for a rate table. The previous schedule is kept if this fails.
+ * @param table One row per register.
+ * @param count Number of rows.
+ * @return RateGroupStatus
+ */
+RateGroupStatus RateGroupScheduler::configure(const RateGroupEntry* table, uint8_t count) {
+  if (count == 0 || count > RATE_GROUP_MAX_ENTRIES) {
+    return RATE_GROUP_TOO_MANY;
+  }
+
+  // Rate-monotonic order: shortest period first, stable for equal periods
+  uint8_t order[RATE_GROUP_MAX_ENTRIES];
+  for (uint8_t i = 0; i < count; i++) {
+    uint8_t index = smbusRegisterIndex(table[i].reg);
+    if (index >= SMBUS_REGISTER_COUNT || smbusRegisters[index].wireType == SMBUS_WIRE_BLOCK) {
+      return RATE_GROUP_BAD_REGISTER;
+    }
+    if (table[i].periodMs == 0) {
+      return RATE_GROUP_NOT_HARMONIC;
+    }
+    uint8_t j = i;
+    while (j > 0 && table[order[j - 1]].periodMs > table[i].periodMs) {
+      order[j] = order[j - 1];
+      j--;
+    }
+    order[j] = i;
+  }
+
+  uint32_t minor = table[order[0]].periodMs;
+  for (uint8_t i = 1; i < count; i++) {
+    if (table[order[i]].periodMs % table[order[i - 1]].periodMs != 0) {
+      return RATE_GROUP_NOT_HARMONIC;
+    }
+  }
+  if (table[order[count - 1]].periodMs / minor > RATE_GROUP_MAX_FRAMES) {
+    return RATE_GROUP_NOT_HARMONIC;
+  }
+
+  uint32_t cost = readCost();
+  Slot slots[RATE_GROUP_MAX_ENTRIES];
+  for (uint8_t i = 0; i < count; i++) {
+    slots[i].reg = table[order[i]].reg;
+    slots[i].every = table[order[i]].periodMs / minor;
+    slots[i].costUs = cost;
+    slots[i].offset = 0;
+  }
+
+  // Place each register at the offset whose frames carry the least load so far. Periods are
+  // harmonic, so every frame an offset covers carries the same load as the offset itself,
+  // and the busiest frame is the one a register was last added to.
+  uint32_t worst = 0;
+  for (uint8_t i = 0; i < count; i++) {
+    uint32_t bestLoad = UINT32_MAX;
+    for (uint16_t offset = 0; offset < slots[i].every && bestLoad > 0; offset++) {
+      uint32_t load = frameLoad(slots, i, offset);
+      if (load < bestLoad) {
+        bestLoad = load;
+        slots[i].offset = offset;
+      }
+    }
+    if (bestLoad + slots[i].costUs > worst) {
+      worst = bestLoad + slots[i].costUs;
+    }
+  }
+  if (_battery.adaptiveTurnaround()) {
+    worst += cost; // A failed probe of a shorter turnaround repeats one read
+  }
+  if (worst > minor * 10 * _maxUtilisation) {
+    return RATE_GROUP_OVERLOADED;
+  }
+
+  memcpy(_slots, slots, sizeof(Slot) * count);
+  _count = count;
+  _minorMs = minor;
+  _frameCount = table[order[count - 1]].periodMs / minor;
+  _worstUs = worst;
+  _started = false;
+  _frame = 0;
+  return RATE_GROUP_OK;
+}
+
+/**
+ * @brief Get the minor frame, the shortest period of the schedule.
+ * @return uint32_t Milliseconds, 0 before a schedule is configured.
+ */
+uint32_t RateGroupScheduler::minorFrame() const {
+  return _minorMs;
+}
+
+/**
+ * @brief Get the major frame, after which the schedule repeats.
+ * @return uint32_t Milliseconds.
+ */
+uint32_t RateGroupScheduler::majorFrame() const {
+  return _minorMs * _frameCount;
+}
+
+/**
+ * @brief Get the estimated bus time of the busiest minor frame.
+ * @return uint32_t Microseconds.
+ */
+uint32_t RateGroupScheduler::worstFrameMicros() const {
+  return _worstUs;
+}
+
+/**
+ * @brief Get the estimated worst-case bus utilisation of the schedule.
+ * @return uint8_t Percent of a minor frame taken by the busiest one.
+ */
+uint8_t RateGroupScheduler::utilisation() const {
+  return _minorMs ? (_worstUs + _minorMs * 10 - 1) / (_minorMs * 10) : 0;
+}
+
+/**
+ * @brief Estimate the bus time of one word read with the current settings.
+ * The read is one combined transaction of 48 bits, 57 with PEC, with the turnaround before
+ * the repeated START. Where the core defers the command to the read and a turnaround is
+ * needed, the command and the read are separate transactions of 49 bits, 58 with PEC. The
+ * driver overhead is added for each transaction.
+ * @return uint32_t Microseconds.
+ */
+uint32_t RateGroupScheduler::readCost() const {
+  uint32_t turnaround = _turnaroundBound != RATE_GROUP_TURNAROUND_AUTO ? _turnaroundBound
+                        : _battery.adaptiveTurnaround()               ? SMBUS_TURNAROUND_MAX_US
+                                                                      : _battery.turnaround();
+  bool split = turnaround && _battery.deferredRepeatedStart();
+  uint8_t transactions = split ? 2 : 1;
+  uint32_t bits = (split ? 49 : 48) + (_battery.pecEnabled() ? 9 : 0);
+  return (bits * 1000000UL + _busHz - 1) / _busHz + transactions * _overheadUs + turnaround;
+}
+
+/**
+ * @brief Run the current minor frame if it is due. Call as often as possible.
+ * A frame that starts more than a whole minor frame late counts as an overrun, and the
+ * schedule restarts its timing from now rather than running the missed frames back to back.
+ * @return int8_t Number of registers read, or -1 if no frame was due.
+ */
+int8_t RateGroupScheduler::service() {
+  if (_count == 0) {
+    return -1;
+  }
+  unsigned long now = millis();
+  if (!_started) {
+    _started = true;
+    _frameStart = now;
+  } else if (now - _frameStart < _minorMs) {
+    return -1;
+  } else {
+    _frameStart += _minorMs;
+    if (now - _frameStart >= _minorMs) {
+      _overruns++;
+      _frameStart = now;
+    }
+    _frame = _frame + 1 < _frameCount ? _frame + 1 : 0;
+  }
+
+  unsigned long start = micros();
+  int8_t reads = 0;
+  for (uint8_t i = 0; i < _count; i++) {
+    if (_frame % _slots[i].every != _slots[i].offset) {
+      continue;
+    }
+    SMBusResult result = _battery.readWord(_slots[i].reg);
+    reads++;
+    if (_callback != nullptr) {
+      _callback(_slots[i].reg, result.value, result.ok(), _context);
+    }
+  }
+  uint32_t elapsed = micros() - start;
+  if (elapsed > _longestUs) {
+    _longestUs = elapsed;
+  }
+  _frames++;
+  return reads;
+}
+
+/**
+ * @brief Get the index of the minor frame last run within the major frame.
+ * @return uint16_t
+ */
+uint16_t RateGroupScheduler::frame() const {
+  return _frame;
+}
+
+/**
+ * @brief Get the number of minor frames run.
+ * @return uint32_t
+ */
+uint32_t RateGroupScheduler::frames() const {
+  return _frames;
+}
+
+/**
+ * @brief Get the number of times the schedule fell a whole minor frame behind.
+ * @return uint32_t
+ */
+uint32_t RateGroupScheduler::overruns() const {
+  return _overruns;
+}
+
+/**
+ * @brief Get the longest measured time of a frame's reads.
+ * @return uint32_t Microseconds.
+ */
+uint32_t RateGroupScheduler::longestFrameMicros() const {
+  return _longestUs;
+}
+
+/**
+ * @brief Estimated bus time of a frame.
+ * @param slots
+ * @param count Number of slots placed so far.
+ * @param frame
+ * @return uint32_t Microseconds.
+ */
+uint32_t RateGroupScheduler::frameLoad(const Slot* slots, uint8_t count, uint16_t frame) {
+  uint32_t load = 0;
+  for (uint8_t i = 0; i < count; i++) {
+    if (frame % slots[i].every == slots[i].offset) {
+      load += slots[i].costUs;
+    }
+  }
+  return load;
+}
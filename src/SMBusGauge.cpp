@@ -0,0 +1,409 @@
+/**
+ * @file SMBusGauge.cpp
+ * @brief Vendor extensions for gauges that expose more than the Smart Battery Data Specification.
+ * @version 1.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "SMBusGauge.h"
+
+#include <string.h>
+
+static const GaugeFamily* const gaugeFamilies[] = {&GAUGE_TI_BQ40Z50, &GAUGE_TI_BQ4050};
+
+/**
+ * @brief Decode little-endian words into a struct made only of 16-bit fields.
+ * @param data Bytes as received.
+ * @param target
+ * @param words Number of fields in target.
+ */
+static void decodeWords(const uint8_t* data, void* target, uint8_t words) {
+  uint16_t* fields = static_cast<uint16_t*>(target);
+  for (uint8_t i = 0; i < words; i++) {
+    fields[i] = data[2 * i] | (data[2 * i + 1] << 8);
+  }
+}
+
+/**
+ * @brief Get the spread between the highest and lowest cell voltage.
+ * @param cells Number of cells to compare, from cell 1.
+ * @return uint16_t mV
+ */
+uint16_t GaugeCellStatus::imbalance(uint8_t cells) const {
+  uint16_t lowest = 0xffff;
+  uint16_t highest = 0;
+  for (uint8_t i = 0; i < cells && i < GAUGE_MAX_CELLS; i++) {
+    lowest = cell_voltage[i] < lowest ? cell_voltage[i] : lowest;
+    highest = cell_voltage[i] > highest ? cell_voltage[i] : highest;
+  }
+  return highest > lowest ? highest - lowest : 0;
+}
+
+/**
+ * @brief Construct a gauge extension for a battery.
+ * @param battery Battery to read through; it must outlive the gauge.
+ * @param family How the gauge exposes its blocks, e.g. from findFamily().
+ */
+SMBusGauge::SMBusGauge(ArduinoSMBus& battery, const GaugeFamily& family)
+    : _battery(battery), _family(&family), _aliases(family.aliasFirst != 0), _pagesWritten(0) {
+}
+
+const GaugeFamily& SMBusGauge::family() const {
+  return *_family;
+}
+
+/**
+ * @brief Check if status blocks are read directly as SBS commands.
+ * @return bool False once a sealed gauge has NACKed them.
+ */
+bool SMBusGauge::aliases() const {
+  return _aliases;
+}
+
+/**
+ * @brief Choose whether status blocks are read directly as SBS commands, e.g. after unsealing.
+ * @param enable Ignored if the family has no aliases.
+ */
+void SMBusGauge::useAliases(bool enable) {
+  _aliases = enable && _family->aliasFirst != 0;
+}
+
+/**
+ * @brief Send a MAC subcommand that returns no data, such as a FET or gauging toggle.
+ * @param subcommand
+ * @return SMBusStatus
+ */
+SMBusStatus SMBusGauge::macCommand(uint16_t subcommand) {
+  uint8_t request[2] = {(uint8_t)(subcommand & 0xff), (uint8_t)(subcommand >> 8)};
+  return _battery.writeBlock(MANUFACTURER_BLOCK_ACCESS, request, sizeof(request));
+}
+
+/**
+ * @brief Run a MAC subcommand and read its result through ManufacturerBlockAccess().
+ * The gauge echoes the subcommand before the result, and a different echo means another
+ * master ran a MAC in between. Results of up to 32 bytes come back in one block with the
+ * echo, whatever their size; a result longer than data is truncated to it. With PEC the
+ * whole block is clocked to check it, otherwise only the echo and what fits in data.
+ * @param subcommand
+ * @param data Buffer for the result.
+ * @param length Size of data.
+ * @return SMBusResult Number of result bytes stored. SMBUS_VERIFY_ERROR if the echo does not match.
+ */
+SMBusResult SMBusGauge::macRead(uint16_t subcommand, uint8_t* data, uint8_t length) {
+  SMBusResult result = {macCommand(subcommand), 0};
+  if (!result.ok()) {
+    return result;
+  }
+
+  uint8_t block[SMBUS_BLOCK_MAX + 2];
+  uint8_t size = _battery.pecEnabled() || length > SMBUS_BLOCK_MAX ? sizeof(block) : length + 2;
+  result = _battery.readBlock(MANUFACTURER_BLOCK_ACCESS, block, size);
+  if (!result.ok()) {
+    return result;
+  }
+  if (result.value < 2 || (block[0] | (block[1] << 8)) != subcommand) {
+    return {result.value < 2 ? SMBUS_SHORT_READ : SMBUS_VERIFY_ERROR, 0};
+  }
+  result.value = result.value - 2 < length ? result.value - 2 : length;
+  memcpy(data, block + 2, result.value);
+  return result;
+}
+
+/**
+ * @brief Read a status register of up to 32 flags, such as TI_MAC_SAFETY_STATUS.
+ * @param subcommand
+ * @param flags Set to the flags, 0 if the read fails.
+ * @return SMBusStatus
+ */
+SMBusStatus SMBusGauge::readFlags(uint16_t subcommand, uint32_t& flags) {
+  uint8_t data[4];
+  SMBusResult result = read(subcommand, data, sizeof(data));
+  flags = 0;
+  for (uint8_t i = 0; result.ok() && i < result.value; i++) {
+    flags |= (uint32_t)data[i] << (8 * i);
+  }
+  return result.status;
+}
+
+/**
+ * @brief Read all cell voltages, currents and powers in one block.
+ * A family without a cell status block gets only the cell voltages.
+ * @param status Zeroed if the read fails.
+ * @return SMBusStatus SMBUS_SHORT_READ if the gauge returned less than a whole block.
+ */
+SMBusStatus SMBusGauge::readCellStatus(GaugeCellStatus& status) {
+  status = GaugeCellStatus();
+  if (_family->cellStatus == 0) {
+    return readCellVoltages(status.cell_voltage);
+  }
+
+  uint8_t data[sizeof(GaugeCellStatus)];
+  SMBusResult result = read(_family->cellStatus, data, sizeof(data));
+  if (result.ok() && result.value < sizeof(data)) {
+    result.status = SMBUS_SHORT_READ;
+  }
+  if (result.ok()) {
+    decodeWords(data, &status, sizeof(GaugeCellStatus) / 2);
+  }
+  return result.status;
+}
+
+/**
+ * @brief Read only the cell voltages.
+ * Without PEC, only the start of the cell status block is clocked, so this is one short
+ * block read. With PEC the whole block must be read to check it, and a family without a
+ * cell status block needs one word read per cell.
+ * @param voltages GAUGE_MAX_CELLS entries in mV, cell 1 first. Cells the family does not have are 0.
+ * @return SMBusStatus
+ */
+SMBusStatus SMBusGauge::readCellVoltages(uint16_t* voltages) {
+  memset(voltages, 0, GAUGE_MAX_CELLS * sizeof(uint16_t));
+  if (_family->cellStatus != 0) {
+    uint8_t data[2 * GAUGE_MAX_CELLS];
+    SMBusResult result = read(_family->cellStatus, data, 2 * _family->cells);
+    if (result.ok() && result.value < 2 * _family->cells) {
+      result.status = SMBUS_SHORT_READ;
+    }
+    if (result.ok()) {
+      decodeWords(data, voltages, _family->cells);
+    }
+    return result.status;
+  }
+
+  SMBusStatus status = _family->cellVoltage == 0 ? SMBUS_NACK_DATA : SMBUS_OK;
+  for (uint8_t i = 0; i < _family->cells && _family->cellVoltage != 0; i++) {
+    SMBusResult result = _battery.readWord(_family->cellVoltage + i * _family->cellVoltageStep);
+    voltages[i] = result.value;
+    if (status == SMBUS_OK) {
+      status = result.status;
+    }
+  }
+  return status;
+}
+
+/**
+ * @brief Read every temperature sensor in one block.
+ * @param temperatures Zeroed if the read fails.
+ * @return SMBusStatus SMBUS_NACK_DATA if the family has no temperature block.
+ */
+SMBusStatus SMBusGauge::readTemperatures(GaugeTemperatures& temperatures) {
+  temperatures = GaugeTemperatures();
+  if (_family->temperatures == 0) {
+    return SMBUS_NACK_DATA;
+  }
+
+  uint8_t data[sizeof(GaugeTemperatures)];
+  SMBusResult result = read(_family->temperatures, data, sizeof(data));
+  if (result.ok() && result.value < sizeof(data)) {
+    result.status = SMBUS_SHORT_READ;
+  }
+  if (result.ok()) {
+    decodeWords(data, &temperatures, sizeof(GaugeTemperatures) / 2);
+  }
+  return result.status;
+}
+
+/**
+ * @brief Read a range of data flash, pipelining the pages.
+ * The address is written once and the pages are then read back to back with no delay, the
+ * gauge advancing its address after each.
+ * @param address Data flash address, e.g. 0x4000. Need not be page aligned.
+ * @param data Buffer for the contents.
+ * @param length Bytes to read.
+ * @return SMBusStatus SMBUS_NACK_DATA if the range is outside the family's data flash.
+ */
+SMBusStatus SMBusGauge::readDataFlash(uint16_t address, uint8_t* data, uint16_t length) {
+  if (!inDataFlash(address, length)) {
+    return SMBUS_NACK_DATA;
+  }
+  bool addressed = false;
+  for (uint16_t offset = 0; offset < length; offset += GAUGE_DF_PAGE) {
+    uint8_t count = length - offset < GAUGE_DF_PAGE ? length - offset : GAUGE_DF_PAGE;
+    SMBusStatus status = readDataFlashPage(address + offset, data + offset, count, addressed);
+    if (status != SMBUS_OK) {
+      return status;
+    }
+  }
+  return SMBUS_OK;
+}
+
+/**
+ * @brief Write a range of data flash, rewriting only what changed.
+ * The range is compared page by page with its current contents, which are read in the
+ * same pipelined pass unless given. In each page that differs, the span from the first to
+ * the last changed byte is written, in pieces of GAUGE_DF_WRITE_MAX bytes, and the page is
+ * read back to verify it. The verifying read leaves the gauge addressed at the next page,
+ * so the pass carries on without another address write.
+ * @param address Data flash address.
+ * @param data New contents.
+ * @param length Bytes in data.
+ * @param current Contents the gauge holds now, such as an earlier backup, or nullptr to read them.
+ * @return SMBusStatus SMBUS_VERIFY_ERROR if a page read back differently.
+ */
+SMBusStatus SMBusGauge::writeDataFlash(uint16_t address, const uint8_t* data, uint16_t length,
+                                       const uint8_t* current) {
+  _pagesWritten = 0;
+  if (!inDataFlash(address, length)) {
+    return SMBUS_NACK_DATA;
+  }
+
+  uint8_t page[GAUGE_DF_PAGE];
+  bool addressed = false;
+  for (uint16_t offset = 0; offset < length; offset += GAUGE_DF_PAGE) {
+    uint8_t count = length - offset < GAUGE_DF_PAGE ? length - offset : GAUGE_DF_PAGE;
+    const uint8_t* old = current != nullptr ? current + offset : page;
+    if (current == nullptr) {
+      SMBusStatus status = readDataFlashPage(address + offset, page, count, addressed);
+      if (status != SMBUS_OK) {
+        return status;
+      }
+    }
+
+    uint8_t first = 0;
+    uint8_t last = count;
+    while (first < count && old[first] == data[offset + first]) {
+      first++;
+    }
+    while (last > first && old[last - 1] == data[offset + last - 1]) {
+      last--;
+    }
+    if (first == last) {
+      continue;
+    }
+
+    addressed = false;
+    SMBusStatus status = writeDataFlashSpan(address + offset + first, data + offset + first, last - first);
+    if (status == SMBUS_OK) {
+      status = readDataFlashPage(address + offset, page, count, addressed);
+    }
+    if (status == SMBUS_OK && memcmp(page, data + offset, count) != 0) {
+      status = SMBUS_VERIFY_ERROR;
+    }
+    if (status != SMBUS_OK) {
+      return status;
+    }
+    _pagesWritten++;
+  }
+  return SMBUS_OK;
+}
+
+/**
+ * @brief Get the number of pages the last writeDataFlash() rewrote.
+ * @return uint16_t
+ */
+uint16_t SMBusGauge::pagesWritten() const {
+  return _pagesWritten;
+}
+
+/**
+ * @brief Find the family of a gauge from its DeviceName().
+ * @param deviceName
+ * @return const GaugeFamily* nullptr if the gauge is not a known family.
+ */
+const GaugeFamily* SMBusGauge::findFamily(const char* deviceName) {
+  for (const GaugeFamily* family : gaugeFamilies) {
+    if (deviceName != nullptr && strncmp(deviceName, family->name, strlen(family->name)) == 0) {
+      return family;
+    }
+  }
+  return nullptr;
+}
+
+/**
+ * @brief Read the result of a MAC subcommand, in one transaction where the gauge allows it.
+ * When an alias read fails and the gauge turns out to be sealed, ManufacturerBlockAccess is
+ * used from then on. Other failures are returned as they are.
+ * @param subcommand
+ * @param data
+ * @param length
+ * @return SMBusResult
+ */
+SMBusResult SMBusGauge::read(uint16_t subcommand, uint8_t* data, uint8_t length) {
+  if (_aliases && subcommand >= _family->aliasFirst && subcommand <= _family->aliasLast) {
+    SMBusResult result = _battery.readBlock((uint8_t)subcommand, data, length);
+    if (result.ok() || !sealed()) {
+      return result;
+    }
+    _aliases = false;
+  }
+  return macRead(subcommand, data, length);
+}
+
+/**
+ * @brief Check the security mode in OperationStatus, read through ManufacturerBlockAccess.
+ * @return bool True if the gauge says it is sealed, false if it is not or could not be read.
+ */
+bool SMBusGauge::sealed() {
+  uint8_t data[2];
+  SMBusResult result = macRead(TI_MAC_OPERATION_STATUS, data, sizeof(data));
+  return result.ok() && result.value == sizeof(data) &&
+         ((data[0] | (data[1] << 8)) & TI_OPERATION_STATUS_SEC) == TI_OPERATION_STATUS_SEC;
+}
+
+/**
+ * @brief Check if a range lies within the family's data flash.
+ * @param address
+ * @param length
+ * @return bool
+ */
+bool SMBusGauge::inDataFlash(uint16_t address, uint16_t length) const {
+  uint32_t end = (uint32_t)_family->dataFlash + _family->dataFlashSize;
+  return _family->dataFlashSize != 0 && address >= _family->dataFlash && (uint32_t)address + length <= end;
+}
+
+/**
+ * @brief Write consecutive data flash bytes, GAUGE_DF_WRITE_MAX at a time.
+ * Each write is a Write Block of ManufacturerBlockAccess() holding the address and the data.
+ * @param address
+ * @param data
+ * @param length
+ * @return SMBusStatus
+ */
+SMBusStatus SMBusGauge::writeDataFlashSpan(uint16_t address, const uint8_t* data, uint8_t length) {
+  uint8_t block[2 + GAUGE_DF_WRITE_MAX];
+  for (uint8_t offset = 0; offset < length; offset += GAUGE_DF_WRITE_MAX) {
+    uint8_t count = length - offset < GAUGE_DF_WRITE_MAX ? length - offset : GAUGE_DF_WRITE_MAX;
+    block[0] = (address + offset) & 0xff;
+    block[1] = (address + offset) >> 8;
+    memcpy(block + 2, data + offset, count);
+    SMBusStatus status = _battery.writeBlock(MANUFACTURER_BLOCK_ACCESS, block, 2 + count);
+    if (status != SMBUS_OK) {
+      return status;
+    }
+  }
+  return SMBUS_OK;
+}
+
+/**
+ * @brief Read the next data flash page.
+ * Every page echoes its address. A page that fails or comes back from the wrong address is
+ * re-addressed and read once more.
+ * @param address Address the page should start at.
+ * @param data Buffer for the page.
+ * @param length Bytes of the page to store, at most GAUGE_DF_PAGE.
+ * @param addressed True if the gauge already points at address; updated for the next page.
+ * @return SMBusStatus
+ */
+SMBusStatus SMBusGauge::readDataFlashPage(uint16_t address, uint8_t* data, uint8_t length, bool& addressed) {
+  uint8_t page[2 + GAUGE_DF_PAGE];
+  SMBusResult result = {SMBUS_OK, 0};
+  for (uint8_t attempt = 0; attempt < 2; attempt++) {
+    result.status = addressed && attempt == 0 ? SMBUS_OK : macCommand(address);
+    if (result.ok()) {
+      result = _battery.readBlock(MANUFACTURER_BLOCK_ACCESS, page, sizeof(page));
+    }
+    if (result.ok() && (result.value < 2 + length || (page[0] | (page[1] << 8)) != address)) {
+      result.status = result.value < 2 + length ? SMBUS_SHORT_READ : SMBUS_VERIFY_ERROR;
+    }
+    if (result.ok()) {
+      memcpy(data, page + 2, length);
+      addressed = true;
+      return SMBUS_OK;
+    }
+  }
+  addressed = false;
+  return result.status;
+}
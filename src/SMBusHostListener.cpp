@@ -0,0 +1,181 @@
+/**
+ * @file SMBusHostListener.cpp
+ * @brief Receives AlarmWarning and charger broadcasts sent by smart batteries.
+ * @version 1.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "SMBusHostListener.h"
+
+SMBusHostListener* SMBusHostListener::_active = nullptr;
+
+/**
+ * @brief Construct a listener.
+ * @param wire Controller to listen on. Must not be the one used by ArduinoSMBus on ESP32.
+ */
+SMBusHostListener::SMBusHostListener(TwoWire& wire)
+    : _wire(wire), _address(SMBUS_HOST_ADDRESS), _pecEnabled(false), _alarmCallback(nullptr),
+      _alarmContext(nullptr), _chargerCallback(nullptr), _chargerContext(nullptr), _head(0), _tail(0),
+      _received(0), _dropped(0), _pecErrors(0) {
+}
+
+SMBusHostListener::~SMBusHostListener() {
+  end();
+}
+
+/**
+ * @brief Start listening.
+ * @param address 7-bit address to receive at, SMBUS_HOST_ADDRESS or SMBUS_CHARGER_ADDRESS.
+ * @return bool False if another listener is active.
+ */
+bool SMBusHostListener::begin(uint8_t address) {
+  if (_active != nullptr && _active != this) {
+    return false;
+  }
+  _address = address;
+  _head = 0;
+  _tail = 0;
+  _active = this;
+  _wire.begin(address);
+  _wire.onReceive(receiveEvent);
+  return true;
+}
+
+/**
+ * @brief Stop listening. Messages already queued can still be taken with poll().
+ */
+void SMBusHostListener::end() {
+  if (_active == this) {
+    _wire.onReceive(nullptr);
+    _wire.end();
+    _active = nullptr;
+  }
+}
+
+/**
+ * @brief Set the callback for AlarmWarning messages.
+ * @param callback
+ * @param context Passed to the callback.
+ */
+void SMBusHostListener::onAlarm(SMBusAlarmCallback callback, void* context) {
+  _alarmCallback = callback;
+  _alarmContext = context;
+}
+
+/**
+ * @brief Set the callback for ChargingCurrent and ChargingVoltage broadcasts.
+ * @param callback
+ * @param context Passed to the callback.
+ */
+void SMBusHostListener::onCharger(SMBusChargerCallback callback, void* context) {
+  _chargerCallback = callback;
+  _chargerContext = context;
+}
+
+/**
+ * @brief Require a PEC on every message.
+ * Without it, messages without a PEC are accepted too; a PEC that is sent is always checked.
+ * @param enable
+ */
+void SMBusHostListener::enablePEC(bool enable) {
+  _pecEnabled = enable;
+}
+
+/**
+ * @brief Run the callbacks for the messages received since the last call.
+ * @return uint8_t Number of messages handled.
+ */
+uint8_t SMBusHostListener::poll() {
+  uint8_t handled = 0;
+  while (_tail != _head) {
+    Message message = _queue[_tail];
+    _tail = (_tail + 1) & (SMBUS_LISTENER_QUEUE_SIZE - 1);
+    handled++;
+
+    if (message.command == CHARGING_CURRENT || message.command == CHARGING_VOLTAGE) {
+      if (_chargerCallback != nullptr) {
+        _chargerCallback(message.command, message.value, _chargerContext);
+      }
+    } else if (_alarmCallback != nullptr) {
+      // AlarmWarning carries the sender's write address as its command code
+      _alarmCallback(message.command >> 1, BatteryStatus(message.value), _alarmContext);
+    }
+  }
+  return handled;
+}
+
+/**
+ * @brief Get the number of messages waiting for poll().
+ * @return uint8_t
+ */
+uint8_t SMBusHostListener::pending() const {
+  return (_head - _tail) & (SMBUS_LISTENER_QUEUE_SIZE - 1);
+}
+
+/**
+ * @brief Get the number of valid messages received.
+ * @return uint32_t
+ */
+uint32_t SMBusHostListener::received() const {
+  return _received;
+}
+
+/**
+ * @brief Get the number of messages lost because the queue was full.
+ * @return uint32_t
+ */
+uint32_t SMBusHostListener::dropped() const {
+  return _dropped;
+}
+
+/**
+ * @brief Get the number of messages discarded for a missing or wrong PEC, or a bad length.
+ * @return uint32_t
+ */
+uint32_t SMBusHostListener::pecErrors() const {
+  return _pecErrors;
+}
+
+void SMBusHostListener::receiveEvent(int length) {
+  (void)length;
+  if (_active != nullptr) {
+    _active->receive();
+  }
+}
+
+/**
+ * @brief Parse one Write Word message and queue it. Runs in the Wire receive handler.
+ */
+void SMBusHostListener::receive() {
+  uint8_t bytes[4];
+  uint8_t count = 0;
+  while (_wire.available()) {
+    int value = _wire.read();
+    if (count < sizeof(bytes)) {
+      bytes[count] = (uint8_t)value;
+    }
+    if (count <= sizeof(bytes)) {
+      count++; // Stops one past the longest valid message
+    }
+  }
+
+  if (count < 3 || count > 4 || (_pecEnabled && count != 4) ||
+      (count == 4 && smbusPec(bytes, 4, smbusPecByte(0, _address << 1)) != 0)) {
+    _pecErrors++;
+    return;
+  }
+
+  // The queue holds one slot free to tell full from empty
+  uint8_t next = (_head + 1) & (SMBUS_LISTENER_QUEUE_SIZE - 1);
+  if (next == _tail) {
+    _dropped++;
+    return;
+  }
+  _queue[_head].command = bytes[0];
+  _queue[_head].value = bytes[1] | (bytes[2] << 8);
+  _head = next;
+  _received++;
+}
@@ -0,0 +1,68 @@
+/**
+ * @file SMBusPEC.cpp
+ * @brief SMBus Packet Error Code (CRC-8, polynomial x^8 + x^2 + x + 1).
+ * @version 1.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "SMBusPEC.h"
+
+#define SMBUS_PEC_4(n) smbusPecEntry(n), smbusPecEntry(n + 1), smbusPecEntry(n + 2), smbusPecEntry(n + 3)
+#define SMBUS_PEC_16(n) SMBUS_PEC_4(n), SMBUS_PEC_4(n + 4), SMBUS_PEC_4(n + 8), SMBUS_PEC_4(n + 12)
+#define SMBUS_PEC_64(n) SMBUS_PEC_16(n), SMBUS_PEC_16(n + 16), SMBUS_PEC_16(n + 32), SMBUS_PEC_16(n + 48)
+
+/**
+ * @brief PEC of every byte value, evaluated by the compiler and placed in flash.
+ */
+static const uint8_t pecTable[256] PROGMEM = {
+  SMBUS_PEC_64(0), SMBUS_PEC_64(64), SMBUS_PEC_64(128), SMBUS_PEC_64(192)
+};
+
+/**
+ * @brief PEC of every high nibble value, the first 16 entries of pecTable.
+ */
+static const uint8_t pecNibbleTable[16] PROGMEM = {
+  SMBUS_PEC_16(0)
+};
+
+static_assert(smbusPecEntry(0x01) == 0x07, "PEC table generator");
+static_assert(smbusPecEntry(0xff) == 0xf3, "PEC table generator");
+
+/**
+ * @brief Add one byte to a running PEC with one lookup in the 256-byte table.
+ * @param crc
+ * @param data
+ * @return uint8_t
+ */
+uint8_t smbusPecByteTable(uint8_t crc, uint8_t data) {
+  return pgm_read_byte(&pecTable[crc ^ data]);
+}
+
+/**
+ * @brief Add one byte to a running PEC with two lookups in the 16-byte table.
+ * @param crc
+ * @param data
+ * @return uint8_t
+ */
+uint8_t smbusPecByteNibble(uint8_t crc, uint8_t data) {
+  crc ^= data;
+  crc = (uint8_t)(crc << 4) ^ pgm_read_byte(&pecNibbleTable[crc >> 4]);
+  return (uint8_t)(crc << 4) ^ pgm_read_byte(&pecNibbleTable[crc >> 4]);
+}
+
+/**
+ * @brief Compute the PEC of a sequence of bytes.
+ * @param data
+ * @param length
+ * @param crc PEC of any preceding bytes, 0 to start a new message.
+ * @return uint8_t
+ */
+uint8_t smbusPec(const uint8_t* data, size_t length, uint8_t crc) {
+  for (size_t i = 0; i < length; i++) {
+    crc = smbusPecByte(crc, data[i]);
+  }
+  return crc;
+}
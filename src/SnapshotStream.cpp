@@ -0,0 +1,241 @@
+/**
+ * @file SnapshotStream.cpp
+ * @brief Compact binary encoding of BatterySnapshot streams, and its decoder.
+ * @version 1.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "SnapshotStream.h"
+
+#include <stddef.h>
+
+// Field n of a record is the snapshot word n places after battery_status, for SNAPSHOT_* bit n
+static_assert(offsetof(BatterySnapshot, max_error) ==
+              offsetof(BatterySnapshot, battery_status) + 2 * (SNAPSHOT_STREAM_FIELDS - 1),
+              "BatterySnapshot word fields must be contiguous and in SNAPSHOT_* bit order");
+static_assert(SNAPSHOT_ALL == (1 << SNAPSHOT_STREAM_FIELDS) - 1, "SNAPSHOT_STREAM_FIELDS must match SNAPSHOT_ALL");
+
+/**
+ * @brief Read a varint.
+ * @param data Advanced past the varint if it was complete.
+ * @param end
+ * @param value
+ * @param maxBytes Longest valid encoding.
+ * @return SnapshotStreamStatus SNAPSHOT_STREAM_OK, SNAPSHOT_STREAM_INCOMPLETE or SNAPSHOT_STREAM_CORRUPT.
+ */
+static SnapshotStreamStatus readVarint(const uint8_t*& data, const uint8_t* end, uint32_t& value, uint8_t maxBytes) {
+  value = 0;
+  for (uint8_t i = 0; i < maxBytes; i++) {
+    if (data + i >= end) {
+      return SNAPSHOT_STREAM_INCOMPLETE;
+    }
+    uint8_t byte = data[i];
+    value |= (uint32_t)(byte & 0x7f) << (7 * i);
+    if (!(byte & 0x80)) {
+      data += i + 1;
+      return SNAPSHOT_STREAM_OK;
+    }
+  }
+  return SNAPSHOT_STREAM_CORRUPT;
+}
+
+/**
+ * @brief Construct an encoder. The first record written is a keyframe.
+ * @param out Where to write the records, e.g. Serial or a network client.
+ * @param keyframeInterval Records from one keyframe to the next; 1 makes every record a keyframe.
+ */
+SnapshotEncoder::SnapshotEncoder(Print& out, uint16_t keyframeInterval)
+    : _out(out), _keyframeInterval(keyframeInterval), _sinceKeyframe(0), _records(0), _crc(0), _written(0),
+      _timestamp(0) {
+  memset(_values, 0, sizeof(_values));
+}
+
+/**
+ * @brief Write one record holding the valid fields of a snapshot.
+ * @param snapshot
+ * @return size_t Bytes accepted by the Print, at most SNAPSHOT_STREAM_MAX_RECORD.
+ */
+size_t SnapshotEncoder::write(const BatterySnapshot& snapshot) {
+  bool key = _sinceKeyframe == 0;
+  if (key) {
+    _timestamp = 0;
+    memset(_values, 0, sizeof(_values));
+  }
+  if (++_sinceKeyframe >= _keyframeInterval) {
+    _sinceKeyframe = 0;
+  }
+
+  uint16_t mask = snapshot.valid & SNAPSHOT_ALL;
+  _crc = 0;
+  _written = 0;
+  put(SNAPSHOT_STREAM_SYNC);
+  put((SNAPSHOT_STREAM_VERSION << 4) | (key ? SNAPSHOT_STREAM_KEYFRAME : 0));
+  put(mask & 0xff);
+  put(mask >> 8);
+  putVarint(snapshot.timestamp - _timestamp);
+  _timestamp = snapshot.timestamp;
+
+  const uint16_t* values = &snapshot.battery_status;
+  if (mask & SNAPSHOT_BATTERY_STATUS) {
+    // Status bits do not change by small amounts, so they are sent as they are
+    put(values[0] & 0xff);
+    put(values[0] >> 8);
+  }
+  for (uint8_t i = 1; i < SNAPSHOT_STREAM_FIELDS; i++) {
+    if (mask & (1 << i)) {
+      int16_t change = (int16_t)(uint16_t)(values[i] - _values[i]);
+      putVarint((uint16_t)((uint16_t)change << 1) ^ (uint16_t)(change >> 15));
+      _values[i] = values[i];
+    }
+  }
+
+  _written += _out.write(_crc);
+  _records++;
+  return _written;
+}
+
+/**
+ * @brief Make the next record a keyframe, e.g. when a new client connects.
+ */
+void SnapshotEncoder::keyframe() {
+  _sinceKeyframe = 0;
+}
+
+/**
+ * @brief Get the number of records written.
+ * @return uint32_t
+ */
+uint32_t SnapshotEncoder::records() const {
+  return _records;
+}
+
+void SnapshotEncoder::put(uint8_t value) {
+  _crc = smbusPecByte(_crc, value);
+  _written += _out.write(value);
+}
+
+void SnapshotEncoder::putVarint(uint32_t value) {
+  while (value >= 0x80) {
+    put((value & 0x7f) | 0x80);
+    value >>= 7;
+  }
+  put(value);
+}
+
+SnapshotDecoder::SnapshotDecoder() : _decoded(0), _errors(0) {
+  reset();
+}
+
+/**
+ * @brief Decode the next record.
+ * Bytes before the next sync byte are skipped. A record that does not pass its checks is
+ * skipped one byte at a time, so a sync byte inside it can still start the next record.
+ * @param data Start of the bytes received; advanced past whatever was consumed.
+ * @param end End of the bytes received.
+ * @param snapshot Receives the record if the result is SNAPSHOT_STREAM_OK. Fields not in its
+ * valid mask are 0, as is duration.
+ * @return SnapshotStreamStatus
+ */
+SnapshotStreamStatus SnapshotDecoder::decode(const uint8_t*& data, const uint8_t* end, BatterySnapshot& snapshot) {
+  while (data < end && *data != SNAPSHOT_STREAM_SYNC) {
+    data++;
+  }
+  if (end - data < SNAPSHOT_STREAM_HEADER) {
+    return SNAPSHOT_STREAM_INCOMPLETE;
+  }
+
+  const uint8_t* p = data;
+  uint8_t flags = p[1];
+  uint16_t mask = p[2] | (p[3] << 8);
+  SnapshotStreamStatus status = SNAPSHOT_STREAM_CORRUPT;
+  if ((flags >> 4) == SNAPSHOT_STREAM_VERSION && !(flags & 0x0f & ~SNAPSHOT_STREAM_KEYFRAME) &&
+      !(mask & ~SNAPSHOT_ALL)) {
+    bool key = flags & SNAPSHOT_STREAM_KEYFRAME;
+    p += SNAPSHOT_STREAM_HEADER;
+    uint32_t value;
+    status = readVarint(p, end, value, 5);
+    snapshot.timestamp = (key ? 0 : _timestamp) + value;
+
+    uint16_t* values = &snapshot.battery_status;
+    values[0] = 0;
+    if (status == SNAPSHOT_STREAM_OK && (mask & SNAPSHOT_BATTERY_STATUS)) {
+      if (end - p < 2) {
+        status = SNAPSHOT_STREAM_INCOMPLETE;
+      } else {
+        values[0] = p[0] | (p[1] << 8);
+        p += 2;
+      }
+    }
+    for (uint8_t i = 1; i < SNAPSHOT_STREAM_FIELDS; i++) {
+      values[i] = 0;
+      if (status == SNAPSHOT_STREAM_OK && (mask & (1 << i))) {
+        status = readVarint(p, end, value, 3);
+        uint16_t change = (value >> 1) ^ (uint16_t)-(int32_t)(value & 1);
+        values[i] = (key ? 0 : _values[i]) + change;
+      }
+    }
+
+    if (status == SNAPSHOT_STREAM_OK) {
+      if (p >= end) {
+        status = SNAPSHOT_STREAM_INCOMPLETE;
+      } else if (smbusPec(data, p - data) != *p) {
+        status = SNAPSHOT_STREAM_CORRUPT;
+      } else if (!key && !_synced) {
+        data = p + 1;
+        return SNAPSHOT_STREAM_UNSYNCED;
+      } else {
+        data = p + 1;
+        if (key) {
+          memset(_values, 0, sizeof(_values));
+        }
+        for (uint8_t i = 1; i < SNAPSHOT_STREAM_FIELDS; i++) {
+          if (mask & (1 << i)) {
+            _values[i] = values[i];
+          }
+        }
+        _timestamp = snapshot.timestamp;
+        _synced = true;
+        _decoded++;
+        snapshot.valid = mask;
+        snapshot.duration = 0;
+        return SNAPSHOT_STREAM_OK;
+      }
+    }
+  }
+
+  if (status == SNAPSHOT_STREAM_CORRUPT) {
+    data++;
+    _synced = false;
+    _errors++;
+  }
+  return status;
+}
+
+/**
+ * @brief Forget the stream state, e.g. after a reconnect. Delta records are skipped until
+ * the next keyframe.
+ */
+void SnapshotDecoder::reset() {
+  _synced = false;
+  _timestamp = 0;
+  memset(_values, 0, sizeof(_values));
+}
+
+/**
+ * @brief Get the number of records decoded.
+ * @return uint32_t
+ */
+uint32_t SnapshotDecoder::decoded() const {
+  return _decoded;
+}
+
+/**
+ * @brief Get the number of corrupt records skipped.
+ * @return uint32_t
+ */
+uint32_t SnapshotDecoder::errors() const {
+  return _errors;
+}
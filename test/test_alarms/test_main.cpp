@@ -0,0 +1,160 @@
+/**
+ * @file test_main.cpp
+ * @brief AlarmWarning and charger broadcasts received by SMBusHostListener.
+ * @version 1.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ * Run with `pio test -e native`. The simulated pack broadcasts on Wire1, where the listener
+ * is the target.
+ */
+
+#include <Arduino.h>
+#include <Wire.h>
+#include <unity.h>
+#include "ArduinoSMBus.h"
+#include "SMBusHostListener.h"
+#include "SimBattery.h"
+
+#define BATTERY_ADDRESS 0x0B
+
+static SimBattery* sim;
+static ArduinoSMBus* battery;
+static SMBusHostListener* listener;
+
+struct AlarmLog {
+  uint32_t alarms;
+  uint8_t battery;
+  BatteryStatus status;
+  uint16_t chargingCurrent;
+  uint16_t chargingVoltage;
+};
+
+static AlarmLog alarmLog;
+
+static void onAlarm(uint8_t battery, BatteryStatus status, void* context) {
+  AlarmLog* log = static_cast<AlarmLog*>(context);
+  log->alarms++;
+  log->battery = battery;
+  log->status = status;
+}
+
+static void onCharger(uint8_t command, uint16_t value, void* context) {
+  AlarmLog* log = static_cast<AlarmLog*>(context);
+  (command == CHARGING_CURRENT ? log->chargingCurrent : log->chargingVoltage) = value;
+}
+
+void setUp() {
+  SimBus& bus = SimBus::instance();
+  bus.setClock(100000);
+  bus.setTransactionOverheadNanos(50000);
+  bus.clearFaults();
+  bus.resetStats();
+  Wire.setDeferredWrites(false);
+  sim = new SimBattery(BATTERY_ADDRESS);
+  sim->attach();
+  battery = new ArduinoSMBus(BATTERY_ADDRESS);
+  alarmLog = AlarmLog();
+  listener = new SMBusHostListener(Wire1);
+  listener->onAlarm(onAlarm, &alarmLog);
+  listener->onCharger(onCharger, &alarmLog);
+}
+
+void tearDown() {
+  listener->end();
+  delete listener;
+  delete battery;
+  delete sim;
+}
+
+/**
+ * @brief Clear alarm_mode and charger_mode, which enables both kinds of broadcast.
+ */
+static void enableBroadcasts() {
+  sim->setWord(BATTERY_MODE, sim->word(BATTERY_MODE) & ~(BATTERY_MODE_ALARM_MODE | BATTERY_MODE_CHARGER_MODE));
+  TEST_ASSERT_FALSE_MESSAGE(battery->batteryMode().alarmMode(), "alarm broadcasts enabled");
+}
+
+/**
+ * @brief Only one listener can be the target at a time.
+ */
+static void test_single_listener() {
+  TEST_ASSERT_TRUE_MESSAGE(listener->begin(), "listener begin");
+  SMBusHostListener other(Wire);
+  TEST_ASSERT_FALSE_MESSAGE(other.begin(), "only one listener at a time");
+}
+
+/**
+ * @brief AlarmWarning is only sent with alarm_mode cleared, and reaches the callback on poll().
+ */
+static void test_alarm_warning() {
+  listener->begin();
+  TEST_ASSERT_EQUAL_MESSAGE(0, sim->raiseAlarm(BATTERY_STATUS_OVER_TEMP_ALARM), "no AlarmWarning in alarm mode");
+  TEST_ASSERT_EQUAL(0, listener->poll());
+  enableBroadcasts();
+
+  TEST_ASSERT_EQUAL_MESSAGE(1, sim->raiseAlarm(BATTERY_STATUS_OVER_TEMP_ALARM),
+                            "AlarmWarning acknowledged by the host only");
+  TEST_ASSERT_EQUAL_MESSAGE(1, listener->pending(), "AlarmWarning queued until poll");
+  TEST_ASSERT_EQUAL(1, listener->poll());
+  TEST_ASSERT_EQUAL_UINT32(1, alarmLog.alarms);
+  TEST_ASSERT_EQUAL_HEX8(BATTERY_ADDRESS, alarmLog.battery);
+  TEST_ASSERT_TRUE_MESSAGE(alarmLog.status.overTempAlarm() && !alarmLog.status.ok(), "AlarmWarning callback");
+}
+
+/**
+ * @brief At the charger address the charging broadcasts arrive as well.
+ */
+static void test_charger_broadcasts() {
+  enableBroadcasts();
+  TEST_ASSERT_TRUE_MESSAGE(listener->begin(SMBUS_CHARGER_ADDRESS), "listener at charger address");
+  TEST_ASSERT_EQUAL_MESSAGE(2, sim->broadcastChargingValues(), "charger broadcasts");
+  TEST_ASSERT_EQUAL(2, listener->poll());
+  TEST_ASSERT_EQUAL_UINT16_MESSAGE(sim->word(CHARGING_CURRENT), alarmLog.chargingCurrent, "charger callback values");
+  TEST_ASSERT_EQUAL_UINT16_MESSAGE(sim->word(CHARGING_VOLTAGE), alarmLog.chargingVoltage, "charger callback values");
+  TEST_ASSERT_EQUAL(1, sim->raiseAlarm(BATTERY_STATUS_TERM_CHARGE_ALARM));
+  TEST_ASSERT_EQUAL(1, listener->poll());
+  TEST_ASSERT_EQUAL_UINT32(1, alarmLog.alarms);
+  TEST_ASSERT_TRUE_MESSAGE(alarmLog.status.termChargeAlarm(), "AlarmWarning at charger address");
+}
+
+/**
+ * @brief With PEC enabled, messages without it are rejected and counted.
+ */
+static void test_listener_pec() {
+  enableBroadcasts();
+  listener->begin();
+  listener->enablePEC();
+  sim->raiseAlarm(0);
+  TEST_ASSERT_EQUAL_MESSAGE(0, listener->poll(), "message without PEC rejected");
+  TEST_ASSERT_EQUAL_UINT32(1, listener->pecErrors());
+  sim->setPEC(true);
+  sim->raiseAlarm(0);
+  TEST_ASSERT_EQUAL_MESSAGE(1, listener->poll(), "message with PEC accepted");
+  TEST_ASSERT_EQUAL_UINT32(1, listener->pecErrors());
+}
+
+/**
+ * @brief Messages that do not fit the queue are dropped and counted.
+ */
+static void test_queue_overflow() {
+  enableBroadcasts();
+  listener->begin();
+  for (int i = 0; i < SMBUS_LISTENER_QUEUE_SIZE + 2; i++) {
+    sim->raiseAlarm(0);
+  }
+  TEST_ASSERT_EQUAL_MESSAGE(SMBUS_LISTENER_QUEUE_SIZE - 1, listener->poll(), "queue overflow counted");
+  TEST_ASSERT_EQUAL_UINT32(3, listener->dropped());
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(SMBUS_LISTENER_QUEUE_SIZE - 1, listener->received(), "received count");
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_single_listener);
+  RUN_TEST(test_alarm_warning);
+  RUN_TEST(test_charger_broadcasts);
+  RUN_TEST(test_listener_pec);
+  RUN_TEST(test_queue_overflow);
+  return UNITY_END();
+}
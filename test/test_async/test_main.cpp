@@ -0,0 +1,319 @@
+/**
+ * @file test_main.cpp
+ * @brief Snapshots, the register cache, non-blocking reads and snapshot publication.
+ * @version 1.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ * Run with `pio test -e native`. Every test starts from a freshly attached simulated battery.
+ */
+
+#include <string.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <Arduino.h>
+#include <Wire.h>
+#include <unity.h>
+#include "ArduinoSMBus.h"
+#include "BatteryPoller.h"
+#include "SimBattery.h"
+
+#define BATTERY_ADDRESS 0x0B
+
+static SimBattery* sim;
+static ArduinoSMBus* battery;
+
+void setUp() {
+  SimBus& bus = SimBus::instance();
+  bus.setClock(100000);
+  bus.setTransactionOverheadNanos(50000);
+  bus.clearFaults();
+  bus.resetStats();
+  Wire.setDeferredWrites(false);
+  sim = new SimBattery(BATTERY_ADDRESS);
+  sim->attach();
+  battery = new ArduinoSMBus(BATTERY_ADDRESS);
+}
+
+void tearDown() {
+  delete battery;
+  delete sim;
+}
+
+struct AsyncResult {
+  uint32_t completed;
+  uint32_t failed;
+  uint16_t lastValue;
+};
+
+static void onAsyncRead(uint8_t reg, uint16_t value, bool ok, void* context) {
+  (void)reg;
+  AsyncResult* result = static_cast<AsyncResult*>(context);
+  result->completed++;
+  result->failed += ok ? 0 : 1;
+  result->lastValue = value;
+}
+
+/**
+ * @brief A snapshot reads every requested register and marks exactly those valid.
+ */
+static void test_snapshot() {
+  BatterySnapshot snapshot;
+  sim->setTurnaroundMicros(300);
+  TEST_ASSERT_TRUE(battery->readSnapshot(snapshot));
+  TEST_ASSERT_EQUAL_HEX16_MESSAGE(SNAPSHOT_ALL, snapshot.valid, "snapshot valid mask");
+  TEST_ASSERT_EQUAL_UINT16(sim->word(VOLTAGE), snapshot.voltage);
+  TEST_ASSERT_EQUAL_UINT16(sim->word(CURRENT), (uint16_t)snapshot.current);
+  TEST_ASSERT_EQUAL_UINT16(sim->word(BATTERY_STATUS), snapshot.battery_status);
+  TEST_ASSERT_EQUAL_UINT16(sim->word(MAX_ERROR), snapshot.max_error);
+
+  BatterySnapshot partial;
+  memset(&partial, 0, sizeof(partial));
+  TEST_ASSERT_TRUE_MESSAGE(battery->readSnapshot(partial, SNAPSHOT_ESSENTIAL), "readSnapshot essential");
+  TEST_ASSERT_EQUAL_HEX16_MESSAGE(SNAPSHOT_ESSENTIAL, partial.valid, "snapshot partial mask");
+  TEST_ASSERT_EQUAL_UINT16(0, partial.full_capacity);
+
+  sim->detach();
+  TEST_ASSERT_FALSE_MESSAGE(battery->readSnapshot(partial, SNAPSHOT_VOLTAGE), "snapshot with no battery");
+  TEST_ASSERT_EQUAL_HEX16(0, partial.valid);
+}
+
+/**
+ * @brief Static registers are read once with the cache enabled, TTL registers once per
+ * TTL, and snapshots and invalidation refresh them.
+ */
+static void test_cache() {
+  const uint32_t passes = 10;
+  battery->enableCache();
+  for (uint32_t i = 0; i < passes; i++) {
+    battery->designCapacity();
+    battery->designVoltage();
+    battery->serialNumber();
+    battery->manufactureYear();
+    battery->manufacturerName();
+    battery->deviceName();
+    battery->deviceChemistry();
+  }
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(7, battery->cacheMisses(), "cache hit/miss counts");
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(7 * (passes - 1), battery->cacheHits(), "cache hit/miss counts");
+  TEST_ASSERT_EQUAL_STRING_MESSAGE("bq40z50-R2", battery->deviceName(), "cached deviceName");
+
+  battery->setCachePolicy(TEMPERATURE, SMBUS_CACHE_TTL, 1000);
+  uint16_t temperature = battery->temperature();
+  sim->setWord(TEMPERATURE, temperature + 10);
+  TEST_ASSERT_EQUAL_UINT16_MESSAGE(temperature, battery->temperature(), "temperature within TTL");
+  delay(1000);
+  TEST_ASSERT_EQUAL_UINT16_MESSAGE(temperature + 10, battery->temperature(), "temperature after TTL");
+
+  // A snapshot refreshes cached registers it includes
+  sim->setWord(TEMPERATURE, temperature);
+  BatterySnapshot snapshot;
+  battery->readSnapshot(snapshot, SNAPSHOT_TEMPERATURE);
+  TEST_ASSERT_EQUAL_UINT16_MESSAGE(temperature, battery->temperature(), "temperature refreshed by snapshot");
+
+  sim->setString(DEVICE_NAME, "bq40z80");
+  TEST_ASSERT_EQUAL_STRING_MESSAGE("bq40z50-R2", battery->deviceName(), "immutable deviceName");
+  battery->invalidateCache(DEVICE_NAME);
+  TEST_ASSERT_EQUAL_STRING_MESSAGE("bq40z80", battery->deviceName(), "deviceName after invalidate");
+}
+
+/**
+ * @brief Non-blocking reads from a simulated loop() never hold it for the turnaround.
+ */
+static void test_async_reads() {
+  const uint32_t reads = 50;
+  AsyncResult result = {0, 0, 0};
+  char name[21];
+  sim->setTurnaroundMicros(2000);
+
+  uint64_t longestPoll = 0;
+  uint32_t queued = 0;
+  while (result.completed < reads) {
+    if (queued < reads && battery->beginRead(VOLTAGE, onAsyncRead, &result)) {
+      queued++;
+    }
+    uint64_t before = simNanos();
+    battery->poll();
+    uint64_t spent = simNanos() - before;
+    longestPoll = spent > longestPoll ? spent : longestPoll;
+    delayMicroseconds(100);
+  }
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, result.failed, "async word reads");
+  TEST_ASSERT_EQUAL_UINT16(sim->word(VOLTAGE), result.lastValue);
+  TEST_ASSERT_LESS_THAN_MESSAGE(1000000, longestPoll, "poll() never blocks for the turnaround");
+
+  result.completed = 0;
+  TEST_ASSERT_TRUE(battery->beginReadBlock(DEVICE_NAME, reinterpret_cast<uint8_t*>(name), sizeof(name) - 1,
+                                           onAsyncRead, &result));
+  while (battery->poll()) {
+    delayMicroseconds(100);
+  }
+  name[result.lastValue] = '\0';
+  TEST_ASSERT_EQUAL_UINT32(1, result.completed);
+  TEST_ASSERT_EQUAL_STRING_MESSAGE("bq40z50-R2", name, "async block read");
+
+  sim->detach();
+  result.completed = 0;
+  result.failed = 0;
+  battery->beginRead(VOLTAGE, onAsyncRead, &result);
+  while (battery->poll()) {
+  }
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(1, result.completed, "async read with no battery");
+  TEST_ASSERT_EQUAL_UINT32(1, result.failed);
+}
+
+/**
+ * @brief Run status reads every 100 ms behind a low priority name read that is always queued.
+ * @return The worst status read latency in microseconds.
+ */
+static uint32_t runStatusBehindNames(bool urgent) {
+  const uint32_t statusReads = 30;
+  SMBusPriority namePriority = urgent ? SMBUS_PRIORITY_LOW : SMBUS_PRIORITY_NORMAL;
+  SMBusPriority statusPriority = urgent ? SMBUS_PRIORITY_URGENT : SMBUS_PRIORITY_NORMAL;
+  AsyncResult names = {0, 0, 0};
+  AsyncResult status = {0, 0, 0};
+  uint32_t namesQueued = 0;
+  uint32_t statusQueued = 0;
+  char name[21];
+  battery->resetLatency();
+
+  unsigned long next = micros();
+  while (status.completed < statusReads) {
+    if (names.completed == namesQueued &&
+        battery->beginReadBlock(DEVICE_NAME, reinterpret_cast<uint8_t*>(name), sizeof(name) - 1, onAsyncRead, &names,
+                                namePriority)) {
+      namesQueued++;
+    }
+    if (statusQueued < statusReads && (long)(micros() - next) >= 0 &&
+        battery->beginRead(BATTERY_STATUS, onAsyncRead, &status, statusPriority)) {
+      statusQueued++;
+      next += 100000;
+    }
+    battery->poll();
+    delayMicroseconds(100);
+  }
+  while (battery->poll()) {
+    delayMicroseconds(100);
+  }
+  name[names.lastValue] = '\0';
+
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, status.failed, "status reads between names");
+  TEST_ASSERT_EQUAL_UINT16(sim->word(BATTERY_STATUS), status.lastValue);
+  TEST_ASSERT_EQUAL_UINT32(0, names.failed);
+  TEST_ASSERT_EQUAL_STRING_MESSAGE("bq40z50-R2", name, "name reads survive preemption");
+  TEST_ASSERT_GREATER_THAN_MESSAGE(statusReads, names.completed, "name reads still make progress");
+  return battery->worstLatency(statusPriority);
+}
+
+/**
+ * @brief Urgent reads preempt waiting name reads, which bounds their latency; reads at one
+ * priority are never preempted.
+ */
+static void test_priorities() {
+  const uint32_t turnaround = 10000;
+  sim->setTurnaroundMicros(turnaround);
+  battery->setTurnaround(turnaround);
+
+  uint32_t onePriority = runStatusBehindNames(false);
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, battery->preemptions(), "no preemption within one priority");
+  uint32_t urgent = runStatusBehindNames(true);
+  TEST_ASSERT_GREATER_THAN_MESSAGE(0, battery->preemptions(), "urgent reads preempt waiting name reads");
+  // Its own command, turnaround and data, plus one name data phase and the loop's polling
+  TEST_ASSERT_LESS_THAN_MESSAGE(onePriority, urgent, "urgent read latency is bounded");
+  TEST_ASSERT_LESS_THAN_MESSAGE(turnaround + 4000, urgent, "urgent read latency is bounded");
+}
+
+/**
+ * @brief Hammer a SnapshotPublisher with one writer and several readers. Every field of
+ * each published snapshot carries the same counter, so a torn read is detectable.
+ */
+static void test_publisher_never_tears() {
+  const uint32_t publications = 200000;
+  const int readers = 3;
+  SnapshotPublisher<BatterySnapshot> publisher;
+  std::atomic<bool> done(false);
+  std::atomic<uint64_t> torn(0);
+
+  std::vector<std::thread> threads;
+  for (int r = 0; r < readers; r++) {
+    threads.emplace_back([&]() {
+      uint64_t bad = 0;
+      BatterySnapshot snapshot;
+      while (!done.load(std::memory_order_relaxed)) {
+        publisher.read(snapshot);
+        uint16_t tag = snapshot.voltage;
+        const uint16_t* words = &snapshot.battery_status;
+        for (int i = 0; i < 15; i++) {
+          bad += words[i] != tag;
+        }
+        bad += (snapshot.timestamp & 0xffff) != tag;
+      }
+      torn += bad;
+    });
+  }
+
+  BatterySnapshot snapshot;
+  memset(&snapshot, 0, sizeof(snapshot));
+  for (uint32_t n = 1; n <= publications; n++) {
+    uint16_t* words = &snapshot.battery_status;
+    for (int i = 0; i < 15; i++) {
+      words[i] = n & 0xffff;
+    }
+    snapshot.timestamp = n;
+    publisher.publish(snapshot);
+  }
+  done = true;
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  TEST_ASSERT_EQUAL_UINT64_MESSAGE(0, torn.load(), "no torn snapshot reads");
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(publications, publisher.publications(), "publication count");
+}
+
+/**
+ * @brief Run a BatteryPoller thread against the simulated battery while other threads read.
+ */
+static void test_poller() {
+  BatteryPoller poller(*battery, SNAPSHOT_ESSENTIAL);
+  BatterySnapshot snapshot;
+  TEST_ASSERT_FALSE_MESSAGE(poller.latest(snapshot), "nothing published before start");
+  TEST_ASSERT_TRUE_MESSAGE(poller.start(10), "poller start");
+
+  std::atomic<uint64_t> bad(0);
+  std::vector<std::thread> readers;
+  for (int r = 0; r < 2; r++) {
+    readers.emplace_back([&]() {
+      BatterySnapshot seen;
+      while (poller.publications() < 500) {
+        if (poller.latest(seen) && (seen.voltage != 15840 || seen.valid != SNAPSHOT_ESSENTIAL)) {
+          bad++;
+        }
+      }
+    });
+  }
+  for (auto& thread : readers) {
+    thread.join();
+  }
+  poller.stop();
+
+  TEST_ASSERT_FALSE_MESSAGE(poller.running(), "poller stopped");
+  TEST_ASSERT_EQUAL_UINT64_MESSAGE(0, bad.load(), "poller snapshots consistent");
+  TEST_ASSERT_TRUE(poller.latest(snapshot));
+  TEST_ASSERT_EQUAL_INT16_MESSAGE((int16_t)sim->word(CURRENT), snapshot.current, "poller latest snapshot");
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_snapshot);
+  RUN_TEST(test_cache);
+  RUN_TEST(test_async_reads);
+  RUN_TEST(test_priorities);
+  RUN_TEST(test_publisher_never_tears);
+  RUN_TEST(test_poller);
+  return UNITY_END();
+}
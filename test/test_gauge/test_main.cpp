@@ -0,0 +1,262 @@
+/**
+ * @file test_main.cpp
+ * @brief SMBusGauge cell, status and data flash access on a simulated bq40z50.
+ * @version 1.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ * Run with `pio test -e native`. Every test starts from a freshly attached simulated battery.
+ */
+
+#include <string.h>
+
+#include <Arduino.h>
+#include <Wire.h>
+#include <unity.h>
+#include "ArduinoSMBus.h"
+#include "SMBusGauge.h"
+#include "SimBattery.h"
+
+#define BATTERY_ADDRESS 0x0B
+
+static SimBattery* sim;
+static ArduinoSMBus* battery;
+static uint16_t voltages[GAUGE_MAX_CELLS];
+
+void setUp() {
+  SimBus& bus = SimBus::instance();
+  bus.setClock(100000);
+  bus.setTransactionOverheadNanos(50000);
+  bus.clearFaults();
+  bus.resetStats();
+  Wire.setDeferredWrites(false);
+  sim = new SimBattery(BATTERY_ADDRESS);
+  sim->attach();
+  battery = new ArduinoSMBus(BATTERY_ADDRESS);
+  for (uint8_t cell = 0; cell < GAUGE_MAX_CELLS; cell++) {
+    voltages[cell] = sim->word(TI_CELL_VOLTAGE_1 - cell);
+  }
+}
+
+void tearDown() {
+  delete battery;
+  delete sim;
+}
+
+/**
+ * @brief The family is found from DeviceName.
+ */
+static void test_find_family() {
+  const GaugeFamily* family = SMBusGauge::findFamily(battery->deviceName());
+  TEST_ASSERT_NOT_NULL(family);
+  TEST_ASSERT_EQUAL_STRING("bq40z50", family->name);
+  TEST_ASSERT_NULL(SMBusGauge::findFamily("bq27z561"));
+}
+
+/**
+ * @brief Cell voltages come from one block read instead of a word read per cell.
+ */
+static void test_cell_voltages() {
+  SMBusGauge gauge(*battery, GAUGE_TI_BQ40Z50);
+  SimBus& bus = SimBus::instance();
+  bus.resetStats();
+  for (uint8_t cell = 0; cell < GAUGE_MAX_CELLS; cell++) {
+    TEST_ASSERT_EQUAL_UINT16(voltages[cell], battery->readWord(TI_CELL_VOLTAGE_1 - cell).value);
+  }
+  uint32_t wordTransactions = bus.stats().transactions;
+
+  uint16_t blockVoltages[GAUGE_MAX_CELLS];
+  bus.resetStats();
+  TEST_ASSERT_EQUAL(SMBUS_OK, gauge.readCellVoltages(blockVoltages));
+  TEST_ASSERT_EQUAL_MEMORY(voltages, blockVoltages, sizeof(voltages));
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(wordTransactions, bus.stats().transactions * GAUGE_MAX_CELLS,
+                                   "readCellVoltages in one transaction");
+}
+
+/**
+ * @brief DAStatus1 carries voltages, currents and power, and is one transaction.
+ */
+static void test_cell_status() {
+  SMBusGauge gauge(*battery, GAUGE_TI_BQ40Z50);
+  GaugeCellStatus cells;
+  SimBus& bus = SimBus::instance();
+  bus.resetStats();
+  TEST_ASSERT_EQUAL(SMBUS_OK, gauge.readCellStatus(cells));
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(2, bus.stats().transactions, "one block instead of a word read per cell");
+  TEST_ASSERT_EQUAL_MEMORY_MESSAGE(voltages, cells.cell_voltage, sizeof(voltages), "readCellStatus voltages");
+  TEST_ASSERT_EQUAL_UINT16(sim->word(VOLTAGE), cells.bat_voltage);
+  TEST_ASSERT_EQUAL_INT16_MESSAGE((int16_t)sim->word(CURRENT), cells.cell_current[0], "readCellStatus currents and power");
+  TEST_ASSERT_EQUAL_INT16(-1980, cells.power);
+  TEST_ASSERT_EQUAL_INT16(-1897, cells.average_power);
+  TEST_ASSERT_EQUAL_MESSAGE(10, cells.imbalance(), "cell imbalance");
+  TEST_ASSERT_EQUAL(4, cells.imbalance(2));
+}
+
+/**
+ * @brief Temperatures and flag registers.
+ */
+static void test_temperatures_and_flags() {
+  SMBusGauge gauge(*battery, GAUGE_TI_BQ40Z50);
+  GaugeTemperatures temperatures;
+  uint32_t flags = 0;
+  TEST_ASSERT_EQUAL(SMBUS_OK, gauge.readTemperatures(temperatures));
+  TEST_ASSERT_EQUAL_UINT16_MESSAGE(sim->word(TEMPERATURE), temperatures.cell, "readTemperatures");
+  TEST_ASSERT_EQUAL_UINT16(sim->word(TEMPERATURE) + 19, temperatures.fet);
+  sim->setFlags(TI_MAC_SAFETY_STATUS, 0x08000004);
+  TEST_ASSERT_EQUAL(SMBUS_OK, gauge.readFlags(TI_MAC_SAFETY_STATUS, flags));
+  TEST_ASSERT_EQUAL_HEX32_MESSAGE(0x08000004, flags, "readFlags");
+}
+
+/**
+ * @brief A sealed gauge NACKs the aliases, and ManufacturerBlockAccess takes over.
+ */
+static void test_sealed_gauge() {
+  SMBusGauge gauge(*battery, GAUGE_TI_BQ40Z50);
+  GaugeCellStatus cells;
+  uint16_t blockVoltages[GAUGE_MAX_CELLS];
+  uint32_t flags = 0;
+  sim->setFlags(TI_MAC_SAFETY_STATUS, 0x08000004);
+  sim->setSealed(true);
+  TEST_ASSERT_EQUAL(SMBUS_OK, gauge.readFlags(TI_MAC_OPERATION_STATUS, flags));
+  TEST_ASSERT_EQUAL_HEX32_MESSAGE(0x300, flags & 0x300, "readFlags on a sealed gauge");
+  TEST_ASSERT_FALSE(gauge.aliases());
+
+  SimBus& bus = SimBus::instance();
+  bus.resetStats();
+  TEST_ASSERT_EQUAL(SMBUS_OK, gauge.readCellStatus(cells));
+  TEST_ASSERT_EQUAL_MEMORY_MESSAGE(voltages, cells.cell_voltage, sizeof(voltages),
+                                   "readCellStatus through ManufacturerBlockAccess");
+  TEST_ASSERT_EQUAL_INT16(-1980, cells.power);
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(3, bus.stats().transactions, "MAC read is a block write and a block read");
+
+  // DAStatus1 is longer than the cell voltages; the rest is not clocked, nor taken for a slow gauge
+  uint64_t start = simNanos();
+  TEST_ASSERT_EQUAL(SMBUS_OK, gauge.readCellVoltages(blockVoltages));
+  TEST_ASSERT_LESS_THAN_MESSAGE(2000000, simNanos() - start, "readCellVoltages on a sealed gauge");
+  TEST_ASSERT_EQUAL_MEMORY(voltages, blockVoltages, sizeof(voltages));
+  TEST_ASSERT_EQUAL(0, battery->turnaround());
+
+  sim->setPEC(true);
+  battery->enablePEC();
+  TEST_ASSERT_EQUAL(SMBUS_OK, gauge.readFlags(TI_MAC_SAFETY_STATUS, flags));
+  TEST_ASSERT_EQUAL_HEX32_MESSAGE(0x08000004, flags, "MAC read with PEC");
+  TEST_ASSERT_EQUAL(SMBUS_OK, gauge.readCellVoltages(blockVoltages));
+  TEST_ASSERT_EQUAL_MEMORY_MESSAGE(voltages, blockVoltages, sizeof(voltages),
+                                   "readCellVoltages on a sealed gauge with PEC");
+  TEST_ASSERT_EQUAL(0, battery->turnaround());
+}
+
+/**
+ * @brief Where a rejected command is only seen as an empty read, sealing is found from
+ * OperationStatus; a failed alias read on an unsealed gauge keeps the aliases.
+ */
+static void test_sealed_gauge_deferred() {
+  uint16_t blockVoltages[GAUGE_MAX_CELLS];
+  uint32_t flags = 0;
+  sim->setSealed(true);
+  Wire.setDeferredWrites(true);
+  battery->setDeferredRepeatedStart(true);
+  SMBusGauge fresh(*battery, GAUGE_TI_BQ40Z50);
+  TEST_ASSERT_EQUAL(SMBUS_OK, fresh.readCellVoltages(blockVoltages));
+  TEST_ASSERT_EQUAL_MEMORY(voltages, blockVoltages, sizeof(voltages));
+  TEST_ASSERT_FALSE_MESSAGE(fresh.aliases(), "sealed gauge detected with deferred writes");
+  TEST_ASSERT_EQUAL(0, battery->turnaround());
+
+  Wire.setDeferredWrites(false);
+  battery->setDeferredRepeatedStart(false);
+  sim->setSealed(false);
+  fresh.useAliases();
+  SimBus::instance().injectFault(SIM_FAULT_SHORT_READ, SMBUS_DEFAULT_RETRIES + 1);
+  TEST_ASSERT_EQUAL(SMBUS_SHORT_READ, fresh.readFlags(TI_MAC_SAFETY_STATUS, flags));
+  TEST_ASSERT_TRUE_MESSAGE(fresh.aliases(), "failed alias read on an unsealed gauge keeps the aliases");
+}
+
+/**
+ * @brief A family without a cell block falls back to word reads.
+ */
+static void test_family_without_blocks() {
+  GaugeFamily wordsOnly = {"words", 2, TI_CELL_VOLTAGE_1, -1, 0, 0, 0, 0, 0, 0};
+  SMBusGauge plain(*battery, wordsOnly);
+  GaugeCellStatus cells;
+  GaugeTemperatures temperatures;
+  TEST_ASSERT_EQUAL(SMBUS_OK, plain.readCellStatus(cells));
+  TEST_ASSERT_EQUAL_UINT16_MESSAGE(voltages[1], cells.cell_voltage[1], "family without cell block");
+  TEST_ASSERT_EQUAL_UINT16(0, cells.cell_voltage[2]);
+  TEST_ASSERT_FALSE(plain.aliases());
+  TEST_ASSERT_EQUAL_MESSAGE(SMBUS_NACK_DATA, plain.readTemperatures(temperatures), "family without temperature block");
+}
+
+static uint8_t backup[SIM_DATA_FLASH_SIZE];
+static uint8_t config[SIM_DATA_FLASH_SIZE];
+
+/**
+ * @brief A whole backup is one address write, then a read per page; partial and out of
+ * range reads are handled.
+ */
+static void test_read_data_flash() {
+  SMBusGauge gauge(*battery, GAUGE_TI_BQ40Z50);
+  const uint16_t pages = SIM_DATA_FLASH_SIZE / GAUGE_DF_PAGE;
+  SimBus& bus = SimBus::instance();
+  bus.resetStats();
+  TEST_ASSERT_EQUAL(SMBUS_OK, gauge.readDataFlash(SIM_DATA_FLASH, backup, sizeof(backup)));
+  TEST_ASSERT_EQUAL_MEMORY_MESSAGE(sim->dataFlash(), backup, sizeof(backup), "readDataFlash whole backup");
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(1 + 2 * pages, bus.stats().transactions, "one address write, then a read per page");
+
+  uint8_t part[70];
+  TEST_ASSERT_EQUAL(SMBUS_OK, gauge.readDataFlash(SIM_DATA_FLASH + 0x11, part, sizeof(part)));
+  TEST_ASSERT_EQUAL_MEMORY_MESSAGE(sim->dataFlash() + 0x11, part, sizeof(part), "unaligned readDataFlash");
+  TEST_ASSERT_EQUAL_MESSAGE(SMBUS_NACK_DATA, gauge.readDataFlash(SIM_DATA_FLASH + SIM_DATA_FLASH_SIZE - 16, part, 32),
+                            "readDataFlash out of range");
+  TEST_ASSERT_EQUAL(SMBUS_NACK_DATA, gauge.readDataFlash(0x3ff0, part, 32));
+
+  sim->setPEC(true);
+  battery->enablePEC();
+  TEST_ASSERT_EQUAL(SMBUS_OK, gauge.readDataFlash(SIM_DATA_FLASH + 0x100, part, sizeof(part)));
+  TEST_ASSERT_EQUAL_MEMORY_MESSAGE(sim->dataFlash() + 0x100, part, sizeof(part), "readDataFlash with PEC");
+}
+
+/**
+ * @brief Only changed pages are written, read and compared in one pass or against a known image.
+ */
+static void test_write_data_flash() {
+  SMBusGauge gauge(*battery, GAUGE_TI_BQ40Z50);
+  SimBus& bus = SimBus::instance();
+  memcpy(backup, sim->dataFlash(), sizeof(backup));
+  memcpy(config, backup, sizeof(config));
+  config[0x105] ^= 0x01;
+  config[0x107] ^= 0x80;
+  config[0x1f00] ^= 0xff;
+  config[0x1f1f] ^= 0xff;
+  uint32_t writes = sim->dataFlashWrites();
+  TEST_ASSERT_EQUAL(SMBUS_OK, gauge.writeDataFlash(SIM_DATA_FLASH, config, sizeof(config)));
+  TEST_ASSERT_EQUAL_MEMORY_MESSAGE(config, sim->dataFlash(), sizeof(config), "writeDataFlash");
+  TEST_ASSERT_EQUAL_MESSAGE(2, gauge.pagesWritten(), "only changed pages written");
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(3, sim->dataFlashWrites() - writes, "a 32-byte span in two writes");
+
+  // Against a known image nothing needs to be read first
+  memcpy(backup, config, sizeof(backup));
+  config[0x40] ^= 0x10;
+  writes = sim->dataFlashWrites();
+  bus.resetStats();
+  TEST_ASSERT_EQUAL(SMBUS_OK, gauge.writeDataFlash(SIM_DATA_FLASH, config, sizeof(config), backup));
+  TEST_ASSERT_EQUAL_HEX8(config[0x40], sim->dataFlash()[0x40]);
+  TEST_ASSERT_EQUAL_UINT32(1, sim->dataFlashWrites() - writes);
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(1 + 3, bus.stats().transactions, "writeDataFlash against a known image");
+  TEST_ASSERT_EQUAL(SMBUS_OK, gauge.writeDataFlash(SIM_DATA_FLASH, config, sizeof(config), config));
+  TEST_ASSERT_EQUAL_MESSAGE(0, gauge.pagesWritten(), "unchanged image writes nothing");
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_find_family);
+  RUN_TEST(test_cell_voltages);
+  RUN_TEST(test_cell_status);
+  RUN_TEST(test_temperatures_and_flags);
+  RUN_TEST(test_sealed_gauge);
+  RUN_TEST(test_sealed_gauge_deferred);
+  RUN_TEST(test_family_without_blocks);
+  RUN_TEST(test_read_data_flash);
+  RUN_TEST(test_write_data_flash);
+  return UNITY_END();
+}
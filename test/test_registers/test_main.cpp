@@ -0,0 +1,349 @@
+/**
+ * @file test_main.cpp
+ * @brief Register reads and writes, descriptors, bit fields and unit conversions.
+ * @version 1.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ * Run with `pio test -e native`. Every test starts from a freshly attached simulated battery.
+ */
+
+#include <string.h>
+
+#include <type_traits>
+
+#include <Arduino.h>
+#include <Wire.h>
+#include <unity.h>
+#include "ArduinoSMBus.h"
+#include "SimBattery.h"
+
+#define BATTERY_ADDRESS 0x0B
+
+static SimBattery* sim;
+static ArduinoSMBus* battery;
+
+void setUp() {
+  SimBus& bus = SimBus::instance();
+  bus.setClock(100000);
+  bus.setTransactionOverheadNanos(50000);
+  bus.clearFaults();
+  bus.resetStats();
+  Wire.setDeferredWrites(false);
+  sim = new SimBattery(BATTERY_ADDRESS);
+  sim->attach();
+  battery = new ArduinoSMBus(BATTERY_ADDRESS);
+}
+
+void tearDown() {
+  delete battery;
+  delete sim;
+}
+
+/**
+ * @brief Read every register through the public API and compare with the simulated pack.
+ */
+static void test_registers_match_pack() {
+  TEST_ASSERT_EQUAL_UINT16(sim->word(REMAINING_CAPACITY_ALARM), battery->remainingCapacityAlarm());
+  TEST_ASSERT_EQUAL_UINT16(sim->word(REMAINING_TIME_ALARM), battery->remainingTimeAlarm());
+  TEST_ASSERT_EQUAL_UINT16(sim->word(TEMPERATURE), battery->temperature());
+  TEST_ASSERT_EQUAL_UINT16(sim->word(VOLTAGE), battery->voltage());
+  TEST_ASSERT_EQUAL_UINT16(sim->word(CURRENT), battery->current());
+  TEST_ASSERT_EQUAL_UINT16(sim->word(AVERAGE_CURRENT), battery->averageCurrent());
+  TEST_ASSERT_EQUAL_UINT16(sim->word(MAX_ERROR), battery->maxError());
+  TEST_ASSERT_EQUAL_UINT16(sim->word(REL_STATE_OF_CHARGE), battery->relativeStateOfCharge());
+  TEST_ASSERT_EQUAL_UINT16(sim->word(ABS_STATE_OF_CHARGE), battery->absoluteStateOfCharge());
+  TEST_ASSERT_EQUAL_UINT16(sim->word(REM_CAPACITY), battery->remainingCapacity());
+  TEST_ASSERT_EQUAL_UINT16(sim->word(FULL_CAPACITY), battery->fullCapacity());
+  TEST_ASSERT_EQUAL_UINT16(sim->word(RUN_TIME_TO_EMPTY), battery->runTimeToEmpty());
+  TEST_ASSERT_EQUAL_UINT16(sim->word(AVG_TIME_TO_EMPTY), battery->avgTimeToEmpty());
+  TEST_ASSERT_EQUAL_UINT16(sim->word(AVG_TIME_TO_FULL), battery->avgTimeToFull());
+  TEST_ASSERT_EQUAL_UINT16(sim->word(CHARGING_CURRENT), battery->chargingCurrent());
+  TEST_ASSERT_EQUAL_UINT16(sim->word(CHARGING_VOLTAGE), battery->chargingVoltage());
+  TEST_ASSERT_EQUAL_UINT16(sim->word(CYCLE_COUNT), battery->cycleCount());
+  TEST_ASSERT_EQUAL_UINT16(sim->word(DESIGN_CAPACITY), battery->designCapacity());
+  TEST_ASSERT_EQUAL_UINT16(sim->word(DESIGN_VOLTAGE), battery->designVoltage());
+  TEST_ASSERT_EQUAL_UINT16(sim->word(MANUFACTURE_DATE), battery->manufactureDate());
+  TEST_ASSERT_EQUAL_UINT16(sim->word(SERIAL_NUMBER), battery->serialNumber());
+  TEST_ASSERT_EQUAL_UINT16(sim->word(STATE_OF_HEALTH), battery->stateOfHealth());
+  TEST_ASSERT_EQUAL(2023, battery->manufactureYear());
+  TEST_ASSERT_EQUAL_INT16(-1250, battery->current());
+  TEST_ASSERT_EQUAL_INT16(-1198, battery->averageCurrent());
+  TEST_ASSERT_EQUAL(251, battery->temperatureC());
+  TEST_ASSERT_EQUAL(771, battery->temperatureF());
+  TEST_ASSERT_EQUAL(-19800, battery->power());
+  TEST_ASSERT_EQUAL(-18976, battery->averagePower());
+  TEST_ASSERT_EQUAL(38837, battery->remainingEnergy());
+  TEST_ASSERT_EQUAL(44640, battery->fullEnergy());
+
+  BatteryStatus status = battery->batteryStatus();
+  TEST_ASSERT_TRUE_MESSAGE(status.initialized && status.discharging && !status.fully_charged, "batteryStatus");
+  TEST_ASSERT_TRUE(battery->statusOK());
+
+  BatteryMode mode = battery->batteryMode();
+  TEST_ASSERT_TRUE_MESSAGE(mode.internal_charge_controller && mode.alarm_mode && mode.charger_mode && !mode.capacity_mode,
+                           "batteryMode");
+
+  TEST_ASSERT_EQUAL_STRING("Texas Instruments", battery->manufacturerName());
+  TEST_ASSERT_EQUAL_STRING("bq40z50-R2", battery->deviceName());
+  TEST_ASSERT_EQUAL_MEMORY("LION", battery->deviceChemistry(), 4);
+}
+
+/**
+ * @brief Read identity strings into caller buffers: full 32-byte blocks, truncation without
+ * overflow, and two batteries whose strings are held at the same time.
+ */
+static void test_caller_buffer_strings() {
+  const char* longName = "ABCDEFGHIJKLMNOPQRSTUVWXYZ012345"; // 32 characters, the SMBus maximum
+  char buffer[SMBUS_BLOCK_MAX + 1];
+  sim->setString(DEVICE_NAME, longName);
+  TEST_ASSERT_EQUAL(32, battery->deviceName(buffer, sizeof(buffer)));
+  TEST_ASSERT_EQUAL_STRING(longName, buffer);
+
+  char small[8];
+  memset(small, '#', sizeof(small));
+  TEST_ASSERT_EQUAL(4, battery->deviceChemistry(small, 5));
+  TEST_ASSERT_EQUAL_STRING("LION", small);
+  TEST_ASSERT_EQUAL_MESSAGE('#', small[5], "chemistry fits a 5-byte buffer");
+  TEST_ASSERT_EQUAL(4, battery->deviceName(small, 5));
+  TEST_ASSERT_EQUAL_STRING("ABCD", small);
+  TEST_ASSERT_EQUAL_MESSAGE('#', small[5], "long name truncated without overflow");
+
+  SimBattery otherSim(0x0C);
+  otherSim.attach();
+  otherSim.setString(MANUFACTURER_NAME, "Other Cells Inc");
+  ArduinoSMBus other(0x0C);
+  char first[SMBUS_BLOCK_MAX + 1];
+  char second[SMBUS_BLOCK_MAX + 1];
+  battery->manufacturerName(first, sizeof(first));
+  other.manufacturerName(second, sizeof(second));
+  TEST_ASSERT_EQUAL_STRING("Texas Instruments", first);
+  TEST_ASSERT_EQUAL_STRING("Other Cells Inc", second);
+
+  otherSim.detach();
+  TEST_ASSERT_EQUAL(0, other.manufacturerName(second, sizeof(second)));
+  TEST_ASSERT_EQUAL_STRING("", second);
+  TEST_ASSERT_EQUAL(SMBUS_NACK_ADDRESS, other.lastStatus());
+}
+
+static_assert(BatteryStatus(0x8000).overChargedAlarm() && !BatteryStatus(0x8000).ok(), "constexpr BatteryStatus");
+static_assert(BatteryMode(0x8000).capacityMode() && BatteryMode(0x6001).all(BATTERY_MODE_ALARM_MODE | 1),
+              "constexpr BatteryMode");
+
+static_assert(std::is_same<decltype(ArduinoSMBus(0).read<CURRENT>()), int16_t>::value, "read<CURRENT>() is signed");
+static_assert(std::is_same<decltype(ArduinoSMBus(0).read<BATTERY_STATUS>()), BatteryStatus>::value,
+              "read<BATTERY_STATUS>() is a BatteryStatus");
+static_assert(SMBUS_REGISTER_COUNT == 27 && smbusRegisterIndex(0xff) == SMBUS_REGISTER_COUNT, "register table size");
+
+/**
+ * @brief Check the register descriptors: typed reads agree with the simulated pack, lookups
+ * find every described register, and enableCache() derives its defaults from volatility.
+ */
+static void test_register_descriptors() {
+  TEST_ASSERT_EQUAL_INT16((int16_t)sim->word(CURRENT), battery->read<CURRENT>());
+  TEST_ASSERT_EQUAL_UINT16(sim->word(VOLTAGE), battery->read<VOLTAGE>());
+  TEST_ASSERT_EQUAL_UINT16(sim->word(BATTERY_STATUS), battery->read<BATTERY_STATUS>().raw);
+
+  for (uint8_t i = 0; i < SMBUS_REGISTER_COUNT; i++) {
+    const SMBusRegisterInfo* info = ArduinoSMBus::registerInfo(smbusRegisters[i].command);
+    TEST_ASSERT_NOT_NULL(info);
+    TEST_ASSERT_EQUAL_HEX8(smbusRegisters[i].command, info->command);
+    TEST_ASSERT_EQUAL(smbusRegisters[i].wireType, info->wireType);
+  }
+  TEST_ASSERT_NULL(ArduinoSMBus::registerInfo(MANUFACTURER_ACCESS));
+  const SMBusRegisterInfo* temperature = ArduinoSMBus::registerInfo(TEMPERATURE);
+  TEST_ASSERT_EQUAL(SMBUS_UNIT_KELVIN, temperature->unit);
+  TEST_ASSERT_EQUAL(-1, temperature->exponent);
+
+  battery->enableCache();
+  TEST_ASSERT_EQUAL(SMBUS_CACHE_IMMUTABLE, battery->cachePolicy(DESIGN_CAPACITY));
+  TEST_ASSERT_EQUAL(SMBUS_CACHE_IMMUTABLE, battery->cachePolicy(DEVICE_CHEMISTRY));
+  TEST_ASSERT_EQUAL(SMBUS_CACHE_TTL, battery->cachePolicy(CYCLE_COUNT));
+  TEST_ASSERT_EQUAL(SMBUS_CACHE_LIVE, battery->cachePolicy(VOLTAGE));
+}
+
+/**
+ * @brief Check for every possible register word that the bit-field members, the accessors and
+ * the masks agree with the bit positions in the Smart Battery Data Specification.
+ */
+static void test_bit_packing() {
+  bool statusMatches = true;
+  bool modeMatches = true;
+  for (uint32_t word = 0; word <= 0xffff; word++) {
+    BatteryStatus status(word);
+    statusMatches &= status.over_charged_alarm == ((word >> 15) & 1) && status.overChargedAlarm() == status.over_charged_alarm &&
+                     status.term_charge_alarm == ((word >> 14) & 1) && status.termChargeAlarm() == status.term_charge_alarm &&
+                     status.over_temp_alarm == ((word >> 12) & 1) && status.overTempAlarm() == status.over_temp_alarm &&
+                     status.term_discharge_alarm == ((word >> 11) & 1) && status.termDischargeAlarm() == status.term_discharge_alarm &&
+                     status.rem_capacity_alarm == ((word >> 9) & 1) && status.remCapacityAlarm() == status.rem_capacity_alarm &&
+                     status.rem_time_alarm == ((word >> 8) & 1) && status.remTimeAlarm() == status.rem_time_alarm &&
+                     status.initialized == ((word >> 7) & 1) && status.isInitialized() == status.initialized &&
+                     status.discharging == ((word >> 6) & 1) && status.isDischarging() == status.discharging &&
+                     status.fully_charged == ((word >> 5) & 1) && status.isFullyCharged() == status.fully_charged &&
+                     status.fully_discharged == ((word >> 4) & 1) && status.isFullyDischarged() == status.fully_discharged &&
+                     status.error_code == (word & 0xf) && status.errorCode() == (word & 0xf) &&
+                     status.ok() == !(status.over_charged_alarm || status.term_charge_alarm || status.over_temp_alarm ||
+                                      status.term_discharge_alarm);
+
+    BatteryMode mode(word);
+    modeMatches &= mode.internal_charge_controller == (word & 1) && mode.internalChargeController() == mode.internal_charge_controller &&
+                   mode.primary_battery_support == ((word >> 1) & 1) && mode.primaryBatterySupport() == mode.primary_battery_support &&
+                   mode.condition_flag == ((word >> 7) & 1) && mode.conditionFlag() == mode.condition_flag &&
+                   mode.charge_controller_enabled == ((word >> 8) & 1) && mode.chargeControllerEnabled() == mode.charge_controller_enabled &&
+                   mode.primary_battery == ((word >> 9) & 1) && mode.primaryBattery() == mode.primary_battery &&
+                   mode.alarm_mode == ((word >> 13) & 1) && mode.alarmMode() == mode.alarm_mode &&
+                   mode.charger_mode == ((word >> 14) & 1) && mode.chargerMode() == mode.charger_mode &&
+                   mode.capacity_mode == ((word >> 15) & 1) && mode.capacityMode() == mode.capacity_mode;
+  }
+  TEST_ASSERT_TRUE_MESSAGE(statusMatches, "BatteryStatus fields match register bits for all words");
+  TEST_ASSERT_TRUE_MESSAGE(modeMatches, "BatteryMode fields match register bits for all words");
+
+  BatteryStatus status;
+  status.over_temp_alarm = true;
+  status.initialized = true;
+  TEST_ASSERT_EQUAL_HEX16(BATTERY_STATUS_OVER_TEMP_ALARM | BATTERY_STATUS_INITIALIZED, status.raw);
+}
+
+static_assert(smbusDeciCelsius(0) == -2731 && smbusDeciCelsius(2731) == 0 && smbusDeciCelsius(65535) == 32767,
+              "constexpr smbusDeciCelsius");
+static_assert(smbusDeciFahrenheit(3731) == 2119 && smbusDeciFahrenheit(0) == -4597, "constexpr smbusDeciFahrenheit");
+static_assert(smbusMilliwatts(16800, -32768) == -550502 && smbusMilliwattHours(3300, 14400, false) == 47520,
+              "constexpr power and energy");
+
+/**
+ * @brief Round a / b to nearest, halves away from zero, with a real division.
+ */
+static int64_t roundedQuotient(int64_t a, int64_t b) {
+  return a < 0 ? -((-a + b / 2) / b) : (a + b / 2) / b;
+}
+
+static int64_t saturated16(int64_t value) {
+  return value > 32767 ? 32767 : value < -32768 ? -32768 : value;
+}
+
+/**
+ * @brief Check the integer-only conversions against divisions for every register word.
+ */
+static void test_unit_conversions() {
+  static const uint16_t voltages[] = {0, 1, 499, 500, 999, 1000, 1001, 3700, 14400, 16800, 65535};
+  static const int16_t currents[] = {-32768, -32767, -1250, -1, 0, 1, 2, 1250, 32767};
+  bool divide = true, celsius = true, fahrenheit = true, power = true, energy = true;
+
+  for (uint32_t word = 0; word <= 0xffff; word++) {
+    divide &= smbusDivide10(word) == word / 10 && smbusDivide1000(word) == word / 1000;
+    celsius &= smbusDeciCelsius(word) == saturated16((int64_t)word - 2731);
+    // 1.8 * word - 4596.7, rounded half up
+    int64_t tenths = 18 * (int64_t)word - 45967;
+    fahrenheit &= smbusDeciFahrenheit(word) == saturated16(tenths >= -5 ? (tenths + 5) / 10 : -((-tenths - 5 + 9) / 10));
+
+    for (uint16_t volts : voltages) {
+      power &= smbusMilliwatts(volts, (int16_t)word) == roundedQuotient((int64_t)volts * (int16_t)word, 1000);
+      energy &= smbusMilliwattHours(word, volts, false) == (uint32_t)roundedQuotient((int64_t)word * volts, 1000) &&
+                smbusMilliwattHours(word, volts, true) == word * 10;
+    }
+    for (int16_t amps : currents) {
+      power &= smbusMilliwatts(word, amps) == roundedQuotient((int64_t)word * amps, 1000);
+    }
+  }
+  // Products beyond 16 bits, up to the largest the power and energy conversions produce
+  for (uint64_t x = 0; x <= 0xffffffffULL; x += 65521) {
+    divide &= smbusDivide1000((uint32_t)x) == x / 1000;
+  }
+  divide &= smbusDivide1000(0xffffffffUL) == 0xffffffffUL / 1000;
+
+  TEST_ASSERT_TRUE_MESSAGE(divide, "division-free /10 and /1000");
+  TEST_ASSERT_TRUE_MESSAGE(celsius, "smbusDeciCelsius for all words");
+  TEST_ASSERT_TRUE_MESSAGE(fahrenheit, "smbusDeciFahrenheit for all words");
+  TEST_ASSERT_TRUE_MESSAGE(power, "smbusMilliwatts for all currents and voltages");
+  TEST_ASSERT_TRUE_MESSAGE(energy, "smbusMilliwattHours for all capacities");
+}
+
+/**
+ * @brief Write registers singly and through the typed setters.
+ */
+static void test_writes() {
+  TEST_ASSERT_EQUAL(SMBUS_OK, battery->writeRegister(REMAINING_CAPACITY_ALARM, 250));
+  TEST_ASSERT_EQUAL_UINT16(250, sim->word(REMAINING_CAPACITY_ALARM));
+  TEST_ASSERT_TRUE_MESSAGE(battery->writeRegister(VOLTAGE, 1) != SMBUS_OK && battery->lastStatus() != SMBUS_OK &&
+                           sim->word(VOLTAGE) != 1, "write to a read-only register fails");
+  TEST_ASSERT_EQUAL(SMBUS_OK, battery->write<REMAINING_TIME_ALARM>(12));
+  TEST_ASSERT_EQUAL_UINT16(12, battery->remainingTimeAlarm());
+
+  TEST_ASSERT_EQUAL(SMBUS_OK, battery->setAlarmMode(false));
+  TEST_ASSERT_FALSE(battery->batteryMode().alarmMode());
+  TEST_ASSERT_EQUAL(SMBUS_OK, battery->setChargerMode(false));
+  TEST_ASSERT_FALSE(BatteryMode(sim->word(BATTERY_MODE)).chargerMode());
+}
+
+/**
+ * @brief Changing capacity_mode discards cached capacities, which change units.
+ */
+static void test_capacity_mode_invalidates_cache() {
+  battery->enableCache();
+  battery->designCapacity();
+  uint32_t misses = battery->cacheMisses();
+  TEST_ASSERT_EQUAL(SMBUS_OK, battery->setCapacityMode(true));
+  TEST_ASSERT_TRUE(battery->batteryMode().capacityMode());
+  battery->designCapacity();
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(misses + 1, battery->cacheMisses(), "BatteryMode write invalidates the cache");
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(10UL * sim->word(REM_CAPACITY), battery->remainingEnergy(),
+                                   "energy in 10 mWh capacity mode");
+}
+
+/**
+ * @brief A batch is written, then verified in one read-back pass; a bit the battery does not
+ * let the host change fails verification.
+ */
+static void test_verified_batch() {
+  SimBus& bus = SimBus::instance();
+  BatteryMode newMode(sim->word(BATTERY_MODE) & ~BATTERY_MODE_ALARM_MODE);
+  SMBusWordWrite batch[] = {
+    {REMAINING_CAPACITY_ALARM, 330, 0xffff, SMBUS_OK},
+    {REMAINING_TIME_ALARM, 15, 0xffff, SMBUS_OK},
+    {BATTERY_MODE, newMode.raw, BATTERY_MODE_WRITABLE, SMBUS_OK},
+  };
+  bus.resetStats();
+  TEST_ASSERT_TRUE(battery->writeRegisters(batch, 3));
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(3 + 3 + 3, bus.stats().transactions, "batch is three writes and three reads");
+  TEST_ASSERT_EQUAL_UINT16(330, sim->word(REMAINING_CAPACITY_ALARM));
+  TEST_ASSERT_EQUAL_UINT16(15, sim->word(REMAINING_TIME_ALARM));
+
+  SMBusWordWrite readOnlyBit = {BATTERY_MODE, (uint16_t)(newMode.raw ^ BATTERY_MODE_CONDITION_FLAG), 0xffff, SMBUS_OK};
+  TEST_ASSERT_FALSE(battery->writeRegisters(&readOnlyBit, 1));
+  TEST_ASSERT_EQUAL(SMBUS_VERIFY_ERROR, readOnlyBit.status);
+  TEST_ASSERT_EQUAL(SMBUS_VERIFY_ERROR, battery->lastStatus());
+}
+
+/**
+ * @brief Write Word and Write Block with PEC.
+ */
+static void test_writes_with_pec() {
+  sim->setPEC(true);
+  battery->enablePEC();
+  TEST_ASSERT_EQUAL(SMBUS_OK, battery->setRemainingCapacityAlarm(275));
+  TEST_ASSERT_EQUAL_UINT16(275, sim->word(REMAINING_CAPACITY_ALARM));
+
+  const char* data = "lot 42";
+  uint8_t block[SMBUS_BLOCK_MAX];
+  TEST_ASSERT_EQUAL(SMBUS_OK, battery->writeBlock(0x23, reinterpret_cast<const uint8_t*>(data), strlen(data)));
+  SMBusResult result = battery->readBlock(0x23, block, sizeof(block));
+  TEST_ASSERT_EQUAL(SMBUS_OK, result.status);
+  TEST_ASSERT_EQUAL(strlen(data), result.value);
+  TEST_ASSERT_EQUAL_MEMORY(data, block, strlen(data));
+  TEST_ASSERT_EQUAL_MESSAGE(SMBUS_BUS_ERROR, battery->writeBlock(0x23, block, SMBUS_BLOCK_MAX + 1), "block too long");
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_registers_match_pack);
+  RUN_TEST(test_caller_buffer_strings);
+  RUN_TEST(test_register_descriptors);
+  RUN_TEST(test_bit_packing);
+  RUN_TEST(test_unit_conversions);
+  RUN_TEST(test_writes);
+  RUN_TEST(test_capacity_mode_invalidates_cache);
+  RUN_TEST(test_verified_batch);
+  RUN_TEST(test_writes_with_pec);
+  return UNITY_END();
+}
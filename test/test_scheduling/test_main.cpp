@@ -0,0 +1,308 @@
+/**
+ * @file test_main.cpp
+ * @brief RateGroupScheduler schedules and BatteryBus polling of several packs.
+ * @version 1.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ * Run with `pio test -e native`. Every test starts from a freshly attached simulated battery.
+ */
+
+#include <string.h>
+
+#include <Arduino.h>
+#include <Wire.h>
+#include <unity.h>
+#include "ArduinoSMBus.h"
+#include "BatteryBus.h"
+#include "RateGroupScheduler.h"
+#include "SimBattery.h"
+
+#define BATTERY_ADDRESS 0x0B
+#define PACKS 16
+#define PACK_BASE_ADDRESS 0x20
+
+static SimBattery* sim;
+static ArduinoSMBus* battery;
+
+void setUp() {
+  SimBus& bus = SimBus::instance();
+  bus.setClock(100000);
+  bus.setTransactionOverheadNanos(50000);
+  bus.clearFaults();
+  bus.resetStats();
+  Wire.setDeferredWrites(false);
+  sim = new SimBattery(BATTERY_ADDRESS);
+  sim->attach();
+  battery = new ArduinoSMBus(BATTERY_ADDRESS);
+}
+
+void tearDown() {
+  delete battery;
+  delete sim;
+}
+
+static const RateGroupEntry table[] = {
+  {CYCLE_COUNT, 60000}, {STATE_OF_HEALTH, 60000},
+  {REL_STATE_OF_CHARGE, 1000}, {RUN_TIME_TO_EMPTY, 1000}, {AVG_TIME_TO_EMPTY, 1000}, {AVG_TIME_TO_FULL, 1000},
+  {BATTERY_STATUS, 100}, {VOLTAGE, 100}, {CURRENT, 100}, {TEMPERATURE, 100},
+};
+static const uint8_t tableSize = sizeof(table) / sizeof(table[0]);
+
+static uint32_t reads[256];
+
+static void countRead(uint8_t reg, uint16_t value, bool ok, void* context) {
+  (void)value;
+  if (ok) {
+    static_cast<uint32_t*>(context)[reg]++;
+  }
+}
+
+/**
+ * @brief Run one major frame of a 10 Hz / 1 Hz / 1 per minute schedule; every register is
+ * read at its rate within the estimated frame time.
+ */
+static void test_rate_groups() {
+  RateGroupScheduler scheduler(*battery);
+  battery->setAdaptiveTurnaround(false);
+  memset(reads, 0, sizeof(reads));
+  scheduler.onRead(countRead, reads);
+  TEST_ASSERT_EQUAL_MESSAGE(RATE_GROUP_OK, scheduler.configure(table, tableSize), "rate table accepted");
+  TEST_ASSERT_EQUAL_UINT32(100, scheduler.minorFrame());
+  TEST_ASSERT_EQUAL_UINT32(60000, scheduler.majorFrame());
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(5 * scheduler.readCost(), scheduler.worstFrameMicros(),
+                                   "slow registers spread over the quiet frames");
+
+  int most = 0;
+  while (scheduler.frames() < 600) {
+    int n = scheduler.service();
+    if (n < 0) {
+      delayMicroseconds(200);
+    }
+    most = n > most ? n : most;
+  }
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(600, reads[VOLTAGE], "10 Hz registers read every frame");
+  TEST_ASSERT_EQUAL_UINT32(600, reads[CURRENT]);
+  TEST_ASSERT_EQUAL_UINT32(600, reads[BATTERY_STATUS]);
+  TEST_ASSERT_EQUAL_UINT32(600, reads[TEMPERATURE]);
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(60, reads[REL_STATE_OF_CHARGE], "1 Hz registers read at their rate");
+  TEST_ASSERT_EQUAL_UINT32(60, reads[AVG_TIME_TO_FULL]);
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(1, reads[CYCLE_COUNT], "per-minute registers read at their rate");
+  TEST_ASSERT_EQUAL_UINT32(1, reads[STATE_OF_HEALTH]);
+  TEST_ASSERT_EQUAL(5, most);
+  TEST_ASSERT_LESS_OR_EQUAL_MESSAGE(scheduler.worstFrameMicros(), scheduler.longestFrameMicros(),
+                                    "frames within their estimated bus time");
+  TEST_ASSERT_EQUAL_UINT32(0, scheduler.overruns());
+}
+
+/**
+ * @brief Schedules that cannot work are rejected, and the previous one is kept.
+ */
+static void test_rate_groups_rejected() {
+  RateGroupScheduler scheduler(*battery);
+  battery->setAdaptiveTurnaround(false);
+  static const RateGroupEntry skewed[] = {{VOLTAGE, 100}, {CURRENT, 250}};
+  static const RateGroupEntry strings[] = {{VOLTAGE, 100}, {DEVICE_NAME, 1000}};
+  RateGroupEntry crowded[RATE_GROUP_MAX_ENTRIES];
+  for (int i = 0; i < RATE_GROUP_MAX_ENTRIES; i++) {
+    crowded[i].reg = VOLTAGE;
+    crowded[i].periodMs = 10;
+  }
+  TEST_ASSERT_EQUAL(RATE_GROUP_OK, scheduler.configure(table, tableSize));
+  TEST_ASSERT_EQUAL_MESSAGE(RATE_GROUP_NOT_HARMONIC, scheduler.configure(skewed, 2), "non-harmonic periods rejected");
+  TEST_ASSERT_EQUAL_MESSAGE(RATE_GROUP_BAD_REGISTER, scheduler.configure(strings, 2), "block register rejected");
+  TEST_ASSERT_EQUAL_MESSAGE(RATE_GROUP_OVERLOADED, scheduler.configure(crowded, RATE_GROUP_MAX_ENTRIES),
+                            "overloaded schedule rejected");
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(100, scheduler.minorFrame(), "previous schedule kept");
+  scheduler.setBusClock(400000);
+  scheduler.setTransactionOverhead(20);
+  TEST_ASSERT_EQUAL_MESSAGE(RATE_GROUP_OK, scheduler.configure(crowded, RATE_GROUP_MAX_ENTRIES),
+                            "same table fits at 400 kHz");
+  TEST_ASSERT_LESS_OR_EQUAL(80, scheduler.utilisation());
+
+  // While the turnaround adapts, the worst case is the longest turnaround plus a failed probe
+  battery->setAdaptiveTurnaround(true);
+  TEST_ASSERT_EQUAL_MESSAGE(RATE_GROUP_OVERLOADED, scheduler.configure(crowded, RATE_GROUP_MAX_ENTRIES),
+                            "table that only fits without a turnaround rejected while it adapts");
+}
+
+/**
+ * @brief An adapting turnaround is charged at its bound, as a split read where the command
+ * is deferred.
+ */
+static void test_rate_groups_turnaround_cost() {
+  RateGroupScheduler adaptive(*battery);
+  battery->setAdaptiveTurnaround(true);
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(480 + RATE_GROUP_OVERHEAD_US + SMBUS_TURNAROUND_MAX_US, adaptive.readCost(),
+                                   "adaptive turnaround charged at its bound");
+  TEST_ASSERT_EQUAL(RATE_GROUP_OK, adaptive.configure(table, tableSize));
+  TEST_ASSERT_EQUAL_UINT32(6 * adaptive.readCost(), adaptive.worstFrameMicros());
+  battery->setDeferredRepeatedStart(true);
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(490 + 2 * RATE_GROUP_OVERHEAD_US + SMBUS_TURNAROUND_MAX_US, adaptive.readCost(),
+                                   "turnaround charged as a split read where the command is deferred");
+  battery->setDeferredRepeatedStart(false);
+  adaptive.setTurnaroundBound(2000);
+  TEST_ASSERT_EQUAL(RATE_GROUP_OK, adaptive.configure(table, tableSize));
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(480 + RATE_GROUP_OVERHEAD_US + 2000, adaptive.readCost(), "explicit turnaround bound");
+}
+
+/**
+ * @brief A gauge that NACKs until ready, learned from scratch, stays within the estimate
+ * whether the read is combined or split around the turnaround.
+ */
+static void test_rate_groups_slow_gauge() {
+  RateGroupScheduler adaptive(*battery);
+  adaptive.setTurnaroundBound(2000);
+  sim->setClockStretching(false);
+  sim->setTurnaroundMicros(1200);
+  for (uint8_t deferred = 0; deferred < 2; deferred++) {
+    Wire.setDeferredWrites(deferred);
+    battery->setDeferredRepeatedStart(deferred);
+    battery->setTurnaround(0);
+    battery->setAdaptiveTurnaround(true);
+    TEST_ASSERT_EQUAL_MESSAGE(RATE_GROUP_OK, adaptive.configure(table, tableSize), "table accepted for a slow gauge");
+    uint32_t start = adaptive.frames();
+    while (adaptive.frames() - start < 600) {
+      if (adaptive.service() < 0) {
+        delayMicroseconds(200);
+      }
+    }
+    TEST_ASSERT_LESS_OR_EQUAL_MESSAGE(adaptive.worstFrameMicros(), adaptive.longestFrameMicros(),
+                                      "frames within the estimate while the turnaround adapts");
+    TEST_ASSERT_EQUAL_UINT32(0, adaptive.overruns());
+  }
+}
+
+/**
+ * @brief Run a BatteryBus for a number of simulated milliseconds.
+ */
+static void runBus(BatteryBus& bus, uint32_t ms) {
+  unsigned long start = millis();
+  while (millis() - start < ms) {
+    if (bus.service() < 0) {
+      delayMicroseconds(100);
+    }
+  }
+}
+
+/**
+ * @brief Poll 16 packs on one bus, one of them absent and one slow; the schedule stays fair,
+ * and weights and share caps are honoured.
+ */
+static void test_battery_bus() {
+  SimBattery* sims[PACKS];
+  ArduinoSMBus* packs[PACKS];
+  BatteryBus bus;
+
+  for (int i = 0; i < PACKS; i++) {
+    sims[i] = new SimBattery(PACK_BASE_ADDRESS + i);
+    sims[i]->attach();
+    packs[i] = new ArduinoSMBus(PACK_BASE_ADDRESS + i);
+    TEST_ASSERT_EQUAL_MESSAGE(i, bus.addPack(*packs[i]), "addPack");
+  }
+  ArduinoSMBus extra(0x7f);
+  TEST_ASSERT_EQUAL_MESSAGE(-1, bus.addPack(extra), "addPack beyond BATTERY_BUS_MAX_PACKS");
+
+  sims[3]->detach();                 // Pack 3 NACKs
+  sims[7]->setTurnaroundMicros(3000); // Pack 7 is slow and cannot clock stretch
+  sims[7]->setClockStretching(false);
+  runBus(bus, 5000);
+
+  uint32_t minimum = 0xffffffff;
+  uint32_t maximum = 0;
+  for (int i = 0; i < PACKS; i++) {
+    if (i != 3 && i != 7) {
+      minimum = bus.stats(i).polls < minimum ? bus.stats(i).polls : minimum;
+      maximum = bus.stats(i).polls > maximum ? bus.stats(i).polls : maximum;
+    }
+  }
+  TEST_ASSERT_LESS_OR_EQUAL_MESSAGE(maximum / 20, maximum - minimum, "healthy packs polled evenly");
+  TEST_ASSERT_LESS_THAN_MESSAGE(20, bus.stats(3).polls, "absent pack backs off");
+  TEST_ASSERT_TRUE(bus.stats(3).backingOff);
+  TEST_ASSERT_LESS_THAN_MESSAGE(2 * bus.stats(0).busMicros, bus.stats(7).busMicros,
+                                "slow pack limited to a fair share of bus time");
+  TEST_ASSERT_EQUAL_UINT16(sims[5]->word(VOLTAGE), bus.snapshot(5).voltage);
+
+  BatteryBus weighted;
+  for (int i = 0; i < 4; i++) {
+    sims[i]->attach();
+    sims[i]->setTurnaroundMicros(0);
+    weighted.addPack(*packs[i]);
+  }
+  weighted.setWeight(0, 4);
+  weighted.setMaxShare(1, 5);
+  uint64_t start = simNanos();
+  runBus(weighted, 2000);
+  uint64_t elapsed = simNanos() - start;
+  TEST_ASSERT_GREATER_THAN_MESSAGE(3 * weighted.stats(2).polls, weighted.stats(0).polls, "weighted pack polled more");
+  TEST_ASSERT_LESS_OR_EQUAL_MESSAGE(elapsed / 1000 / 20 + 4000, weighted.stats(1).busMicros,
+                                    "capped pack within its share");
+
+  for (int i = 0; i < PACKS; i++) {
+    delete packs[i];
+    delete sims[i];
+  }
+}
+
+/**
+ * @brief Pipelined rounds read every pack correctly and overlap their turnarounds.
+ */
+static void test_pipelined_rounds() {
+  const uint32_t rounds = 20;
+  SimBattery* sims[PACKS];
+  ArduinoSMBus* batteries[PACKS];
+  BatteryBus bus;
+  for (uint8_t i = 0; i < PACKS; i++) {
+    sims[i] = new SimBattery(PACK_BASE_ADDRESS + i);
+    sims[i]->attach();
+    sims[i]->setTurnaroundMicros(2000);
+    sims[i]->setWord(VOLTAGE, 11000 + i);
+    batteries[i] = new ArduinoSMBus(PACK_BASE_ADDRESS + i);
+    bus.addPack(*batteries[i]);
+  }
+
+  // Let both turnarounds settle before comparing
+  for (uint32_t r = 0; r < 5; r++) {
+    for (uint8_t i = 0; i < PACKS; i++) {
+      bus.service();
+    }
+    bus.pollAll();
+  }
+
+  uint64_t start = simNanos();
+  for (uint32_t r = 0; r < rounds; r++) {
+    for (uint8_t i = 0; i < PACKS; i++) {
+      bus.service();
+    }
+  }
+  uint64_t sequential = simNanos() - start;
+
+  start = simNanos();
+  for (uint32_t r = 0; r < rounds; r++) {
+    TEST_ASSERT_EQUAL_MESSAGE(PACKS, bus.pollAll(), "pipelined round polls every pack");
+  }
+  uint64_t pipelined = simNanos() - start;
+
+  for (uint8_t i = 0; i < PACKS; i++) {
+    TEST_ASSERT_EQUAL_UINT16_MESSAGE(11000 + i, bus.snapshot(i).voltage, "pipelined voltage");
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, bus.stats(i).failures, "pipelined reads succeed");
+  }
+  TEST_ASSERT_LESS_THAN_MESSAGE(sequential / 3, pipelined, "pipelining scales with pack count");
+
+  for (uint8_t i = 0; i < PACKS; i++) {
+    delete batteries[i];
+    delete sims[i];
+  }
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_rate_groups);
+  RUN_TEST(test_rate_groups_rejected);
+  RUN_TEST(test_rate_groups_turnaround_cost);
+  RUN_TEST(test_rate_groups_slow_gauge);
+  RUN_TEST(test_battery_bus);
+  RUN_TEST(test_pipelined_rounds);
+  return UNITY_END();
+}
@@ -0,0 +1,498 @@
+/**
+ * @file test_main.cpp
+ * @brief TelemetryLog, the binary snapshot stream, ChangeDetector and AdaptivePollRate.
+ * @version 1.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ * Run with `pio test -e native`. Every test starts from a freshly attached simulated battery.
+ */
+
+#include <string.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <Arduino.h>
+#include <Wire.h>
+#include <unity.h>
+#include "ArduinoSMBus.h"
+#include "BatteryPoller.h"
+#include "ChangeDetector.h"
+#include "SimBattery.h"
+#include "SnapshotStream.h"
+#include "TelemetryLog.h"
+
+#define BATTERY_ADDRESS 0x0B
+
+static SimBattery* sim;
+static ArduinoSMBus* battery;
+
+void setUp() {
+  SimBus& bus = SimBus::instance();
+  bus.setClock(100000);
+  bus.setTransactionOverheadNanos(50000);
+  bus.clearFaults();
+  bus.resetStats();
+  Wire.setDeferredWrites(false);
+  sim = new SimBattery(BATTERY_ADDRESS);
+  sim->attach();
+  battery = new ArduinoSMBus(BATTERY_ADDRESS);
+}
+
+void tearDown() {
+  delete battery;
+  delete sim;
+}
+
+/**
+ * @brief Check packing, clamping, long gaps and wraparound of a TelemetryLog.
+ */
+static void test_telemetry_log() {
+  TelemetryLog<8> log;
+  TEST_ASSERT_EQUAL_MESSAGE(0, log.size(), "empty log");
+  TEST_ASSERT_FALSE(log.begin() != log.end());
+
+  // Status with every defined bit set survives packing; extreme values are clamped
+  log.append(1000, 16800, -32768, 5000, 200, 0xdbff);
+  log.append(2000, 12000, 32767, 1000, 100, 0x0080);
+  auto it = log.begin();
+  const TelemetryRecord& first = *it;
+  TEST_ASSERT_EQUAL_UINT32(1000, first.timestamp);
+  TEST_ASSERT_EQUAL_UINT16(16800, first.voltage);
+  TEST_ASSERT_EQUAL_INT16(-32768, first.current);
+  TEST_ASSERT_EQUAL_MESSAGE(TELEMETRY_TEMPERATURE_MIN + TELEMETRY_TEMPERATURE_SPAN, first.temperature,
+                            "record packing and clamping");
+  TEST_ASSERT_EQUAL(TELEMETRY_SOC_MAX, first.relative_state_of_charge);
+  TEST_ASSERT_EQUAL_HEX16(0xdbff, first.battery_status);
+  auto second = ++log.begin();
+  TEST_ASSERT_EQUAL_UINT32(2000, second->timestamp);
+  TEST_ASSERT_EQUAL_INT16(32767, second->current);
+  TEST_ASSERT_EQUAL(TELEMETRY_TEMPERATURE_MIN, second->temperature);
+  TEST_ASSERT_EQUAL(100, second->relative_state_of_charge);
+  TEST_ASSERT_EQUAL_HEX16(0x0080, second->battery_status);
+
+  // A gap too long for a ms delta is rounded to seconds without drifting later records
+  log.append(102500, 12000, 0, 2982, 50, 0);
+  log.append(103600, 12000, 0, 2982, 50, 0);
+  uint32_t timestamps[8];
+  size_t count = 0;
+  for (const TelemetryRecord& record : log) {
+    timestamps[count++] = record.timestamp;
+  }
+  TEST_ASSERT_EQUAL(4, count);
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(102000, timestamps[2], "long gap timestamps");
+  TEST_ASSERT_EQUAL_UINT32(103600, timestamps[3]);
+
+  // Wrap around twice; the oldest record's timestamp follows the evictions
+  for (uint32_t t = 104000; t < 124000; t += 1000) {
+    log.append(t, t / 1000, 0, 2982, 50, 0);
+  }
+  count = 0;
+  bool ordered = true;
+  for (const TelemetryRecord& record : log) {
+    ordered &= record.timestamp == 116000 + count * 1000 && record.voltage == record.timestamp / 1000;
+    count++;
+  }
+  TEST_ASSERT_EQUAL(8, log.size());
+  TEST_ASSERT_EQUAL_UINT32(24, log.appended());
+  TEST_ASSERT_EQUAL(8, count);
+  TEST_ASSERT_TRUE_MESSAGE(ordered, "wraparound keeps the newest records in order");
+}
+
+/**
+ * @brief Snapshots are recorded only when they carry every logged field.
+ */
+static void test_telemetry_snapshot() {
+  TelemetryLog<8> log;
+  BatterySnapshot snapshot;
+  TEST_ASSERT_TRUE(battery->readSnapshot(snapshot, SNAPSHOT_ESSENTIAL));
+  TEST_ASSERT_TRUE_MESSAGE(log.append(snapshot), "append a snapshot");
+  TelemetryRecord record = *log.begin();
+  TEST_ASSERT_EQUAL_UINT16(sim->word(VOLTAGE), record.voltage);
+  TEST_ASSERT_EQUAL_INT16((int16_t)sim->word(CURRENT), record.current);
+  TEST_ASSERT_EQUAL(sim->word(TEMPERATURE), record.temperature);
+  TEST_ASSERT_EQUAL_HEX16_MESSAGE(sim->word(BATTERY_STATUS), record.battery_status, "snapshot fields recorded");
+  snapshot.valid &= ~SNAPSHOT_CURRENT;
+  TEST_ASSERT_FALSE_MESSAGE(log.append(snapshot), "incomplete snapshot not recorded");
+  TEST_ASSERT_EQUAL_UINT32(1, log.appended());
+}
+
+static TelemetryLog<3 * 3600> hours;
+
+/**
+ * @brief Iterate a log from several threads while it is appended to; no reader may see a
+ * torn record.
+ */
+static void test_telemetry_concurrent() {
+  TEST_ASSERT_LESS_THAN_MESSAGE(3 * 3600 * 10 + 64, sizeof(hours), "10 bytes a record");
+
+  const uint32_t appends = 200000;
+  const int readers = 3;
+  std::atomic<bool> done(false);
+  std::atomic<uint64_t> torn(0);
+  std::vector<std::thread> threads;
+  for (int r = 0; r < readers; r++) {
+    threads.emplace_back([&]() {
+      uint64_t bad = 0;
+      while (!done.load(std::memory_order_relaxed)) {
+        uint32_t previous = 0;
+        for (auto it = hours.begin(), end = hours.end(); it != end; ++it) {
+          // Each record carries its sequence number in every field
+          uint32_t n = it->timestamp / 1000;
+          bad += it->voltage != (n & 0xffff) || (uint16_t)it->current != (n & 0xffff) ||
+                 it->battery_status != (n & 0x03ff) || (previous != 0 && n <= previous);
+          previous = n;
+        }
+      }
+      torn += bad;
+    });
+  }
+
+  for (uint32_t n = 1; n <= appends; n++) {
+    hours.append(n * 1000, n & 0xffff, (int16_t)(n & 0xffff), 2982, 50, n & 0x03ff);
+  }
+  done = true;
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  TEST_ASSERT_EQUAL_UINT64_MESSAGE(0, torn.load(), "no torn telemetry records");
+  TEST_ASSERT_EQUAL(hours.capacity(), hours.size());
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE((appends - hours.capacity() + 1) * 1000, (*hours.begin()).timestamp,
+                                   "log holds the newest records after the stress run");
+}
+
+/**
+ * @brief Print that appends to a vector.
+ */
+class BufferPrint : public Print {
+public:
+  BufferPrint(std::vector<uint8_t>& bytes) : _bytes(bytes) {}
+  size_t write(uint8_t c) override {
+    _bytes.push_back(c);
+    return 1;
+  }
+  using Print::write;
+
+private:
+  std::vector<uint8_t>& _bytes;
+};
+
+/**
+ * @brief Fill snapshots with a slowly discharging pack polled once a second.
+ */
+static void makeDischarge(std::vector<BatterySnapshot>& snapshots, size_t count) {
+  uint32_t seed = 12345;
+  BatterySnapshot snapshot;
+  memset(&snapshot, 0, sizeof(snapshot));
+  snapshot.valid = SNAPSHOT_ALL;
+  snapshot.timestamp = 5000;
+  snapshot.battery_status = 0x00c0;
+  snapshot.voltage = 16400;
+  snapshot.temperature = 2982;
+  snapshot.relative_state_of_charge = 100;
+  snapshot.full_capacity = 5800;
+  snapshot.charging_voltage = 16800;
+  for (size_t i = 0; i < count; i++) {
+    seed = seed * 1103515245 + 12345;
+    int noise = (int)((seed >> 16) % 41) - 20;
+    snapshot.timestamp += 1000 + noise / 4;
+    snapshot.current = -1250 + noise;
+    snapshot.average_current = -1240 + noise / 8;
+    snapshot.voltage -= (i % 9 == 0);
+    snapshot.temperature += (i % 97 == 0) - (i % 131 == 0);
+    snapshot.remaining_capacity = 5800 - (uint16_t)(i / 3);
+    snapshot.relative_state_of_charge = snapshot.remaining_capacity * 100 / 5800;
+    snapshot.absolute_state_of_charge = snapshot.relative_state_of_charge;
+    snapshot.run_time_to_empty = snapshot.remaining_capacity * 60 / 1250;
+    snapshot.avg_time_to_empty = snapshot.remaining_capacity * 60 / 1240;
+    snapshot.avg_time_to_full = 65535;
+    snapshot.max_error = 1;
+    snapshot.valid = (i % 500 == 250) ? SNAPSHOT_ESSENTIAL : SNAPSHOT_ALL;
+    snapshots.push_back(snapshot);
+  }
+}
+
+static bool sameSnapshot(const BatterySnapshot& a, const BatterySnapshot& b) {
+  if (a.timestamp != b.timestamp || a.valid != b.valid) {
+    return false;
+  }
+  const uint16_t* x = &a.battery_status;
+  const uint16_t* y = &b.battery_status;
+  for (int i = 0; i < SNAPSHOT_STREAM_FIELDS; i++) {
+    if ((a.valid & (1 << i)) && x[i] != y[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static std::vector<BatterySnapshot> snapshots;
+static std::vector<uint8_t> bytes;
+
+/**
+ * @brief Encode a discharge once for the stream tests.
+ */
+static void encodeDischarge() {
+  if (!snapshots.empty()) {
+    return;
+  }
+  makeDischarge(snapshots, 20000);
+  BufferPrint out(bytes);
+  SnapshotEncoder encoder(out);
+  size_t largest = 0;
+  for (const BatterySnapshot& snapshot : snapshots) {
+    size_t length = encoder.write(snapshot);
+    largest = length > largest ? length : largest;
+  }
+  TEST_ASSERT_LESS_OR_EQUAL_MESSAGE(SNAPSHOT_STREAM_MAX_RECORD, largest, "record size bound");
+  TEST_ASSERT_EQUAL_UINT32(snapshots.size(), encoder.records());
+}
+
+/**
+ * @brief The binary stream decodes back exactly.
+ */
+static void test_stream_round_trip() {
+  encodeDischarge();
+  SnapshotDecoder decoder;
+  BatterySnapshot decoded;
+  size_t mismatches = 0;
+  const uint8_t* data = bytes.data();
+  const uint8_t* end = data + bytes.size();
+  size_t n = 0;
+  while (decoder.decode(data, end, decoded) == SNAPSHOT_STREAM_OK) {
+    mismatches += !sameSnapshot(decoded, snapshots[n++]);
+  }
+  TEST_ASSERT_EQUAL_MESSAGE(snapshots.size(), n, "binary stream round trip");
+  TEST_ASSERT_EQUAL(0, mismatches);
+  TEST_ASSERT_TRUE(data == end);
+  TEST_ASSERT_EQUAL_UINT32(0, decoder.errors());
+}
+
+/**
+ * @brief Bytes arriving one at a time decode to the same records.
+ */
+static void test_stream_split_at_every_byte() {
+  encodeDischarge();
+  SnapshotDecoder trickle;
+  BatterySnapshot decoded;
+  const uint8_t* data = bytes.data();
+  size_t n = 0;
+  size_t mismatches = 0;
+  for (const uint8_t* available = data; available <= bytes.data() + 2000; available++) {
+    SnapshotStreamStatus status;
+    while ((status = trickle.decode(data, available, decoded)) == SNAPSHOT_STREAM_OK) {
+      mismatches += !sameSnapshot(decoded, snapshots[n++]);
+    }
+    mismatches += status != SNAPSHOT_STREAM_INCOMPLETE;
+  }
+  TEST_ASSERT_GREATER_THAN(50, n);
+  TEST_ASSERT_EQUAL_MESSAGE(0, mismatches, "decode a stream split at every byte");
+}
+
+/**
+ * @brief A damaged record is dropped and decoding resumes at the next keyframe.
+ */
+static void test_stream_recovers_at_keyframe() {
+  encodeDischarge();
+  std::vector<uint8_t> damaged(bytes.begin(), bytes.begin() + 4000);
+  damaged[200] ^= 0x10;
+  SnapshotDecoder recovering;
+  BatterySnapshot decoded;
+  const uint8_t* data = damaged.data();
+  const uint8_t* end = data + damaged.size();
+  size_t good = 0;
+  size_t unsynced = 0;
+  size_t firstAfter = 0;
+  size_t mismatches = 0;
+  SnapshotStreamStatus status;
+  while ((status = recovering.decode(data, end, decoded)) != SNAPSHOT_STREAM_INCOMPLETE) {
+    if (status == SNAPSHOT_STREAM_OK) {
+      // Find the record by its timestamp, which is unique in this data
+      size_t index = good == 0 ? 0 : firstAfter;
+      while (index < snapshots.size() && snapshots[index].timestamp != decoded.timestamp) {
+        index++;
+      }
+      mismatches += index == snapshots.size() || !sameSnapshot(decoded, snapshots[index]);
+      firstAfter = index + 1;
+      good++;
+    } else if (status == SNAPSHOT_STREAM_UNSYNCED) {
+      unsynced++;
+    }
+  }
+  TEST_ASSERT_GREATER_OR_EQUAL(1, recovering.errors());
+  TEST_ASSERT_GREATER_THAN(0, unsynced);
+  TEST_ASSERT_LESS_THAN_MESSAGE(SNAPSHOT_STREAM_KEYFRAME_INTERVAL, unsynced,
+                                "recover from a damaged record at the next keyframe");
+  TEST_ASSERT_GREATER_THAN(100, good);
+  TEST_ASSERT_EQUAL(0, mismatches);
+}
+
+struct ChangeLog {
+  uint16_t calls[256];
+  uint16_t last[256];
+  uint16_t previous[256];
+};
+
+static ChangeLog changes;
+
+static void recordChange(uint8_t reg, uint16_t value, uint16_t previous, void* context) {
+  ChangeLog* log = static_cast<ChangeLog*>(context);
+  log->calls[reg]++;
+  log->last[reg] = value;
+  log->previous[reg] = previous;
+}
+
+/**
+ * @brief Poll a pack with a noisy current, a slowly sagging voltage and one load step for ten
+ * simulated minutes; only real movements reach the callbacks.
+ */
+static void test_change_detector() {
+  memset(&changes, 0, sizeof(changes));
+  ChangeDetector detector(*battery);
+  TEST_ASSERT_TRUE(detector.watch(VOLTAGE, 20, recordChange, &changes));
+  TEST_ASSERT_TRUE(detector.watch(CURRENT, 100, recordChange, &changes));
+  TEST_ASSERT_TRUE(detector.watch(TEMPERATURE, 5, recordChange, &changes));
+  TEST_ASSERT_TRUE(detector.watch(REL_STATE_OF_CHARGE, 0, recordChange, &changes));
+  TEST_ASSERT_TRUE(detector.watch(BATTERY_STATUS, 1000, recordChange, &changes));
+  TEST_ASSERT_FALSE_MESSAGE(detector.watch(DEVICE_NAME, 0, recordChange, &changes), "block registers are refused");
+  TEST_ASSERT_FALSE_MESSAGE(detector.watch(0x99, 0, recordChange, &changes), "unknown registers are refused");
+
+  uint32_t seed = 99;
+  for (int i = 0; i < 600; i++) {
+    seed = seed * 1103515245 + 12345;
+    int noise = (int)((seed >> 16) % 61) - 30;
+    int16_t current = (i < 400 ? -1250 : -3000) + noise;
+    sim->setWord(CURRENT, (uint16_t)current);
+    sim->setWord(VOLTAGE, 15840 - i / 3 - (i >= 400 ? 150 : 0));
+    sim->setWord(TEMPERATURE, 2982 + (i % 2));
+    sim->setWord(REL_STATE_OF_CHARGE, 80 - i / 60);
+    sim->setWord(BATTERY_STATUS, i < 500 ? 0x00c0 : 0x08c0);
+    detector.poll();
+  }
+  TEST_ASSERT_EQUAL_MESSAGE(2, changes.calls[CURRENT], "current jitter suppressed, load step reported");
+  TEST_ASSERT_LESS_THAN(-2900, (int16_t)changes.last[CURRENT]);
+  TEST_ASSERT_GREATER_THAN(-1300, (int16_t)changes.previous[CURRENT]);
+  TEST_ASSERT_GREATER_OR_EQUAL_MESSAGE(9, changes.calls[VOLTAGE], "voltage drift reported once per deadband");
+  TEST_ASSERT_LESS_OR_EQUAL_MESSAGE(11, changes.calls[VOLTAGE], "voltage drift reported once per deadband");
+  TEST_ASSERT_EQUAL(1, changes.calls[TEMPERATURE]);
+  TEST_ASSERT_EQUAL(10, changes.calls[REL_STATE_OF_CHARGE]);
+  TEST_ASSERT_EQUAL_MESSAGE(2, changes.calls[BATTERY_STATUS], "any status bit change reported");
+  TEST_ASSERT_EQUAL_HEX16(0x08c0, changes.last[BATTERY_STATUS]);
+  TEST_ASSERT_EQUAL_HEX16(0x00c0, changes.previous[BATTERY_STATUS]);
+  TEST_ASSERT_EQUAL_UINT32(3000, detector.samples());
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(3000 - detector.notifications(), detector.suppressed(), "detector counters");
+
+  // Snapshots from a poller feed the same filter without extra bus reads
+  BatterySnapshot snapshot;
+  TEST_ASSERT_TRUE(battery->readSnapshot(snapshot, SNAPSHOT_ESSENTIAL));
+  uint32_t calls = changes.calls[CURRENT];
+  TEST_ASSERT_EQUAL_MESSAGE(0, detector.update(snapshot), "unchanged snapshot reports nothing");
+  snapshot.current = 0;
+  snapshot.valid &= ~SNAPSHOT_VOLTAGE;
+  snapshot.voltage = 0;
+  TEST_ASSERT_EQUAL_MESSAGE(1, detector.update(snapshot), "snapshot change reported");
+  TEST_ASSERT_EQUAL(calls + 1, changes.calls[CURRENT]);
+}
+
+/**
+ * @brief Single samples, deadband edges, reset and unwatch.
+ */
+static void test_change_detector_samples() {
+  memset(&changes, 0, sizeof(changes));
+  ChangeDetector detector(*battery);
+  detector.watch(VOLTAGE, 20, recordChange, &changes);
+  TEST_ASSERT_TRUE(detector.sample(VOLTAGE, 15000));
+  TEST_ASSERT_FALSE(detector.sample(VOLTAGE, 15010));
+  TEST_ASSERT_FALSE(detector.sample(CYCLE_COUNT, 5));
+  TEST_ASSERT_TRUE(detector.unwatch(VOLTAGE));
+  TEST_ASSERT_FALSE_MESSAGE(detector.sample(VOLTAGE, 12000), "sample after unwatch");
+
+  detector.watch(VOLTAGE, 20, recordChange, &changes);
+  TEST_ASSERT_TRUE(detector.sample(VOLTAGE, 15000));
+  TEST_ASSERT_FALSE(detector.sample(VOLTAGE, 15019));
+  TEST_ASSERT_TRUE_MESSAGE(detector.sample(VOLTAGE, 15020), "a move of exactly the deadband is reported");
+  TEST_ASSERT_TRUE(detector.sample(VOLTAGE, 15000));
+  TEST_ASSERT_FALSE(detector.sample(VOLTAGE, 15000));
+  detector.setDeadband(VOLTAGE, 0);
+  TEST_ASSERT_FALSE(detector.sample(VOLTAGE, 15000));
+  TEST_ASSERT_TRUE_MESSAGE(detector.sample(VOLTAGE, 15001), "deadband 0 reports every change");
+  detector.reset();
+  TEST_ASSERT_TRUE_MESSAGE(detector.sample(VOLTAGE, 15001), "first sample after reset is reported");
+}
+
+/**
+ * @brief Run a pack through two simulated hours of rest, discharge, a load step with heating,
+ * an alarm and rest again, polling at the interval the rate controller picks.
+ */
+static void test_adaptive_poll_rate() {
+  AdaptivePollRate rate;
+  BatteryPoller poller(*battery, SNAPSHOT_ESSENTIAL);
+  poller.setRateController(&rate);
+  poller.start(POLL_RATE_MIN_MS);
+  poller.stop();
+
+  // Phases: rest, 1.25 A discharge, 3 A with the pack heating, over-temperature alarm, rest
+  const uint32_t phaseEnd[] = {1800000, 3600000, 3900000, 4000000, 7200000};
+  uint32_t polls[5] = {0};
+  uint32_t longest[5] = {0};
+  bool sawReason[8] = {false};
+  uint32_t start = millis();
+  uint32_t elapsed = 0;
+  uint32_t seed = 7;
+  while ((elapsed = millis() - start) < phaseEnd[4]) {
+    int phase = 0;
+    while (elapsed >= phaseEnd[phase]) {
+      phase++;
+    }
+    seed = seed * 1103515245 + 12345;
+    int noise = (int)((seed >> 16) % 21) - 10;
+    int16_t current = phase == 1 ? -1250 + noise : phase == 2 || phase == 3 ? -3000 + noise : noise / 4;
+    uint16_t temperature = 2982 + (phase == 2 ? (elapsed - phaseEnd[1]) / 6000 : phase == 3 ? 50 : 0);
+    sim->setWord(CURRENT, (uint16_t)current);
+    sim->setWord(TEMPERATURE, temperature);
+    sim->setWord(BATTERY_STATUS, phase == 3 ? 0x10c0 : 0x00c0);
+
+    poller.pollOnce();
+    polls[phase]++;
+    sawReason[poller.periodReason()] = true;
+    longest[phase] = poller.period() > longest[phase] ? poller.period() : longest[phase];
+    delay(poller.period());
+  }
+
+  uint32_t total = polls[0] + polls[1] + polls[2] + polls[3] + polls[4];
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(POLL_RATE_MAX_MS, longest[0], "rest backs off to the maximum interval");
+  TEST_ASSERT_LESS_THAN(80, polls[0]);
+  TEST_ASSERT_GREATER_OR_EQUAL_MESSAGE(450, longest[1], "discharge interval follows the current");
+  TEST_ASSERT_LESS_OR_EQUAL_MESSAGE(500, longest[1], "discharge interval follows the current");
+  TEST_ASSERT_GREATER_THAN(3000, polls[1]);
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(POLL_RATE_MIN_MS, longest[2], "high current and heating poll fastest");
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(POLL_RATE_MIN_MS, longest[3], "alarm polls fastest");
+  TEST_ASSERT_TRUE_MESSAGE(sawReason[POLL_REST] && sawReason[POLL_DISCHARGING] && sawReason[POLL_CURRENT_SLEW] &&
+                           sawReason[POLL_HIGH_CURRENT] && sawReason[POLL_TEMPERATURE_RISING] && sawReason[POLL_ALARM],
+                           "every reason seen");
+  TEST_ASSERT_LESS_THAN_MESSAGE(phaseEnd[4] / POLL_RATE_MIN_MS / 4, total,
+                                "adaptive rate polls far less than a fixed fast rate");
+
+  BatterySnapshot failed;
+  memset(&failed, 0, sizeof(failed));
+  uint32_t interval = rate.interval();
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(interval, rate.update(failed), "failed snapshot keeps the interval");
+  TEST_ASSERT_EQUAL(POLL_NO_DATA, rate.reason());
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_telemetry_log);
+  RUN_TEST(test_telemetry_snapshot);
+  RUN_TEST(test_telemetry_concurrent);
+  RUN_TEST(test_stream_round_trip);
+  RUN_TEST(test_stream_split_at_every_byte);
+  RUN_TEST(test_stream_recovers_at_keyframe);
+  RUN_TEST(test_change_detector);
+  RUN_TEST(test_change_detector_samples);
+  RUN_TEST(test_adaptive_poll_rate);
+  return UNITY_END();
+}
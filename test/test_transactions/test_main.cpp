@@ -0,0 +1,351 @@
+/**
+ * @file test_main.cpp
+ * @brief Turnaround, repeated START, fault and PEC handling of single transactions.
+ * @version 1.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ * Run with `pio test -e native`. Every test starts from a freshly attached simulated battery.
+ */
+
+#include <string.h>
+
+#include <Arduino.h>
+#include <Wire.h>
+#include <unity.h>
+#include "ArduinoSMBus.h"
+#include "SMBusGauge.h"
+#include "SimBattery.h"
+
+#define BATTERY_ADDRESS 0x0B
+
+static SimBattery* sim;
+static ArduinoSMBus* battery;
+
+void setUp() {
+  SimBus& bus = SimBus::instance();
+  bus.setClock(100000);
+  bus.setTransactionOverheadNanos(50000);
+  bus.clearFaults();
+  bus.resetStats();
+  Wire.setDeferredWrites(false);
+  sim = new SimBattery(BATTERY_ADDRESS);
+  sim->attach();
+  battery = new ArduinoSMBus(BATTERY_ADDRESS);
+}
+
+void tearDown() {
+  delete battery;
+  delete sim;
+}
+
+struct AsyncResult {
+  uint32_t completed;
+  uint32_t failed;
+  uint16_t lastValue;
+};
+
+static void onAsyncRead(uint8_t reg, uint16_t value, bool ok, void* context) {
+  (void)reg;
+  AsyncResult* result = static_cast<AsyncResult*>(context);
+  result->completed++;
+  result->failed += ok ? 0 : 1;
+  result->lastValue = value;
+}
+
+/**
+ * @brief Read voltage repeatedly and check every value against the simulated pack.
+ */
+static void readVoltages(uint32_t reads, const char* what) {
+  for (uint32_t i = 0; i < reads; i++) {
+    TEST_ASSERT_EQUAL_UINT16_MESSAGE(sim->word(VOLTAGE), battery->voltage(), what);
+  }
+}
+
+/**
+ * @brief A gauge that needs about 1.2 ms to prepare its data and NACKs instead of clock
+ * stretching is read correctly with the fixed and the adaptive turnaround.
+ */
+static void test_adaptive_turnaround() {
+  sim->setTurnaroundMicros(1200);
+  sim->setClockStretching(false);
+
+  battery->setTurnaround(SMBUS_TURNAROUND_MAX_US);
+  readVoltages(50, "voltage (fixed turnaround)");
+
+  battery->setTurnaround(0);
+  battery->setAdaptiveTurnaround(true);
+  readVoltages(500, "voltage (adaptive turnaround)");
+  TEST_ASSERT_GREATER_OR_EQUAL_MESSAGE(1000, battery->turnaround(), "learned turnaround");
+  TEST_ASSERT_LESS_OR_EQUAL_MESSAGE(2400, battery->turnaround(), "learned turnaround");
+
+  // The turnaround goes between the command and the repeated START, not between two transactions
+  SimBus& bus = SimBus::instance();
+  bus.resetStats();
+  TEST_ASSERT_EQUAL_UINT16(sim->word(VOLTAGE), battery->voltage());
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(2, bus.stats().transactions, "read with a turnaround is one combined transaction");
+  TEST_ASSERT_EQUAL_UINT32(1, bus.stats().repeatedStarts);
+  TEST_ASSERT_EQUAL_UINT32(1, bus.stats().stops);
+}
+
+/**
+ * @brief A combined read with a non-zero turnaround keeps its repeated START, and the
+ * battery answers it with the register that was addressed.
+ */
+static void test_combined_read_with_turnaround() {
+  sim->setTurnaroundMicros(500);
+  battery->setAdaptiveTurnaround(false);
+  battery->setTurnaround(800);
+  SimBus& bus = SimBus::instance();
+  bus.resetStats();
+  TEST_ASSERT_EQUAL_UINT16(sim->word(VOLTAGE), battery->voltage());
+  TEST_ASSERT_EQUAL_INT16((int16_t)sim->word(CURRENT), battery->current());
+  TEST_ASSERT_EQUAL_STRING("bq40z50-R2", battery->deviceName());
+  TEST_ASSERT_EQUAL_UINT32(3, bus.stats().repeatedStarts);
+  TEST_ASSERT_EQUAL_UINT32(3, bus.stats().stops);
+}
+
+/**
+ * @brief With Wire behaving as on arduino-esp32, where a write ended without a STOP is only
+ * sent by the requestFrom() that follows it, reads after a turnaround are split around it.
+ */
+static void test_deferred_writes() {
+  Wire.setDeferredWrites(true);
+  battery->setDeferredRepeatedStart(true);
+  battery->setAdaptiveTurnaround(true);
+
+  sim->setTurnaroundMicros(1000);
+  readVoltages(200, "voltage (stretched, deferred)");
+  TEST_ASSERT_EQUAL_MESSAGE(0, battery->turnaround(), "no delay before a clock-stretched combined read");
+
+  sim->setClockStretching(false);
+  sim->setTurnaroundMicros(1200);
+  readVoltages(200, "voltage (NACKing, deferred)");
+  TEST_ASSERT_GREATER_OR_EQUAL_MESSAGE(1000, battery->turnaround(), "learned turnaround (deferred)");
+  TEST_ASSERT_LESS_OR_EQUAL_MESSAGE(2400, battery->turnaround(), "learned turnaround (deferred)");
+  SimBus& bus = SimBus::instance();
+  bus.resetStats();
+  TEST_ASSERT_EQUAL_UINT16(sim->word(VOLTAGE), battery->voltage());
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(2, bus.stats().transactions, "read with a turnaround is split around it (deferred)");
+  TEST_ASSERT_EQUAL_UINT32(0, bus.stats().repeatedStarts);
+  TEST_ASSERT_EQUAL_UINT32(2, bus.stats().stops);
+}
+
+/**
+ * @brief Absent packs and rejected commands are only seen as an empty read with deferred
+ * writes; neither may raise the turnaround.
+ */
+static void test_deferred_failures_fail_fast() {
+  Wire.setDeferredWrites(true);
+  battery->setDeferredRepeatedStart(true);
+  battery->setAdaptiveTurnaround(true);
+
+  sim->detach();
+  SMBusResult result = battery->readWord(VOLTAGE);
+  sim->attach();
+  TEST_ASSERT_EQUAL_MESSAGE(SMBUS_NACK_ADDRESS, result.status, "absent pack fails fast (deferred)");
+  TEST_ASSERT_EQUAL(0, battery->turnaround());
+  result = battery->readWord(0x5a);
+  TEST_ASSERT_EQUAL_MESSAGE(SMBUS_NACK_DATA, result.status, "rejected command fails fast (deferred)");
+  TEST_ASSERT_EQUAL(0, battery->turnaround());
+  uint8_t name[32];
+  TEST_ASSERT_EQUAL_MESSAGE(SMBUS_NACK_DATA, battery->readBlock(0x5a, name, sizeof(name)).status,
+                            "rejected block command fails fast (deferred)");
+  TEST_ASSERT_EQUAL(0, battery->turnaround());
+  TEST_ASSERT_EQUAL_UINT16(sim->word(VOLTAGE), battery->voltage());
+}
+
+/**
+ * @brief A command write with STOP followed by separate read transactions reads the same
+ * register as a repeated-START combined read.
+ */
+static void test_split_read_matches_combined() {
+  sim->setTurnaroundMicros(500);
+  Wire.beginTransmission(BATTERY_ADDRESS);
+  Wire.write(VOLTAGE);
+  TEST_ASSERT_EQUAL(0, Wire.endTransmission());
+  uint8_t attempt = 0;
+  while (Wire.requestFrom(BATTERY_ADDRESS, 2) < 2 && ++attempt < 100) {
+  }
+  TEST_ASSERT_LESS_THAN(100, attempt);
+  uint16_t value = Wire.read();
+  value |= Wire.read() << 8;
+  TEST_ASSERT_EQUAL_UINT16(sim->word(VOLTAGE), value);
+  TEST_ASSERT_EQUAL_UINT16(value, battery->voltage());
+}
+
+/**
+ * @brief An absent battery is reported as such, and does not raise either turnaround.
+ */
+static void test_absent_battery() {
+  // A real 0 mA reading and a failed read are distinguishable
+  sim->setWord(CURRENT, 0);
+  SMBusResult result = battery->readWord(CURRENT);
+  TEST_ASSERT_TRUE_MESSAGE(result.ok() && result.value == 0, "0 mA read as a valid 0");
+
+  sim->detach();
+  result = battery->readWord(CURRENT);
+  TEST_ASSERT_EQUAL_MESSAGE(SMBUS_NACK_ADDRESS, result.status, "absent battery reports NACK_ADDRESS");
+  TEST_ASSERT_EQUAL_UINT16(0, result.value);
+  TEST_ASSERT_EQUAL(0, battery->current());
+  TEST_ASSERT_EQUAL_MESSAGE(SMBUS_NACK_ADDRESS, battery->lastStatus(), "lastStatus after failed getter");
+  AsyncResult async = {0, 0, 0};
+  uint16_t split = battery->splitTurnaround();
+  battery->beginRead(CURRENT, onAsyncRead, &async);
+  while (battery->poll()) {
+  }
+  TEST_ASSERT_EQUAL_UINT32(1, async.failed);
+  TEST_ASSERT_EQUAL_MESSAGE(0, battery->turnaround(), "absent battery does not raise the turnaround");
+  TEST_ASSERT_EQUAL_UINT16(split, battery->splitTurnaround());
+}
+
+/**
+ * @brief Transient faults are reported without retries and absorbed with them.
+ */
+static void test_transient_faults() {
+  SimBus& bus = SimBus::instance();
+  uint8_t name[32];
+  battery->setRetries(0);
+  bus.injectFault(SIM_FAULT_NACK_DATA);
+  TEST_ASSERT_EQUAL_MESSAGE(SMBUS_NACK_DATA, battery->readWord(VOLTAGE).status, "data NACK reported");
+  bus.injectFault(SIM_FAULT_SHORT_READ);
+  TEST_ASSERT_EQUAL_MESSAGE(SMBUS_SHORT_READ, battery->readWord(VOLTAGE).status, "short word read reported");
+  bus.injectFault(SIM_FAULT_SHORT_READ);
+  TEST_ASSERT_EQUAL_MESSAGE(SMBUS_SHORT_READ, battery->readBlock(MANUFACTURER_NAME, name, sizeof(name)).status,
+                            "short block read reported");
+
+  battery->setRetries(SMBUS_DEFAULT_RETRIES);
+  bus.injectFault(SIM_FAULT_NACK_DATA);
+  SMBusResult result = battery->readWord(VOLTAGE);
+  TEST_ASSERT_TRUE_MESSAGE(result.ok() && result.value == sim->word(VOLTAGE), "data NACK retried");
+  bus.injectFault(SIM_FAULT_SHORT_READ, 2);
+  result = battery->readBlock(MANUFACTURER_NAME, name, sizeof(name));
+  TEST_ASSERT_TRUE_MESSAGE(result.ok() && result.value == 17, "short block read retried");
+  TEST_ASSERT_EQUAL_MEMORY("Texas Instruments", name, 17);
+}
+
+/**
+ * @brief A block longer than the buffer is truncated, not taken for a battery that is not ready.
+ */
+static void test_long_block_truncated() {
+  const uint8_t subcommand[2] = {TI_MAC_DA_STATUS_1 & 0xff, TI_MAC_DA_STATUS_1 >> 8};
+  uint8_t status1[10];
+  TEST_ASSERT_EQUAL(SMBUS_OK, battery->writeBlock(MANUFACTURER_BLOCK_ACCESS, subcommand, 2));
+  SMBusResult result = battery->readBlock(MANUFACTURER_BLOCK_ACCESS, status1, sizeof(status1));
+  TEST_ASSERT_TRUE_MESSAGE(result.ok() && result.value == sizeof(status1), "34-byte block truncated to the buffer");
+  TEST_ASSERT_EQUAL_HEX8(subcommand[0], status1[0]);
+  TEST_ASSERT_EQUAL_HEX8(0, status1[1]);
+  TEST_ASSERT_EQUAL(0, battery->turnaround());
+}
+
+/**
+ * @brief A target holding SDA low is released by clocking SCL, and times out without recovery.
+ */
+static void test_stuck_bus() {
+  SimBus& bus = SimBus::instance();
+  bus.injectFault(SIM_FAULT_STUCK_SDA, 5);
+  SMBusResult result = battery->readWord(VOLTAGE);
+  TEST_ASSERT_TRUE_MESSAGE(result.ok() && result.value == sim->word(VOLTAGE), "read succeeds after bus recovery");
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(1, bus.stats().timeouts, "one timeout, then recovery");
+  TEST_ASSERT_GREATER_OR_EQUAL(5, bus.stats().recoveryClocks);
+
+  battery->setBusPins(-1, -1);
+  bus.injectFault(SIM_FAULT_STUCK_SDA, 5);
+  for (int i = 0; i < 10; i++) {
+    result = battery->readWord(VOLTAGE);
+  }
+  TEST_ASSERT_EQUAL_MESSAGE(SMBUS_TIMEOUT, result.status, "stuck bus without recovery times out");
+  battery->setBusPins(SDA, SCL);
+  TEST_ASSERT_TRUE_MESSAGE(battery->recoverBus(), "manual recovery");
+  TEST_ASSERT_TRUE_MESSAGE(battery->readWord(VOLTAGE).ok(), "read after manual recovery");
+}
+
+/**
+ * @brief Reference PEC, one bit at a time.
+ */
+static uint8_t pecBitwise(uint8_t crc, uint8_t data) {
+  crc ^= data;
+  for (int bit = 0; bit < 8; bit++) {
+    crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+  }
+  return crc;
+}
+
+/**
+ * @brief Both PEC tables match a bitwise CRC-8.
+ */
+static void test_pec_tables() {
+  bool tablesMatch = true;
+  for (int crc = 0; crc < 256; crc++) {
+    for (int data = 0; data < 256; data++) {
+      uint8_t expected = pecBitwise(crc, data);
+      tablesMatch &= smbusPecByteTable(crc, data) == expected && smbusPecByteNibble(crc, data) == expected;
+    }
+  }
+  TEST_ASSERT_TRUE_MESSAGE(tablesMatch, "PEC tables match bitwise CRC-8");
+  TEST_ASSERT_EQUAL_HEX8_MESSAGE(0xf4, smbusPec(reinterpret_cast<const uint8_t*>("123456789"), 9), "CRC-8 check value");
+}
+
+/**
+ * @brief Every read path works with PEC on a clean bus.
+ */
+static void test_reads_with_pec() {
+  sim->setPEC(true);
+  battery->enablePEC();
+  TEST_ASSERT_EQUAL_UINT16(sim->word(VOLTAGE), battery->voltage());
+  TEST_ASSERT_EQUAL_STRING_MESSAGE("bq40z50-R2", battery->deviceName(), "block read with PEC");
+  BatterySnapshot snapshot;
+  TEST_ASSERT_TRUE_MESSAGE(battery->readSnapshot(snapshot), "snapshot with PEC");
+  AsyncResult result = {0, 0, 0};
+  battery->beginRead(CURRENT, onAsyncRead, &result);
+  while (battery->poll()) {
+  }
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, result.failed, "non-blocking read with PEC");
+  TEST_ASSERT_EQUAL_UINT16(sim->word(CURRENT), result.lastValue);
+  TEST_ASSERT_EQUAL(SMBUS_OK, battery->sendCommand(TEMPERATURE));
+  TEST_ASSERT_EQUAL_UINT16_MESSAGE(sim->word(TEMPERATURE), battery->receiveWord().value, "split read with PEC");
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, battery->pecErrors(), "no PEC errors on a clean bus");
+}
+
+/**
+ * @brief Corruption is caught and counted, and retried; without PEC it goes unnoticed.
+ */
+static void test_pec_catches_corruption() {
+  SimBus& bus = SimBus::instance();
+  sim->setPEC(true);
+  battery->enablePEC();
+  battery->setRetries(0);
+  bus.injectFault(SIM_FAULT_BIT_FLIP);
+  TEST_ASSERT_EQUAL_MESSAGE(SMBUS_PEC_ERROR, battery->readWord(VOLTAGE).status, "corrupted word fails PEC");
+  bus.injectFault(SIM_FAULT_BIT_FLIP);
+  uint8_t name[32];
+  TEST_ASSERT_EQUAL_MESSAGE(SMBUS_PEC_ERROR, battery->readBlock(MANUFACTURER_NAME, name, sizeof(name)).status,
+                            "corrupted block fails PEC");
+  battery->setRetries(SMBUS_DEFAULT_RETRIES);
+  bus.injectFault(SIM_FAULT_BIT_FLIP);
+  TEST_ASSERT_EQUAL_UINT16_MESSAGE(sim->word(VOLTAGE), battery->voltage(), "voltage after PEC retry");
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(3, battery->pecErrors(), "PEC errors counted");
+
+  battery->enablePEC(false);
+  sim->setPEC(false);
+  bus.injectFault(SIM_FAULT_BIT_FLIP);
+  TEST_ASSERT_NOT_EQUAL_MESSAGE(sim->word(VOLTAGE), battery->voltage(), "corruption undetected without PEC");
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_adaptive_turnaround);
+  RUN_TEST(test_combined_read_with_turnaround);
+  RUN_TEST(test_deferred_writes);
+  RUN_TEST(test_deferred_failures_fail_fast);
+  RUN_TEST(test_split_read_matches_combined);
+  RUN_TEST(test_absent_battery);
+  RUN_TEST(test_transient_faults);
+  RUN_TEST(test_long_block_truncated);
+  RUN_TEST(test_stuck_bus);
+  RUN_TEST(test_pec_tables);
+  RUN_TEST(test_reads_with_pec);
+  RUN_TEST(test_pec_catches_corruption);
+  return UNITY_END();
+}